@@ -0,0 +1,116 @@
+//! Micro-benchmarks for the per-callback audio path and transcript cleanup.
+//!
+//! Run with `cargo bench --bench pipeline`; pass a substring to run a subset.
+
+mod support;
+
+use dikt_app_lib::audio_toolkit::audio::{AudioVisualiser, FrameResampler, ResamplerMode};
+use dikt_app_lib::audio_toolkit::vad::{SmoothedVad, VadFrame, VoiceActivityDetector};
+use dikt_app_lib::audio_toolkit::{apply_custom_words, filter_transcription_output};
+use std::hint::black_box;
+use std::time::Duration;
+use support::{synthetic_voice, Bencher};
+
+/// 10 ms of 48 kHz input, a typical device callback.
+const CALLBACK_SAMPLES: usize = 480;
+/// 30 ms at 16 kHz, the frame size the VAD sees.
+const VAD_FRAME_SAMPLES: usize = 480;
+
+/// Energy threshold stand-in for Silero, so the smoothing logic is measured
+/// without an ONNX model on disk.
+struct EnergyVad;
+
+impl VoiceActivityDetector for EnergyVad {
+    fn push_frame<'a>(&'a mut self, frame: &'a [f32]) -> anyhow::Result<VadFrame<'a>> {
+        let energy = frame.iter().map(|s| s * s).sum::<f32>() / frame.len() as f32;
+        Ok(if energy > 0.01 {
+            VadFrame::Speech(frame)
+        } else {
+            VadFrame::Noise
+        })
+    }
+}
+
+fn bench_resampler(b: &Bencher, name: &str, mode: ResamplerMode) {
+    let input = synthetic_voice(48_000, 48_000);
+    let mut resampler = FrameResampler::new(48_000, 16_000, Duration::from_millis(30), mode);
+    let mut blocks = input.chunks_exact(CALLBACK_SAMPLES).cycle();
+    b.run(name, || {
+        let mut frames = 0usize;
+        resampler.push(blocks.next().unwrap(), |frame| {
+            frames += black_box(frame).len();
+        });
+        frames
+    });
+}
+
+fn bench_vad(b: &Bencher) {
+    let input = synthetic_voice(16_000, 16_000 * 3);
+    let mut vad = SmoothedVad::new(Box::new(EnergyVad), 15, 15, 2);
+    let mut frames = input.chunks_exact(VAD_FRAME_SAMPLES).cycle();
+    b.run("vad/smoothed_push_frame", || {
+        vad.push_frame(frames.next().unwrap())
+            .map(|frame| frame.is_speech())
+            .unwrap_or(false)
+    });
+}
+
+fn bench_visualiser(b: &Bencher) {
+    let input = synthetic_voice(48_000, 48_000);
+    let mut visualiser = AudioVisualiser::new(48_000, 512, 16, 400.0, 4000.0);
+    visualiser.set_update_rate(30);
+    let mut blocks = input.chunks_exact(CALLBACK_SAMPLES).cycle();
+    b.run("visualiser/feed_30hz", || {
+        visualiser
+            .feed(blocks.next().unwrap())
+            .map(|levels| levels.len())
+    });
+}
+
+fn bench_text(b: &Bencher) {
+    let transcript = "um so I was talking to jon about the kubernets cluster and uh \
+        the postgress migration, like, we need the grafana dashbord before \
+        thursday and also the rust analyser config for the dikt repo period \
+        so yeah let's sync with maria about the tensor flow stuff tomorrow";
+    let custom_words: Vec<String> = [
+        "Kubernetes",
+        "PostgreSQL",
+        "Grafana",
+        "dashboard",
+        "rust-analyzer",
+        "Dikt",
+        "TensorFlow",
+        "Jon",
+        "Maria",
+        "Wayland",
+        "PipeWire",
+        "GNOME",
+        "IBus",
+        "Whisper",
+        "Parakeet",
+        "SenseVoice",
+    ]
+    .iter()
+    .map(|word| word.to_string())
+    .collect();
+
+    b.run("text/apply_custom_words", || {
+        apply_custom_words(transcript, &custom_words, 0.18)
+    });
+    b.run("text/filter_transcription_output", || {
+        filter_transcription_output(transcript)
+    });
+}
+
+fn main() {
+    let b = Bencher::from_args();
+    bench_resampler(&b, "resampler/quality_48k_to_16k", ResamplerMode::Quality);
+    bench_resampler(
+        &b,
+        "resampler/low_latency_48k_to_16k",
+        ResamplerMode::LowLatency,
+    );
+    bench_vad(&b);
+    bench_visualiser(&b);
+    bench_text(&b);
+}
@@ -0,0 +1,232 @@
+//! End-to-end replay of a WAV corpus through capture and transcription.
+//!
+//! Each file is fed through `AudioRecorder::replay`, which drives the same
+//! ring, resampler and VAD as the microphone, then decoded with
+//! `TranscriptionManager::transcribe`. Reports per model: load time,
+//! real-time factor (decode time / speech duration), p50/p99 stop-to-text
+//! latency and peak RSS.
+//!
+//!     DIKT_BENCH_CORPUS=~/corpus DIKT_BENCH_MODELS=turbo,parakeet-tdt-0.6b-v3 \
+//!         cargo bench --bench replay
+//!
+//! `DIKT_BENCH_MODELS` defaults to every downloaded model. Settings are kept
+//! in memory so the run never touches the user's configuration.
+
+mod support;
+
+use dikt_app_lib::audio_toolkit::vad::SmoothedVad;
+use dikt_app_lib::audio_toolkit::{AudioRecorder, SileroVad};
+use dikt_app_lib::managers::audio::resolve_vad_model_path;
+use dikt_app_lib::managers::model::ModelManager;
+use dikt_app_lib::managers::transcription::TranscriptionManager;
+use dikt_app_lib::settings::Settings;
+use std::path::{Path, PathBuf};
+use std::sync::Arc;
+use std::time::{Duration, Instant};
+use support::{format_duration, percentile};
+
+/// 10 ms callbacks at the file's own rate, like a typical capture device.
+const CALLBACK_MS: u32 = 10;
+
+struct Clip {
+    name: String,
+    interleaved: Vec<f32>,
+    sample_rate: u32,
+    channels: usize,
+}
+
+impl Clip {
+    fn load(path: &Path) -> Result<Self, hound::Error> {
+        let mut reader = hound::WavReader::open(path)?;
+        let spec = reader.spec();
+        let interleaved = match spec.sample_format {
+            hound::SampleFormat::Float => reader.samples::<f32>().collect::<Result<_, _>>()?,
+            hound::SampleFormat::Int => {
+                let scale = 1.0 / (1u64 << (spec.bits_per_sample - 1)) as f32;
+                reader
+                    .samples::<i32>()
+                    .map(|s| s.map(|s| s as f32 * scale))
+                    .collect::<Result<_, _>>()?
+            }
+        };
+        Ok(Self {
+            name: path
+                .file_name()
+                .unwrap_or_default()
+                .to_string_lossy()
+                .into(),
+            interleaved,
+            sample_rate: spec.sample_rate,
+            channels: usize::from(spec.channels),
+        })
+    }
+
+    fn duration(&self) -> Duration {
+        let frames = self.interleaved.len() / self.channels.max(1);
+        Duration::from_secs_f64(frames as f64 / f64::from(self.sample_rate))
+    }
+}
+
+fn load_corpus(dir: &Path) -> Vec<Clip> {
+    let mut paths: Vec<PathBuf> = std::fs::read_dir(dir)
+        .map(|entries| {
+            entries
+                .filter_map(|entry| entry.ok().map(|entry| entry.path()))
+                .filter(|path| path.extension().is_some_and(|ext| ext == "wav"))
+                .collect()
+        })
+        .unwrap_or_default();
+    paths.sort();
+    paths
+        .iter()
+        .filter_map(|path| match Clip::load(path) {
+            Ok(clip) => Some(clip),
+            Err(e) => {
+                eprintln!("skipping {}: {}", path.display(), e);
+                None
+            }
+        })
+        .collect()
+}
+
+fn recorder() -> AudioRecorder {
+    let recorder = AudioRecorder::new().expect("recorder");
+    let Some(vad_path) = resolve_vad_model_path() else {
+        eprintln!("Silero VAD model not found; replaying without VAD");
+        return recorder;
+    };
+    match SileroVad::new(&vad_path, 0.3) {
+        // Same tuning as the daemon's recorder.
+        Ok(silero) => recorder.with_vad(Box::new(SmoothedVad::new(
+            Box::new(silero.with_frames_per_call(Settings::new().vad_frames_per_call() as usize)),
+            15,
+            15,
+            2,
+        ))),
+        Err(e) => {
+            eprintln!("Failed to load Silero VAD ({}); replaying without VAD", e);
+            recorder
+        }
+    }
+}
+
+/// Peak resident set since the last `reset_peak_rss`, in MiB.
+fn peak_rss_mib() -> Option<f64> {
+    let status = std::fs::read_to_string("/proc/self/status").ok()?;
+    let line = status.lines().find(|line| line.starts_with("VmHWM:"))?;
+    let kib: f64 = line.split_whitespace().nth(1)?.parse().ok()?;
+    Some(kib / 1024.0)
+}
+
+fn reset_peak_rss() {
+    // "5" resets VmHWM to the current RSS (Linux 4.0+).
+    let _ = std::fs::write("/proc/self/clear_refs", "5");
+}
+
+fn main() {
+    let Some(corpus_dir) = std::env::var_os("DIKT_BENCH_CORPUS") else {
+        println!("replay: set DIKT_BENCH_CORPUS to a directory of .wav files to run");
+        return;
+    };
+    if std::env::var_os("GSETTINGS_SCHEMA_DIR").is_none() {
+        std::env::set_var(
+            "GSETTINGS_SCHEMA_DIR",
+            concat!(env!("CARGO_MANIFEST_DIR"), "/data"),
+        );
+    }
+    std::env::set_var("GSETTINGS_BACKEND", "memory");
+
+    let corpus = load_corpus(Path::new(&corpus_dir));
+    if corpus.is_empty() {
+        println!("replay: no readable .wav files in {:?}", corpus_dir);
+        return;
+    }
+    let speech: Duration = corpus.iter().map(Clip::duration).sum();
+    println!(
+        "replay: {} clips, {:.1} s of audio",
+        corpus.len(),
+        speech.as_secs_f64()
+    );
+
+    let model_manager = Arc::new(ModelManager::new().expect("model manager"));
+    let models: Vec<String> = match std::env::var("DIKT_BENCH_MODELS") {
+        Ok(list) => list.split(',').map(|id| id.trim().to_string()).collect(),
+        Err(_) => {
+            let mut ids: Vec<String> = model_manager
+                .get_available_models()
+                .into_iter()
+                .filter(|model| model.is_downloaded)
+                .map(|model| model.id)
+                .collect();
+            ids.sort();
+            ids
+        }
+    };
+    if models.is_empty() {
+        println!("replay: no downloaded models to benchmark");
+        return;
+    }
+    let transcription =
+        TranscriptionManager::new(model_manager.clone()).expect("transcription manager");
+    let mut recorder = recorder();
+
+    println!(
+        "{:<28} {:>10} {:>8} {:>12} {:>12} {:>10}",
+        "model", "load", "rtf", "p50", "p99", "peak rss"
+    );
+    for model_id in &models {
+        if let Err(e) = model_manager.set_active_model(model_id) {
+            eprintln!("{}: {}", model_id, e);
+            continue;
+        }
+        let _ = transcription.unload_model();
+        reset_peak_rss();
+
+        let load_started = Instant::now();
+        if let Err(e) = transcription.load_model(model_id) {
+            eprintln!("{}: {}", model_id, e);
+            continue;
+        }
+        let load_time = load_started.elapsed();
+
+        let mut latencies = Vec::with_capacity(corpus.len());
+        let mut decode_total = Duration::ZERO;
+        for clip in &corpus {
+            let block_frames = (clip.sample_rate * CALLBACK_MS / 1000) as usize;
+            let samples = match recorder.replay(
+                &clip.interleaved,
+                clip.sample_rate,
+                clip.channels,
+                block_frames,
+            ) {
+                Ok(samples) => samples,
+                Err(e) => {
+                    eprintln!("{} / {}: replay failed: {}", model_id, clip.name, e);
+                    continue;
+                }
+            };
+            let started = Instant::now();
+            if let Err(e) = transcription.transcribe(samples) {
+                eprintln!("{} / {}: transcription failed: {}", model_id, clip.name, e);
+                continue;
+            }
+            let elapsed = started.elapsed();
+            decode_total += elapsed;
+            latencies.push(elapsed);
+        }
+        latencies.sort();
+
+        println!(
+            "{:<28} {:>10} {:>8.3} {:>12} {:>12} {:>10}",
+            model_id,
+            format_duration(load_time),
+            decode_total.as_secs_f64() / speech.as_secs_f64(),
+            format_duration(percentile(&latencies, 0.50)),
+            format_duration(percentile(&latencies, 0.99)),
+            peak_rss_mib()
+                .map(|mib| format!("{:.0} MiB", mib))
+                .unwrap_or_else(|| "n/a".to_string()),
+        );
+    }
+    let _ = transcription.unload_model();
+}
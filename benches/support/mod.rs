@@ -0,0 +1,105 @@
+//! Minimal timing harness shared by the bench targets, so they need no
+//! dependencies beyond the crate's own.
+
+// Each bench target uses a different subset.
+#![allow(dead_code)]
+
+use std::hint::black_box;
+use std::time::{Duration, Instant};
+
+const WARM_UP: Duration = Duration::from_millis(200);
+const SAMPLE_TARGET: Duration = Duration::from_millis(10);
+const SAMPLES: usize = 40;
+
+/// Name filter from the command line: `cargo bench --bench pipeline -- vad`.
+pub fn filter() -> Option<String> {
+    std::env::args().skip(1).find(|arg| !arg.starts_with('-'))
+}
+
+pub struct Bencher {
+    filter: Option<String>,
+}
+
+impl Bencher {
+    pub fn from_args() -> Self {
+        println!(
+            "{:<40} {:>12} {:>12} {:>12}",
+            "benchmark", "median", "min", "max"
+        );
+        Self { filter: filter() }
+    }
+
+    /// Times `routine` and prints per-call statistics. Iterations per sample
+    /// are scaled so each sample runs for roughly `SAMPLE_TARGET`.
+    pub fn run<T>(&self, name: &str, mut routine: impl FnMut() -> T) {
+        if self.filter.as_deref().is_some_and(|f| !name.contains(f)) {
+            return;
+        }
+
+        let started = Instant::now();
+        let mut warm_up_iters = 0u64;
+        while started.elapsed() < WARM_UP {
+            black_box(routine());
+            warm_up_iters += 1;
+        }
+        let per_iter = started.elapsed() / warm_up_iters.max(1) as u32;
+        let iters = (SAMPLE_TARGET.as_nanos() / per_iter.as_nanos().max(1)).max(1) as u32;
+
+        let mut samples: Vec<Duration> = (0..SAMPLES)
+            .map(|_| {
+                let start = Instant::now();
+                for _ in 0..iters {
+                    black_box(routine());
+                }
+                start.elapsed() / iters
+            })
+            .collect();
+        samples.sort();
+
+        println!(
+            "{:<40} {:>12} {:>12} {:>12}",
+            name,
+            format_duration(samples[SAMPLES / 2]),
+            format_duration(samples[0]),
+            format_duration(samples[SAMPLES - 1])
+        );
+    }
+}
+
+pub fn format_duration(duration: Duration) -> String {
+    let nanos = duration.as_nanos();
+    if nanos < 10_000 {
+        format!("{} ns", nanos)
+    } else if nanos < 10_000_000 {
+        format!("{:.2} us", nanos as f64 / 1e3)
+    } else {
+        format!("{:.2} ms", nanos as f64 / 1e6)
+    }
+}
+
+/// Value at `quantile` (0.0..=1.0) of an ascending slice.
+pub fn percentile(sorted: &[Duration], quantile: f64) -> Duration {
+    if sorted.is_empty() {
+        return Duration::ZERO;
+    }
+    let rank = (quantile * (sorted.len() - 1) as f64).round() as usize;
+    sorted[rank.min(sorted.len() - 1)]
+}
+
+/// Deterministic voice-like test signal: a few harmonics with a slow
+/// amplitude envelope, so VAD and spectrum code see varied input.
+pub fn synthetic_voice(sample_rate: u32, samples: usize) -> Vec<f32> {
+    let rate = sample_rate as f32;
+    (0..samples)
+        .map(|i| {
+            let t = i as f32 / rate;
+            let envelope = 0.5 + 0.5 * (2.0 * std::f32::consts::PI * 1.5 * t).sin();
+            let tone: f32 = [180.0f32, 360.0, 720.0, 1440.0]
+                .iter()
+                .enumerate()
+                .map(|(k, hz)| (2.0 * std::f32::consts::PI * hz * t).sin() / (k + 1) as f32)
+                .sum();
+            0.3 * envelope * tone
+        })
+        .collect()
+}
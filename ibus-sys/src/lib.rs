@@ -174,6 +174,18 @@ extern "C" {
     pub fn ibus_dikt_daemon_set_global_engine(engine_name: *const gchar) -> gboolean;
     pub fn ibus_dikt_daemon_get_global_engine_name() -> *mut gchar;
     pub fn ibus_dikt_daemon_reset_bus_cache();
+    pub fn ibus_dikt_daemon_wait_global_engine_change(
+        generation: *mut u64,
+        timeout_ms: c_int,
+    ) -> *mut gchar;
+    pub fn ibus_dikt_engine_apply_updates(
+        engine: *mut IBusEngine,
+        preedit: *const gchar,
+        cursor_pos: guint,
+        visible: gboolean,
+        commit: *const gchar,
+    );
+    pub fn ibus_dikt_engine_invalidate_preedit(engine: *mut IBusEngine);
 }
 
 pub mod keys {
@@ -22,6 +22,8 @@ static IBusBus *global_bus = NULL;
 static IBusFactory *global_factory = NULL;
 
 #define IBUS_TYPE_DIKT_ENGINE (ibus_dikt_engine_get_type())
+#define IBUS_IS_DIKT_ENGINE(obj)                                               \
+  (G_TYPE_CHECK_INSTANCE_TYPE((obj), IBUS_TYPE_DIKT_ENGINE))
 
 GType ibus_dikt_engine_get_type(void);
 
@@ -59,9 +61,15 @@ static void ibus_dikt_engine_class_init(IBusDiktEngineClass *klass) {
   engine_class->disable = ibus_dikt_engine_disable;
 }
 
-static void ibus_dikt_engine_init(IBusDiktEngine *engine) { (void)engine; }
+static void ibus_dikt_engine_init(IBusDiktEngine *engine) {
+  engine->preedit_text = NULL;
+  engine->preedit_cursor = 0;
+  engine->preedit_visible = FALSE;
+  engine->preedit_known = FALSE;
+}
 
 static void ibus_dikt_engine_destroy(IBusDiktEngine *engine) {
+  g_clear_object(&engine->preedit_text);
   ((IBusObjectClass *)ibus_dikt_engine_parent_class)
       ->destroy((IBusObject *)engine);
 }
@@ -77,35 +85,103 @@ static gboolean ibus_dikt_engine_process_key_event(IBusEngine *engine,
 }
 
 static void ibus_dikt_engine_focus_in(IBusEngine *engine) {
+  ibus_dikt_engine_invalidate_preedit(engine);
   if (global_focus_in_cb && global_context) {
     global_focus_in_cb(global_context, engine);
   }
 }
 
 static void ibus_dikt_engine_focus_out(IBusEngine *engine) {
+  ibus_dikt_engine_invalidate_preedit(engine);
   if (global_focus_out_cb && global_context) {
     global_focus_out_cb(global_context, engine);
   }
 }
 
 static void ibus_dikt_engine_reset(IBusEngine *engine) {
+  ibus_dikt_engine_invalidate_preedit(engine);
   if (global_reset_cb && global_context) {
     global_reset_cb(global_context, engine);
   }
 }
 
 static void ibus_dikt_engine_enable(IBusEngine *engine) {
+  ibus_dikt_engine_invalidate_preedit(engine);
   if (global_enable_cb && global_context) {
     global_enable_cb(global_context, engine);
   }
 }
 
 static void ibus_dikt_engine_disable(IBusEngine *engine) {
+  ibus_dikt_engine_invalidate_preedit(engine);
   if (global_disable_cb && global_context) {
     global_disable_cb(global_context, engine);
   }
 }
 
+void ibus_dikt_engine_invalidate_preedit(IBusEngine *engine) {
+  if (IBUS_IS_DIKT_ENGINE(engine)) {
+    ((IBusDiktEngine *)engine)->preedit_known = FALSE;
+  }
+}
+
+static void ibus_dikt_engine_hide_preedit_cached(IBusEngine *engine,
+                                                 IBusDiktEngine *dikt) {
+  if (dikt && dikt->preedit_known && !dikt->preedit_visible) {
+    return;
+  }
+  ibus_engine_hide_preedit_text(engine);
+  if (dikt) {
+    dikt->preedit_visible = FALSE;
+    dikt->preedit_known = TRUE;
+  }
+}
+
+void ibus_dikt_engine_apply_updates(IBusEngine *engine, const gchar *preedit,
+                                    guint cursor_pos, gboolean visible,
+                                    const gchar *commit) {
+  g_return_if_fail(IBUS_IS_ENGINE(engine));
+  IBusDiktEngine *dikt =
+      IBUS_IS_DIKT_ENGINE(engine) ? (IBusDiktEngine *)engine : NULL;
+
+  if (commit && *commit) {
+    ibus_dikt_engine_hide_preedit_cached(engine, dikt);
+    ibus_engine_commit_text(engine, ibus_text_new_from_string(commit));
+  }
+
+  if (!visible || !preedit || !*preedit) {
+    ibus_dikt_engine_hide_preedit_cached(engine, dikt);
+    return;
+  }
+
+  if (!dikt) {
+    ibus_engine_update_preedit_text(engine, ibus_text_new_from_string(preedit),
+                                    cursor_pos, TRUE);
+    return;
+  }
+
+  gboolean same_text =
+      dikt->preedit_text &&
+      g_strcmp0(ibus_text_get_text(dikt->preedit_text), preedit) == 0;
+  if (same_text && dikt->preedit_known && dikt->preedit_visible &&
+      dikt->preedit_cursor == cursor_pos) {
+    return;
+  }
+
+  if (!same_text) {
+    g_clear_object(&dikt->preedit_text);
+    dikt->preedit_text = g_object_ref_sink(ibus_text_new_from_string(preedit));
+  }
+  /* The text is not floating, so IBus serializes it without taking it over
+   * and it can be re-sent after the next focus change. Updating with
+   * visible = TRUE also shows the preedit; no separate show call is needed. */
+  ibus_engine_update_preedit_text(engine, dikt->preedit_text, cursor_pos,
+                                  TRUE);
+  dikt->preedit_cursor = cursor_pos;
+  dikt->preedit_visible = TRUE;
+  dikt->preedit_known = TRUE;
+}
+
 static void ibus_disconnected_cb(IBusBus *bus, gpointer user_data) {
   (void)bus;
   (void)user_data;
@@ -228,11 +304,61 @@ gchar *ibus_dikt_get_global_engine_name(void) {
 static gsize daemon_ibus_initialized = 0;
 static IBusBus *daemon_cached_bus = NULL;
 
+/* Global engine name as last reported by IBus, kept current by the
+ * "global-engine-changed" signal so reads and switch confirmation need no
+ * round trip. The signal is dispatched by the main loop of the default
+ * context; until one has been delivered, reads fall back to asking IBus. */
+static GMutex daemon_engine_lock;
+static GCond daemon_engine_cond;
+static gchar *daemon_engine_name = NULL;
+static guint64 daemon_engine_generation = 0;
+static gboolean daemon_engine_signals_live = FALSE;
+
+static void daemon_engine_cache_store(const gchar *name, gboolean from_signal) {
+  g_mutex_lock(&daemon_engine_lock);
+  if (g_strcmp0(daemon_engine_name, name) != 0) {
+    g_free(daemon_engine_name);
+    daemon_engine_name = g_strdup(name);
+    daemon_engine_generation++;
+  }
+  if (from_signal) {
+    daemon_engine_signals_live = TRUE;
+  }
+  g_cond_broadcast(&daemon_engine_cond);
+  g_mutex_unlock(&daemon_engine_lock);
+}
+
+static void daemon_engine_cache_invalidate(void) {
+  g_mutex_lock(&daemon_engine_lock);
+  g_clear_pointer(&daemon_engine_name, g_free);
+  daemon_engine_generation++;
+  daemon_engine_signals_live = FALSE;
+  g_cond_broadcast(&daemon_engine_cond);
+  g_mutex_unlock(&daemon_engine_lock);
+}
+
+static void daemon_global_engine_changed_cb(IBusBus *bus,
+                                            const gchar *engine_name,
+                                            gpointer user_data) {
+  (void)bus;
+  (void)user_data;
+  daemon_engine_cache_store(engine_name, TRUE);
+}
+
+static void daemon_disconnected_cb(IBusBus *bus, gpointer user_data) {
+  (void)bus;
+  (void)user_data;
+  daemon_engine_cache_invalidate();
+}
+
 void ibus_dikt_daemon_reset_bus_cache(void) {
   if (daemon_cached_bus) {
+    g_signal_handlers_disconnect_by_data(daemon_cached_bus,
+                                         &daemon_engine_lock);
     g_object_unref(daemon_cached_bus);
     daemon_cached_bus = NULL;
   }
+  daemon_engine_cache_invalidate();
 }
 
 /* Return a persistent, cached IBusBus for the daemon process.
@@ -259,6 +385,14 @@ static IBusBus *ibus_dikt_daemon_get_bus(void) {
     return NULL;
   }
 
+  /* The lock's address tags our handlers so a reset can disconnect them. */
+  ibus_bus_set_watch_ibus_signal(daemon_cached_bus, TRUE);
+  g_signal_connect(daemon_cached_bus, "global-engine-changed",
+                   G_CALLBACK(daemon_global_engine_changed_cb),
+                   &daemon_engine_lock);
+  g_signal_connect(daemon_cached_bus, "disconnected",
+                   G_CALLBACK(daemon_disconnected_cb), &daemon_engine_lock);
+
   return daemon_cached_bus;
 }
 
@@ -275,19 +409,57 @@ gboolean ibus_dikt_daemon_set_global_engine(const gchar *engine_name) {
   return ibus_bus_set_global_engine(bus, engine_name);
 }
 
+static gchar *daemon_query_global_engine_name(IBusBus *bus) {
+  IBusEngineDesc *desc = ibus_bus_get_global_engine(bus);
+  if (!desc) {
+    return NULL;
+  }
+
+  const gchar *name = ibus_engine_desc_get_name(desc);
+  gchar *result = name ? g_strdup(name) : NULL;
+  g_object_unref(desc);
+  return result;
+}
+
 gchar *ibus_dikt_daemon_get_global_engine_name(void) {
   IBusBus *bus = ibus_dikt_daemon_get_bus();
   if (!bus) {
     return NULL;
   }
 
-  IBusEngineDesc *desc = ibus_bus_get_global_engine(bus);
-  if (!desc) {
+  g_mutex_lock(&daemon_engine_lock);
+  gchar *cached = daemon_engine_signals_live && daemon_engine_name
+                      ? g_strdup(daemon_engine_name)
+                      : NULL;
+  g_mutex_unlock(&daemon_engine_lock);
+  if (cached) {
+    return cached;
+  }
+
+  gchar *result = daemon_query_global_engine_name(bus);
+  if (result) {
+    daemon_engine_cache_store(result, FALSE);
+  }
+  return result;
+}
+
+gchar *ibus_dikt_daemon_wait_global_engine_change(guint64 *generation,
+                                                  gint timeout_ms) {
+  if (!ibus_dikt_daemon_get_bus()) {
     return NULL;
   }
 
-  const gchar *name = ibus_engine_desc_get_name(desc);
-  gchar *result = name ? g_strdup(name) : NULL;
-  g_object_unref(desc);
+  gint64 deadline = g_get_monotonic_time() +
+                    (gint64)MAX(timeout_ms, 0) * G_TIME_SPAN_MILLISECOND;
+  g_mutex_lock(&daemon_engine_lock);
+  while (daemon_engine_generation == *generation) {
+    if (!g_cond_wait_until(&daemon_engine_cond, &daemon_engine_lock,
+                           deadline)) {
+      break;
+    }
+  }
+  *generation = daemon_engine_generation;
+  gchar *result = g_strdup(daemon_engine_name);
+  g_mutex_unlock(&daemon_engine_lock);
   return result;
 }
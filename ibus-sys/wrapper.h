@@ -32,9 +32,31 @@ gchar* ibus_dikt_get_global_engine_name(void);
 gboolean ibus_dikt_daemon_set_global_engine(const gchar* engine_name);
 gchar* ibus_dikt_daemon_get_global_engine_name(void);
 void ibus_dikt_daemon_reset_bus_cache(void);
+/* Blocks until the cached global engine differs from *generation or
+ * timeout_ms passes, then stores the current generation in *generation and
+ * returns a copy of the cached name (NULL if unknown). Start from generation
+ * 0 to read the cache without waiting once anything has been cached. */
+gchar* ibus_dikt_daemon_wait_global_engine_change(guint64* generation, gint timeout_ms);
+
+/* Applies one batch of UI updates on the main thread: an optional commit
+ * (the preedit is hidden first), then the preedit state. A NULL or empty
+ * preedit, or visible == FALSE, hides it. Updates matching what was last sent
+ * to the client are skipped. */
+void ibus_dikt_engine_apply_updates(IBusEngine* engine, const gchar* preedit,
+                                    guint cursor_pos, gboolean visible,
+                                    const gchar* commit);
+/* Forgets the cached client preedit state so the next update is always sent. */
+void ibus_dikt_engine_invalidate_preedit(IBusEngine* engine);
 
 typedef struct {
     IBusEngine parent;
+    /* Last preedit sent to the client, sunk so it can be re-sent as is. */
+    IBusText* preedit_text;
+    guint preedit_cursor;
+    gboolean preedit_visible;
+    /* FALSE when the client may have changed its preedit on its own
+     * (focus change, reset), so the cache above cannot be trusted. */
+    gboolean preedit_known;
 } IBusDiktEngine;
 
 #ifdef __cplusplus
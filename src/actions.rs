@@ -31,7 +31,7 @@ pub async fn perform_transcription(
     );
 
     let transcription = transcription_manager
-        .transcribe(samples.clone())
+        .transcribe(samples)
         .map_err(|e| format!("Transcription failed: {}", e))?;
 
     let lang = settings.selected_language();
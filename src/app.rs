@@ -2,12 +2,14 @@ use gtk4::prelude::*;
 use libadwaita::Application as AdwApplication;
 use std::sync::{Arc, Mutex};
 
+use crate::audio_feedback::prepare_feedback_sounds;
 use crate::dbus::{self, DiktState};
 use crate::global_shortcuts::{is_restricted_session_context, start_global_shortcuts_listener};
 use crate::managers::audio::AudioRecordingManager;
 use crate::managers::model::ModelManager;
-use crate::managers::transcription::TranscriptionManager;
-use crate::settings::{LogLevel, Settings};
+use crate::managers::transcription::{TranscriptionConfig, TranscriptionManager};
+use crate::settings::{subscribe_settings, watch_settings_snapshot, LogLevel, Settings};
+use crate::text_utils::preload_chinese_converter;
 use crate::ui::window::MainWindow;
 
 const UI_APP_ID: &str = "io.dikt.Dikt";
@@ -74,6 +76,9 @@ fn init_ui_state() -> Result<Arc<AppState>, String> {
 fn init_runtime() -> Result<(Arc<RuntimeState>, Arc<DiktState>), String> {
     let settings = Settings::new();
     let log_buffer = init_logging(&settings);
+    // Before anything reads the snapshot or connects its own change handlers.
+    watch_settings_snapshot(&settings);
+    AudioRecordingManager::recover_interrupted_recordings();
 
     let recording_manager = Arc::new(
         AudioRecordingManager::new()
@@ -103,6 +108,8 @@ fn init_runtime() -> Result<(Arc<RuntimeState>, Arc<DiktState>), String> {
     ));
 
     wire_settings_sync(&state, &dikt_state);
+    preload_chinese_converter(&state.settings.selected_language());
+    prepare_feedback_sounds(&state.settings);
 
     Ok((state, dikt_state))
 }
@@ -111,80 +118,65 @@ fn wire_settings_sync(state: &Arc<RuntimeState>, dikt_state: &Arc<DiktState>) {
     state.settings.connect_changed(Some("selected-language"), {
         let settings = state.settings.clone();
         let dikt_state = dikt_state.clone();
-        let tm = state.transcription_manager.clone();
         move |_| {
+            let language = settings.selected_language();
+            preload_chinese_converter(&language);
             match dikt_state.selected_language.lock() {
                 Ok(mut selected_language) => {
-                    *selected_language = settings.selected_language();
+                    *selected_language = language;
                 }
                 Err(e) => {
                     log::error!("Failed to update selected language from settings: {}", e);
                 }
             }
-            tm.refresh_config_from_settings(&settings);
         }
     });
 
-    state
-        .settings
-        .connect_changed(Some("translate-to-english"), {
-            let settings = state.settings.clone();
-            let tm = state.transcription_manager.clone();
-            move |_| {
-                tm.refresh_config_from_settings(&settings);
-            }
-        });
+    subscribe_settings(TranscriptionConfig::KEYS, {
+        let tm = state.transcription_manager.clone();
+        move |snapshot| tm.apply_settings(snapshot)
+    });
 
-    state.settings.connect_changed(Some("custom-words"), {
-        let settings = state.settings.clone();
+    state.settings.connect_changed(Some("selected-model"), {
+        let model_manager = state.model_manager.clone();
         let tm = state.transcription_manager.clone();
         move |_| {
-            tm.refresh_config_from_settings(&settings);
+            if let Err(e) = model_manager.sync_selected_model_from_settings() {
+                log::error!("Failed to sync selected model from settings: {}", e);
+            }
+            if let Err(e) = tm.unload_model() {
+                log::error!("Failed to unload model after model selection change: {}", e);
+            }
         }
     });
 
     state
         .settings
-        .connect_changed(Some("word-correction-threshold"), {
+        .connect_changed(Some("mute-while-recording"), {
             let settings = state.settings.clone();
-            let tm = state.transcription_manager.clone();
+            let recording_manager = state.recording_manager.clone();
             move |_| {
-                tm.refresh_config_from_settings(&settings);
+                recording_manager.set_mute_while_recording(settings.mute_while_recording());
             }
         });
 
     state
         .settings
-        .connect_changed(Some("model-unload-timeout"), {
+        .connect_changed(Some("low-latency-resampler"), {
             let settings = state.settings.clone();
-            let tm = state.transcription_manager.clone();
+            let recording_manager = state.recording_manager.clone();
             move |_| {
-                tm.refresh_config_from_settings(&settings);
+                recording_manager.set_low_latency_resampler(settings.low_latency_resampler());
             }
         });
 
-    state.settings.connect_changed(Some("selected-model"), {
-        let settings = state.settings.clone();
-        let model_manager = state.model_manager.clone();
-        let tm = state.transcription_manager.clone();
-        move |_| {
-            if let Err(e) = model_manager.sync_selected_model_from_settings() {
-                log::error!("Failed to sync selected model from settings: {}", e);
-            }
-            if let Err(e) = tm.unload_model() {
-                log::error!("Failed to unload model after model selection change: {}", e);
-            }
-            tm.refresh_config_from_settings(&settings);
-        }
-    });
-
     state
         .settings
-        .connect_changed(Some("mute-while-recording"), {
+        .connect_changed(Some("spill-long-recordings"), {
             let settings = state.settings.clone();
             let recording_manager = state.recording_manager.clone();
             move |_| {
-                recording_manager.set_mute_while_recording(settings.mute_while_recording());
+                recording_manager.set_spill_long_recordings(settings.spill_long_recordings());
             }
         });
 
@@ -222,7 +214,7 @@ fn wire_settings_sync(state: &Arc<RuntimeState>, dikt_state: &Arc<DiktState>) {
         move |_| {
             let enabled = settings.audio_feedback();
             log::info!("Audio feedback setting changed to: {}", enabled);
-            // Audio feedback is read on-demand during playback
+            prepare_feedback_sounds(&settings);
         }
     });
 
@@ -242,10 +234,19 @@ fn wire_settings_sync(state: &Arc<RuntimeState>, dikt_state: &Arc<DiktState>) {
         move |_| {
             let theme = settings.sound_theme();
             log::info!("Sound theme changed to: {:?}", theme);
-            // Sound theme is read on-demand during playback
+            prepare_feedback_sounds(&settings);
         }
     });
 
+    state
+        .settings
+        .connect_changed(Some("selected-output-device"), {
+            let settings = state.settings.clone();
+            move |_| {
+                prepare_feedback_sounds(&settings);
+            }
+        });
+
     state.settings.connect_changed(Some("log-level"), {
         let settings = state.settings.clone();
         move |_| {
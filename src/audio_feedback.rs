@@ -1,18 +1,270 @@
-use crate::settings::{Settings, SoundTheme};
+//! Start/stop feedback cues.
+//!
+//! One long-lived player thread keeps an output stream open and the theme's
+//! clips decoded in memory, so a cue on the recording path is a channel send
+//! rather than a device open, a file decode and a thread spawn.
+
+use crate::settings::{Settings, SettingsSnapshot, SoundTheme};
 use log::{debug, error, warn};
-use rodio::{OutputStream, Sink};
+use rodio::{OutputStream, OutputStreamHandle, Sink, Source};
+use std::collections::HashMap;
 use std::fs::File;
 use std::io::BufReader;
 use std::path::{Path, PathBuf};
+use std::sync::{mpsc, Arc, Mutex, OnceLock};
 use std::thread;
+use std::time::Duration;
 
+#[derive(Clone, Copy)]
 pub enum SoundType {
     Start,
     Stop,
 }
 
-fn get_sound_path(settings: &Settings, sound_type: SoundType) -> PathBuf {
-    let filename = match (settings.sound_theme(), sound_type) {
+type PlayResult = Result<Duration, String>;
+
+enum PlayerCmd {
+    Play {
+        path: PathBuf,
+        volume: f32,
+        output_device: Option<String>,
+        /// Receives the clip length once playback has started.
+        started_tx: Option<mpsc::Sender<PlayResult>>,
+    },
+    /// Opens the output and decodes clips ahead of the first cue.
+    Prepare {
+        paths: Vec<PathBuf>,
+        output_device: Option<String>,
+    },
+    /// Closes the output and forgets decoded clips.
+    Release,
+}
+
+static PLAYER: OnceLock<Mutex<mpsc::Sender<PlayerCmd>>> = OnceLock::new();
+
+fn send_to_player(cmd: PlayerCmd) {
+    let player = PLAYER.get_or_init(|| {
+        let (tx, rx) = mpsc::channel();
+        thread::Builder::new()
+            .name("dikt-feedback".to_string())
+            .spawn(move || FeedbackPlayer::default().run(rx))
+            .expect("failed to spawn feedback player thread");
+        Mutex::new(tx)
+    });
+    if let Ok(tx) = player.lock() {
+        let _ = tx.send(cmd);
+    }
+}
+
+struct Clip {
+    channels: u16,
+    sample_rate: u32,
+    samples: Arc<[i16]>,
+}
+
+impl Clip {
+    fn decode(path: &Path) -> Result<Self, Box<dyn std::error::Error + Send + Sync>> {
+        let decoder = rodio::Decoder::new(BufReader::new(File::open(path)?))?;
+        let channels = decoder.channels();
+        let sample_rate = decoder.sample_rate();
+        Ok(Self {
+            channels,
+            sample_rate,
+            samples: decoder.collect::<Vec<i16>>().into(),
+        })
+    }
+
+    fn duration(&self) -> Duration {
+        let frames = self.samples.len() / usize::from(self.channels.max(1));
+        Duration::from_secs_f64(frames as f64 / f64::from(self.sample_rate.max(1)))
+    }
+
+    /// A source playing the decoded samples without copying them.
+    fn source(&self) -> ClipSource {
+        ClipSource {
+            samples: self.samples.clone(),
+            channels: self.channels,
+            sample_rate: self.sample_rate,
+            duration: self.duration(),
+            position: 0,
+        }
+    }
+}
+
+/// Plays a [`Clip`] from its shared sample buffer.
+struct ClipSource {
+    samples: Arc<[i16]>,
+    channels: u16,
+    sample_rate: u32,
+    duration: Duration,
+    position: usize,
+}
+
+impl Iterator for ClipSource {
+    type Item = i16;
+
+    fn next(&mut self) -> Option<i16> {
+        let sample = *self.samples.get(self.position)?;
+        self.position += 1;
+        Some(sample)
+    }
+
+    fn size_hint(&self) -> (usize, Option<usize>) {
+        let remaining = self.samples.len() - self.position;
+        (remaining, Some(remaining))
+    }
+}
+
+impl Source for ClipSource {
+    fn current_frame_len(&self) -> Option<usize> {
+        Some(self.samples.len() - self.position)
+    }
+
+    fn channels(&self) -> u16 {
+        self.channels
+    }
+
+    fn sample_rate(&self) -> u32 {
+        self.sample_rate
+    }
+
+    fn total_duration(&self) -> Option<Duration> {
+        Some(self.duration)
+    }
+}
+
+struct Output {
+    device: Option<String>,
+    // Dropping the stream closes the device, so it lives beside its handle.
+    _stream: OutputStream,
+    handle: OutputStreamHandle,
+}
+
+#[derive(Default)]
+struct FeedbackPlayer {
+    output: Option<Output>,
+    clips: HashMap<PathBuf, Clip>,
+}
+
+impl FeedbackPlayer {
+    fn run(mut self, rx: mpsc::Receiver<PlayerCmd>) {
+        for cmd in rx {
+            match cmd {
+                PlayerCmd::Play {
+                    path,
+                    volume,
+                    output_device,
+                    started_tx,
+                } => {
+                    let result = self
+                        .play(&path, volume, output_device.as_deref())
+                        .map_err(|e| e.to_string());
+                    if let Err(e) = &result {
+                        error!("Failed to play sound '{}': {}", path.display(), e);
+                    }
+                    if let Some(tx) = started_tx {
+                        let _ = tx.send(result);
+                    }
+                }
+                PlayerCmd::Prepare {
+                    paths,
+                    output_device,
+                } => {
+                    if let Err(e) = self.ensure_output(output_device.as_deref()) {
+                        warn!("Failed to open feedback output: {}", e);
+                    }
+                    self.clips.retain(|path, _| paths.contains(path));
+                    for path in paths {
+                        if let Err(e) = self.clip(&path) {
+                            warn!("Failed to decode sound '{}': {}", path.display(), e);
+                        }
+                    }
+                }
+                PlayerCmd::Release => {
+                    self.output = None;
+                    self.clips.clear();
+                }
+            }
+        }
+    }
+
+    fn play(
+        &mut self,
+        path: &Path,
+        volume: f32,
+        output_device: Option<&str>,
+    ) -> Result<Duration, Box<dyn std::error::Error + Send + Sync>> {
+        debug!("Playing audio file: {}", path.display());
+        self.ensure_output(output_device)?;
+        let clip = self.clip(path)?;
+        let source = clip.source();
+        let duration = clip.duration();
+
+        let handle = &self.output.as_ref().expect("output opened above").handle;
+        let sink = match Sink::try_new(handle) {
+            Ok(sink) => sink,
+            Err(e) => {
+                // The device may have gone away; reopen once and retry.
+                warn!("Feedback output unusable ({}), reopening", e);
+                self.output = None;
+                self.ensure_output(output_device)?;
+                Sink::try_new(&self.output.as_ref().expect("output reopened").handle)?
+            }
+        };
+        sink.set_volume(volume);
+        sink.append(source);
+        sink.detach();
+        Ok(duration)
+    }
+
+    fn clip(&mut self, path: &Path) -> Result<&Clip, Box<dyn std::error::Error + Send + Sync>> {
+        if !self.clips.contains_key(path) {
+            let clip = Clip::decode(path)?;
+            self.clips.insert(path.to_path_buf(), clip);
+        }
+        Ok(&self.clips[path])
+    }
+
+    fn ensure_output(
+        &mut self,
+        output_device: Option<&str>,
+    ) -> Result<(), Box<dyn std::error::Error + Send + Sync>> {
+        if self
+            .output
+            .as_ref()
+            .is_some_and(|output| output.device.as_deref() == output_device)
+        {
+            return Ok(());
+        }
+        self.output = None;
+
+        let (stream, handle) = if let Some(device_name) = output_device {
+            match find_output_device_by_name(device_name)
+                .and_then(|device| OutputStream::try_from_device(&device).ok())
+            {
+                Some(stream) => stream,
+                None => {
+                    warn!(
+                        "Selected output device '{}' not available, falling back to default output",
+                        device_name
+                    );
+                    OutputStream::try_default()?
+                }
+            }
+        } else {
+            OutputStream::try_default()?
+        };
+        self.output = Some(Output {
+            device: output_device.map(str::to_string),
+            _stream: stream,
+            handle,
+        });
+        Ok(())
+    }
+}
+
+fn get_sound_path(theme: SoundTheme, sound_type: SoundType) -> PathBuf {
+    let filename = match (theme, sound_type) {
         (SoundTheme::Custom, SoundType::Start) => "custom_start.wav",
         (SoundTheme::Custom, SoundType::Stop) => "custom_stop.wav",
         (SoundTheme::Pop, SoundType::Start) => "pop_start.wav",
@@ -21,7 +273,7 @@ fn get_sound_path(settings: &Settings, sound_type: SoundType) -> PathBuf {
         (SoundTheme::Marimba, SoundType::Stop) => "marimba_stop.wav",
     };
 
-    if settings.sound_theme() == SoundTheme::Custom {
+    if theme == SoundTheme::Custom {
         let data_dir = std::env::var("XDG_DATA_HOME")
             .map(|p| PathBuf::from(p).join("dikt").join("sounds"))
             .unwrap_or_else(|_| PathBuf::from("/usr/share/dikt/sounds"));
@@ -36,17 +288,48 @@ fn get_sound_path(settings: &Settings, sound_type: SoundType) -> PathBuf {
     PathBuf::from("resources").join(filename)
 }
 
-pub fn play_feedback_sound(settings: &Settings, sound_type: SoundType) {
+/// Opens the output and decodes the current theme's clips when feedback is
+/// enabled, or releases them when it is not. Call again whenever the
+/// feedback, theme or output device settings change.
+pub fn prepare_feedback_sounds(settings: &Settings) {
     if !settings.audio_feedback() {
+        send_to_player(PlayerCmd::Release);
         return;
     }
-    let path = get_sound_path(settings, sound_type);
-    let volume = settings.audio_feedback_volume();
-    let output_device = settings.selected_output_device();
-    thread::spawn(move || {
-        if let Err(e) = play_audio_file(&path, volume, output_device.as_deref()) {
-            error!("Failed to play sound '{}': {}", path.display(), e);
-        }
+    send_to_player(PlayerCmd::Prepare {
+        paths: vec![
+            get_sound_path(settings.sound_theme(), SoundType::Start),
+            get_sound_path(settings.sound_theme(), SoundType::Stop),
+        ],
+        output_device: settings.selected_output_device(),
+    });
+}
+
+/// Waits for the player to start the clip, then for the clip to finish.
+fn play_and_wait(settings: &Settings, sound_type: SoundType) {
+    let (tx, rx) = mpsc::channel();
+    send_to_player(PlayerCmd::Play {
+        path: get_sound_path(settings.sound_theme(), sound_type),
+        volume: settings.audio_feedback_volume(),
+        output_device: settings.selected_output_device(),
+        started_tx: Some(tx),
+    });
+    if let Ok(Ok(duration)) = rx.recv() {
+        thread::sleep(duration);
+    }
+}
+
+/// Queues a cue without waiting; takes the snapshot so the recording path
+/// does no settings reads.
+pub fn play_feedback_sound(settings: &SettingsSnapshot, sound_type: SoundType) {
+    if !settings.audio_feedback {
+        return;
+    }
+    send_to_player(PlayerCmd::Play {
+        path: get_sound_path(settings.sound_theme, sound_type),
+        volume: settings.audio_feedback_volume,
+        output_device: settings.selected_output_device.clone(),
+        started_tx: None,
     });
 }
 
@@ -54,61 +337,11 @@ pub fn play_feedback_sound_blocking(settings: &Settings, sound_type: SoundType)
     if !settings.audio_feedback() {
         return;
     }
-    let path = get_sound_path(settings, sound_type);
-    if let Err(e) = play_audio_file(
-        &path,
-        settings.audio_feedback_volume(),
-        settings.selected_output_device().as_deref(),
-    ) {
-        error!("Failed to play sound '{}': {}", path.display(), e);
-    }
+    play_and_wait(settings, sound_type);
 }
 
 pub fn play_test_sound(settings: &Settings, sound_type: SoundType) {
-    let path = get_sound_path(settings, sound_type);
-    if let Err(e) = play_audio_file(
-        &path,
-        settings.audio_feedback_volume(),
-        settings.selected_output_device().as_deref(),
-    ) {
-        error!("Failed to play sound '{}': {}", path.display(), e);
-    }
-}
-
-fn play_audio_file(
-    path: &Path,
-    volume: f32,
-    output_device_name: Option<&str>,
-) -> Result<(), Box<dyn std::error::Error + Send + Sync>> {
-    debug!("Playing audio file: {}", path.display());
-
-    let (_stream, stream_handle) = if let Some(device_name) = output_device_name {
-        match find_output_device_by_name(device_name)
-            .and_then(|device| OutputStream::try_from_device(&device).ok())
-        {
-            Some(stream) => stream,
-            None => {
-                warn!(
-                    "Selected output device '{}' not available, falling back to default output",
-                    device_name
-                );
-                OutputStream::try_default()?
-            }
-        }
-    } else {
-        OutputStream::try_default()?
-    };
-
-    let file = File::open(path)?;
-    let buf_reader = BufReader::new(file);
-    let source = rodio::Decoder::new(buf_reader)?;
-
-    let sink = Sink::try_new(&stream_handle)?;
-    sink.append(source);
-    sink.set_volume(volume);
-    sink.sleep_until_end();
-
-    Ok(())
+    play_and_wait(settings, sound_type);
 }
 
 fn find_output_device_by_name(device_name: &str) -> Option<rodio::cpal::Device> {
@@ -123,3 +356,22 @@ fn find_output_device_by_name(device_name: &str) -> Option<rodio::cpal::Device>
             .unwrap_or(false)
     })
 }
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn clip_source_plays_the_shared_samples() {
+        let clip = Clip {
+            channels: 2,
+            sample_rate: 4,
+            samples: vec![1, -1, 2, -2, 3, -3].into(),
+        };
+        let source = clip.source();
+        assert!(Arc::ptr_eq(&source.samples, &clip.samples));
+        assert_eq!(source.channels(), 2);
+        assert_eq!(source.total_duration(), Some(Duration::from_millis(750)));
+        assert_eq!(source.collect::<Vec<_>>(), [1, -1, 2, -2, 3, -3]);
+    }
+}
@@ -0,0 +1,93 @@
+//! Speech activity published by the recorder.
+//!
+//! The consumer bumps a sequence number for every frame it keeps as speech,
+//! so preview workers can sleep until something was actually said instead of
+//! polling, and skip decodes whose audio only grew by silence.
+
+use std::sync::{Condvar, Mutex};
+use std::time::{Duration, Instant};
+
+/// RMS above which a frame counts as speech when no VAD is in use
+/// (about -46 dBFS).
+const SPEECH_ENERGY_THRESHOLD: f32 = 0.005;
+
+#[derive(Default)]
+pub struct SpeechActivity {
+    sequence: Mutex<u64>,
+    changed: Condvar,
+}
+
+impl SpeechActivity {
+    pub fn new() -> Self {
+        Self::default()
+    }
+
+    pub fn sequence(&self) -> u64 {
+        *self.sequence.lock().unwrap()
+    }
+
+    pub(crate) fn bump(&self) {
+        *self.sequence.lock().unwrap() += 1;
+        self.changed.notify_all();
+    }
+
+    /// Blocks until the sequence differs from `seen` or `timeout` passes,
+    /// then returns the current sequence.
+    pub fn wait_for_change(&self, seen: u64, timeout: Duration) -> u64 {
+        let deadline = Instant::now() + timeout;
+        let mut sequence = self.sequence.lock().unwrap();
+        while *sequence == seen {
+            let Some(remaining) = deadline.checked_duration_since(Instant::now()) else {
+                break;
+            };
+            sequence = self.changed.wait_timeout(sequence, remaining).unwrap().0;
+        }
+        *sequence
+    }
+}
+
+/// Energy gate for recordings without a VAD.
+pub(crate) fn has_speech_energy(frame: &[f32]) -> bool {
+    if frame.is_empty() {
+        return false;
+    }
+    let energy: f32 = frame.iter().map(|s| s * s).sum();
+    energy / frame.len() as f32 > SPEECH_ENERGY_THRESHOLD * SPEECH_ENERGY_THRESHOLD
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use std::sync::Arc;
+    use std::thread;
+
+    #[test]
+    fn wait_returns_on_bump_or_timeout() {
+        let activity = Arc::new(SpeechActivity::new());
+        assert_eq!(activity.wait_for_change(0, Duration::from_millis(10)), 0);
+
+        let bumper = {
+            let activity = activity.clone();
+            thread::spawn(move || {
+                thread::sleep(Duration::from_millis(20));
+                activity.bump();
+            })
+        };
+        let started = Instant::now();
+        assert_eq!(activity.wait_for_change(0, Duration::from_secs(5)), 1);
+        assert!(started.elapsed() < Duration::from_secs(5));
+        bumper.join().unwrap();
+
+        // An already newer sequence does not wait at all.
+        assert_eq!(activity.wait_for_change(0, Duration::from_secs(5)), 1);
+    }
+
+    #[test]
+    fn energy_gate_separates_room_noise_from_voice() {
+        let voice: Vec<f32> = (0..480).map(|i| (i as f32 * 0.1).sin() * 0.05).collect();
+        let hiss: Vec<f32> = (0..480).map(|i| (i as f32 * 0.7).sin() * 0.001).collect();
+        assert!(has_speech_energy(&voice));
+        assert!(!has_speech_energy(&hiss));
+        assert!(!has_speech_energy(&[]));
+    }
+}
@@ -1,12 +1,19 @@
 // Re-export all audio components
+mod activity;
 mod device;
 mod recorder;
 mod resampler;
+mod ring;
+mod samples;
+mod spill;
 mod utils;
 mod visualizer;
 
+pub use activity::SpeechActivity;
 pub use device::{list_input_devices, list_output_devices, CpalDeviceInfo};
 pub use recorder::AudioRecorder;
-pub use resampler::FrameResampler;
+pub use resampler::{FrameResampler, ResamplerMode};
+pub use samples::{SampleStore, SampleView, SAMPLE_CHUNK_LEN};
+pub use spill::{default_spill_dir, recover_spilled_recordings};
 pub use utils::save_wav_file;
 pub use visualizer::AudioVisualiser;
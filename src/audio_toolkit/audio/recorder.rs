@@ -1,7 +1,12 @@
 use std::{
     io::{Error, ErrorKind},
-    sync::{mpsc, Arc, Mutex},
-    time::Duration,
+    path::PathBuf,
+    sync::{
+        atomic::{AtomicU32, Ordering},
+        mpsc, Arc, Mutex,
+    },
+    thread,
+    time::{Duration, Instant},
 };
 
 use cpal::{
@@ -10,19 +15,43 @@ use cpal::{
 };
 
 use crate::audio_toolkit::{
-    audio::{AudioVisualiser, FrameResampler},
+    audio::{
+        activity::has_speech_energy,
+        ring::{self, RingConsumer, RingProducer},
+        AudioVisualiser, FrameResampler, ResamplerMode, SampleStore, SampleView, SpeechActivity,
+    },
     constants,
-    vad::{self, VadFrame},
+    vad::VadFrame,
     VoiceActivityDetector,
 };
 
+/// Seconds of mono input the capture ring can hold before samples are dropped.
+const CAPTURE_RING_SECONDS: usize = 2;
+/// Upper bound on samples the consumer takes from the ring per iteration.
+const CONSUMER_CHUNK_SAMPLES: usize = 4096;
+/// Longest the consumer sleeps without audio; pushes and commands unpark it.
+const CONSUMER_IDLE_PARK_MS: u64 = 100;
+
 enum Cmd {
-    Start,
-    Stop(mpsc::Sender<Vec<f32>>),
-    Snapshot(mpsc::Sender<Vec<f32>>),
+    /// Begins a recording, spilling it to a scratch file in `spill_dir` if set.
+    Start {
+        spill_dir: Option<PathBuf>,
+    },
+    Stop(mpsc::Sender<SampleView>),
+    Snapshot(mpsc::Sender<SampleView>),
     SnapshotWindow {
         max_samples: usize,
-        reply_tx: mpsc::Sender<Vec<f32>>,
+        reply_tx: mpsc::Sender<SampleView>,
+    },
+    SnapshotSince {
+        start: usize,
+        reply_tx: mpsc::Sender<(usize, SampleView)>,
+    },
+    SegmentSince {
+        start: usize,
+        min_len: usize,
+        max_len: usize,
+        reply_tx: mpsc::Sender<Option<(usize, SampleView)>>,
     },
     Shutdown,
 }
@@ -32,12 +61,31 @@ enum WorkerInit {
     Failed(String),
 }
 
+/// Spectrum levels for a subscriber. The consumer only analyses audio while
+/// `rate_hz` is non-zero, at that many updates per second.
+#[derive(Clone)]
+struct LevelTap {
+    rate_hz: Arc<AtomicU32>,
+    callback: Arc<dyn Fn(&[f32]) + Send + Sync + 'static>,
+}
+
+/// The VAD is only ever touched by the consumer thread, so it is moved into
+/// the worker on `open` and handed back when the worker exits.
+type WorkerHandle = thread::JoinHandle<Option<Box<dyn VoiceActivityDetector>>>;
+
+/// Set by the consumer when the first speech sample of a recording is kept.
+type SpeechOnset = Arc<Mutex<Option<Instant>>>;
+
 pub struct AudioRecorder {
     device: Option<Device>,
     cmd_tx: Option<mpsc::Sender<Cmd>>,
-    worker_handle: Option<std::thread::JoinHandle<()>>,
-    vad: Option<Arc<Mutex<Box<dyn vad::VoiceActivityDetector>>>>,
-    level_cb: Option<Arc<dyn Fn(Vec<f32>) + Send + Sync + 'static>>,
+    worker_handle: Option<WorkerHandle>,
+    vad: Option<Box<dyn VoiceActivityDetector>>,
+    level_tap: Option<LevelTap>,
+    resampler_mode: ResamplerMode,
+    spill_dir: Option<PathBuf>,
+    speech_onset: SpeechOnset,
+    speech_activity: Arc<SpeechActivity>,
 }
 
 impl AudioRecorder {
@@ -47,29 +95,67 @@ impl AudioRecorder {
             cmd_tx: None,
             worker_handle: None,
             vad: None,
-            level_cb: None,
+            level_tap: None,
+            resampler_mode: ResamplerMode::default(),
+            spill_dir: None,
+            speech_onset: Arc::new(Mutex::new(None)),
+            speech_activity: Arc::new(SpeechActivity::new()),
         })
     }
 
     pub fn with_vad(mut self, vad: Box<dyn VoiceActivityDetector>) -> Self {
-        self.vad = Some(Arc::new(Mutex::new(vad)));
+        self.vad = Some(vad);
         self
     }
 
-    pub fn with_level_callback<F>(mut self, cb: F) -> Self
+    /// Reports speech to `activity` instead of a handle of its own, so that
+    /// watchers keep working when the recorder is replaced.
+    pub fn with_speech_activity(mut self, activity: Arc<SpeechActivity>) -> Self {
+        self.speech_activity = activity;
+        self
+    }
+
+    /// Takes effect the next time the stream is opened.
+    pub fn set_resampler_mode(&mut self, mode: ResamplerMode) {
+        self.resampler_mode = mode;
+    }
+
+    /// Where recordings keep all but their last minute and a half of audio;
+    /// `None` keeps everything in memory. Takes effect on the next start.
+    pub fn set_spill_dir(&mut self, dir: Option<PathBuf>) {
+        self.spill_dir = dir;
+    }
+
+    /// Reports spectrum levels to `cb` at the rate stored in `rate_hz`,
+    /// which callers change at runtime; 0 skips the analysis entirely.
+    pub fn with_level_callback<F>(mut self, rate_hz: Arc<AtomicU32>, cb: F) -> Self
     where
-        F: Fn(Vec<f32>) + Send + Sync + 'static,
+        F: Fn(&[f32]) + Send + Sync + 'static,
     {
-        self.level_cb = Some(Arc::new(cb));
+        self.level_tap = Some(LevelTap {
+            rate_hz,
+            callback: Arc::new(cb),
+        });
         self
     }
 
+    /// When the current (or last) recording first kept a speech sample:
+    /// the VAD's onset decision, or the first frame without a VAD.
+    pub fn speech_onset(&self) -> Option<Instant> {
+        *self.speech_onset.lock().unwrap()
+    }
+
+    /// Bumped for every frame kept as speech (VAD speech, or frames above
+    /// the energy gate without a VAD) and when a recording stops.
+    pub fn speech_activity(&self) -> Arc<SpeechActivity> {
+        self.speech_activity.clone()
+    }
+
     pub fn open(&mut self, device: Option<Device>) -> Result<(), Box<dyn std::error::Error>> {
         if self.worker_handle.is_some() {
             return Ok(()); // already open
         }
 
-        let (sample_tx, sample_rx) = mpsc::channel::<Vec<f32>>();
         let (cmd_tx, cmd_rx) = mpsc::channel::<Cmd>();
         let (init_tx, init_rx) = mpsc::channel::<WorkerInit>();
 
@@ -82,11 +168,14 @@ impl AudioRecorder {
         };
 
         let thread_device = device.clone();
-        let vad = self.vad.clone();
+        let mut vad = self.vad.take();
         // Move the optional level callback into the worker thread
-        let level_cb = self.level_cb.clone();
+        let level_tap = self.level_tap.clone();
+        let resampler_mode = self.resampler_mode;
+        let speech_onset = self.speech_onset.clone();
+        let speech_activity = self.speech_activity.clone();
 
-        let worker = std::thread::spawn(move || {
+        let worker = thread::spawn(move || {
             let config = match AudioRecorder::get_preferred_config(&thread_device) {
                 Ok(config) => config,
                 Err(e) => {
@@ -94,12 +183,16 @@ impl AudioRecorder {
                         "Failed to fetch preferred config: {}",
                         e
                     )));
-                    return;
+                    return vad;
                 }
             };
 
             let sample_rate = config.sample_rate().0;
             let channels = config.channels() as usize;
+            let (producer, consumer) = ring::sample_ring(
+                sample_rate as usize * CAPTURE_RING_SECONDS,
+                thread::current(),
+            );
 
             log::info!(
                 "Using device: {:?}\nSample rate: {}\nChannels: {}\nFormat: {:?}",
@@ -111,19 +204,19 @@ impl AudioRecorder {
 
             let stream = match config.sample_format() {
                 cpal::SampleFormat::U8 => {
-                    AudioRecorder::build_stream::<u8>(&thread_device, &config, sample_tx, channels)
+                    AudioRecorder::build_stream::<u8>(&thread_device, &config, producer, channels)
                 }
                 cpal::SampleFormat::I8 => {
-                    AudioRecorder::build_stream::<i8>(&thread_device, &config, sample_tx, channels)
+                    AudioRecorder::build_stream::<i8>(&thread_device, &config, producer, channels)
                 }
                 cpal::SampleFormat::I16 => {
-                    AudioRecorder::build_stream::<i16>(&thread_device, &config, sample_tx, channels)
+                    AudioRecorder::build_stream::<i16>(&thread_device, &config, producer, channels)
                 }
                 cpal::SampleFormat::I32 => {
-                    AudioRecorder::build_stream::<i32>(&thread_device, &config, sample_tx, channels)
+                    AudioRecorder::build_stream::<i32>(&thread_device, &config, producer, channels)
                 }
                 cpal::SampleFormat::F32 => {
-                    AudioRecorder::build_stream::<f32>(&thread_device, &config, sample_tx, channels)
+                    AudioRecorder::build_stream::<f32>(&thread_device, &config, producer, channels)
                 }
                 _ => Err(cpal::BuildStreamError::StreamConfigNotSupported),
             };
@@ -135,7 +228,7 @@ impl AudioRecorder {
                         "Failed to build input stream: {}",
                         e
                     )));
-                    return;
+                    return vad;
                 }
             };
 
@@ -144,14 +237,24 @@ impl AudioRecorder {
                     "Failed to start input stream: {}",
                     e
                 )));
-                return;
+                return vad;
             }
 
             let _ = init_tx.send(WorkerInit::Ready);
 
             // keep the stream alive while we process samples
-            run_consumer(sample_rate, vad, sample_rx, cmd_rx, level_cb);
+            run_consumer(
+                sample_rate,
+                resampler_mode,
+                &mut vad,
+                consumer,
+                cmd_rx,
+                level_tap,
+                speech_onset,
+                &speech_activity,
+            );
             // stream is dropped here, after run_consumer returns
+            vad
         });
 
         match init_rx.recv_timeout(Duration::from_secs(5)) {
@@ -162,12 +265,13 @@ impl AudioRecorder {
                 Ok(())
             }
             Ok(WorkerInit::Failed(message)) => {
-                let _ = worker.join();
+                self.reclaim_vad(worker);
                 Err(Error::other(message).into())
             }
             Err(e) => {
                 let _ = cmd_tx.send(Cmd::Shutdown);
-                let _ = worker.join();
+                worker.thread().unpark();
+                self.reclaim_vad(worker);
                 Err(Error::new(
                     ErrorKind::TimedOut,
                     format!("Timed out waiting for recorder startup: {}", e),
@@ -184,11 +288,14 @@ impl AudioRecorder {
                 "Recorder is not open; cannot start recording",
             )
         })?;
-        tx.send(Cmd::Start)?;
+        tx.send(Cmd::Start {
+            spill_dir: self.spill_dir.clone(),
+        })?;
+        self.wake_worker();
         Ok(())
     }
 
-    pub fn stop(&self) -> Result<Vec<f32>, Box<dyn std::error::Error>> {
+    pub fn stop(&self) -> Result<SampleView, Box<dyn std::error::Error>> {
         let (resp_tx, resp_rx) = mpsc::channel();
         let tx = self.cmd_tx.as_ref().ok_or_else(|| {
             Error::new(
@@ -197,6 +304,7 @@ impl AudioRecorder {
             )
         })?;
         tx.send(Cmd::Stop(resp_tx))?;
+        self.wake_worker();
         Ok(resp_rx.recv_timeout(Duration::from_secs(3)).map_err(|e| {
             Error::new(
                 ErrorKind::TimedOut,
@@ -205,7 +313,7 @@ impl AudioRecorder {
         })?)
     }
 
-    pub fn snapshot(&self) -> Result<Vec<f32>, Box<dyn std::error::Error>> {
+    pub fn snapshot(&self) -> Result<SampleView, Box<dyn std::error::Error>> {
         let (resp_tx, resp_rx) = mpsc::channel();
         let tx = self.cmd_tx.as_ref().ok_or_else(|| {
             Error::new(
@@ -214,6 +322,7 @@ impl AudioRecorder {
             )
         })?;
         tx.send(Cmd::Snapshot(resp_tx))?;
+        self.wake_worker();
         Ok(resp_rx
             .recv_timeout(Duration::from_millis(800))
             .map_err(|e| {
@@ -227,7 +336,7 @@ impl AudioRecorder {
     pub fn snapshot_window(
         &self,
         max_samples: usize,
-    ) -> Result<Vec<f32>, Box<dyn std::error::Error>> {
+    ) -> Result<SampleView, Box<dyn std::error::Error>> {
         let (resp_tx, resp_rx) = mpsc::channel();
         let tx = self.cmd_tx.as_ref().ok_or_else(|| {
             Error::new(
@@ -239,6 +348,7 @@ impl AudioRecorder {
             max_samples,
             reply_tx: resp_tx,
         })?;
+        self.wake_worker();
         Ok(resp_rx
             .recv_timeout(Duration::from_millis(800))
             .map_err(|e| {
@@ -249,28 +359,199 @@ impl AudioRecorder {
             })?)
     }
 
+    /// Returns the total number of captured samples together with the samples
+    /// from absolute offset `start` onwards, so callers that track their own
+    /// position only copy audio they have not consumed yet.
+    pub fn snapshot_since(
+        &self,
+        start: usize,
+    ) -> Result<(usize, SampleView), Box<dyn std::error::Error>> {
+        let (resp_tx, resp_rx) = mpsc::channel();
+        let tx = self.cmd_tx.as_ref().ok_or_else(|| {
+            Error::new(
+                ErrorKind::NotConnected,
+                "Recorder is not open; cannot snapshot recording tail",
+            )
+        })?;
+        tx.send(Cmd::SnapshotSince {
+            start,
+            reply_tx: resp_tx,
+        })?;
+        self.wake_worker();
+        Ok(resp_rx
+            .recv_timeout(Duration::from_millis(800))
+            .map_err(|e| {
+                Error::new(
+                    ErrorKind::TimedOut,
+                    format!("Timed out waiting for recorder snapshot tail: {}", e),
+                )
+            })?)
+    }
+
+    /// Returns the next completed segment starting at `start`: audio up to a
+    /// silence boundary found by the VAD, together with its end offset. `None`
+    /// means no boundary far enough past `start` has been seen yet.
+    pub fn segment_since(
+        &self,
+        start: usize,
+        min_len: usize,
+        max_len: usize,
+    ) -> Result<Option<(usize, SampleView)>, Box<dyn std::error::Error>> {
+        let (resp_tx, resp_rx) = mpsc::channel();
+        let tx = self.cmd_tx.as_ref().ok_or_else(|| {
+            Error::new(
+                ErrorKind::NotConnected,
+                "Recorder is not open; cannot read recording segment",
+            )
+        })?;
+        tx.send(Cmd::SegmentSince {
+            start,
+            min_len,
+            max_len,
+            reply_tx: resp_tx,
+        })?;
+        self.wake_worker();
+        Ok(resp_rx
+            .recv_timeout(Duration::from_millis(800))
+            .map_err(|e| {
+                Error::new(
+                    ErrorKind::TimedOut,
+                    format!("Timed out waiting for recorder segment: {}", e),
+                )
+            })?)
+    }
+
+    /// The worker parks while the capture ring is empty; commands must wake it
+    /// rather than wait for the next audio callback.
+    fn wake_worker(&self) {
+        if let Some(h) = &self.worker_handle {
+            h.thread().unpark();
+        }
+    }
+
     pub fn close(&mut self) -> Result<(), Box<dyn std::error::Error>> {
         if let Some(tx) = self.cmd_tx.take() {
             let _ = tx.send(Cmd::Shutdown);
         }
+        self.wake_worker();
         if let Some(h) = self.worker_handle.take() {
-            let _ = h.join();
+            self.reclaim_vad(h);
         }
         self.device = None;
         Ok(())
     }
 
+    /// Feeds recorded audio through the same ring, consumer, resampler and
+    /// VAD as the microphone, `block_frames` frames per simulated device
+    /// callback, and returns what `stop` would. The recorder must be closed.
+    /// Replay waits for the consumer instead of overrunning the ring, so no
+    /// input is dropped however fast it is fed.
+    pub fn replay(
+        &mut self,
+        interleaved: &[f32],
+        sample_rate: u32,
+        channels: usize,
+        block_frames: usize,
+    ) -> Result<SampleView, Box<dyn std::error::Error>> {
+        if self.worker_handle.is_some() {
+            return Err(Error::other("Recorder is open; close it before replaying").into());
+        }
+        let channels = channels.max(1);
+
+        let (cmd_tx, cmd_rx) = mpsc::channel::<Cmd>();
+        let (ring_tx, ring_rx) = mpsc::channel::<RingProducer>();
+        let mut vad = self.vad.take();
+        let level_tap = self.level_tap.clone();
+        let resampler_mode = self.resampler_mode;
+        let speech_onset = self.speech_onset.clone();
+        let speech_activity = self.speech_activity.clone();
+        let worker: WorkerHandle = thread::spawn(move || {
+            let (producer, consumer) = ring::sample_ring(
+                sample_rate as usize * CAPTURE_RING_SECONDS,
+                thread::current(),
+            );
+            let _ = ring_tx.send(producer);
+            run_consumer(
+                sample_rate,
+                resampler_mode,
+                &mut vad,
+                consumer,
+                cmd_rx,
+                level_tap,
+                speech_onset,
+                &speech_activity,
+            );
+            vad
+        });
+
+        let result = (|| -> Result<SampleView, Box<dyn std::error::Error>> {
+            let mut producer = ring_rx.recv()?;
+            let wait = || thread::sleep(Duration::from_micros(200));
+
+            // Commands are handled in order, so once the snapshot answers,
+            // recording is on and no pushed sample can miss it.
+            let (ready_tx, ready_rx) = mpsc::channel();
+            cmd_tx.send(Cmd::Start { spill_dir: None })?;
+            cmd_tx.send(Cmd::Snapshot(ready_tx))?;
+            worker.thread().unpark();
+            ready_rx.recv()?;
+
+            let mut mono = Vec::with_capacity(block_frames.max(1));
+            for block in interleaved.chunks(block_frames.max(1) * channels) {
+                mono.clear();
+                if channels == 1 {
+                    mono.extend_from_slice(block);
+                } else {
+                    downmix_into(block, channels, &mut mono);
+                }
+                while producer.queued() + mono.len() > producer.capacity() {
+                    wait();
+                }
+                producer.push_slice(&mono);
+            }
+            // The consumer handles what it pops before its next command.
+            while producer.queued() > 0 {
+                wait();
+            }
+
+            let (reply_tx, reply_rx) = mpsc::channel();
+            cmd_tx.send(Cmd::Stop(reply_tx))?;
+            worker.thread().unpark();
+            Ok(reply_rx.recv()?)
+        })();
+
+        let _ = cmd_tx.send(Cmd::Shutdown);
+        worker.thread().unpark();
+        self.reclaim_vad(worker);
+        result
+    }
+
+    /// Joins the worker and takes back the VAD it was running with.
+    fn reclaim_vad(&mut self, worker: WorkerHandle) {
+        match worker.join() {
+            Ok(vad) => self.vad = vad,
+            Err(_) => log::error!("Recorder worker panicked; VAD is no longer available"),
+        }
+    }
+
     fn build_stream<T>(
         device: &cpal::Device,
         config: &cpal::SupportedStreamConfig,
-        sample_tx: mpsc::Sender<Vec<f32>>,
+        mut producer: RingProducer,
         channels: usize,
     ) -> Result<cpal::Stream, cpal::BuildStreamError>
     where
         T: Sample + SizedSample + Send + 'static,
         f32: cpal::FromSample<T>,
     {
-        let mut output_buffer = Vec::new();
+        // Sized up front so the real-time callback does not allocate once
+        // the device settles on its period size.
+        let mut output_buffer = Vec::with_capacity(CONSUMER_CHUNK_SAMPLES);
+        let mut interleaved = Vec::with_capacity(if channels == 1 {
+            0
+        } else {
+            CONSUMER_CHUNK_SAMPLES * channels
+        });
 
         let stream_cb = move |data: &[T], _: &cpal::InputCallbackInfo| {
             output_buffer.clear();
@@ -279,23 +560,15 @@ impl AudioRecorder {
                 // Direct conversion without intermediate Vec
                 output_buffer.extend(data.iter().map(|&sample| sample.to_sample::<f32>()));
             } else {
-                // Convert to mono directly
-                let frame_count = data.len() / channels;
-                output_buffer.reserve(frame_count);
-
-                for frame in data.chunks_exact(channels) {
-                    let mono_sample = frame
-                        .iter()
-                        .map(|&sample| sample.to_sample::<f32>())
-                        .sum::<f32>()
-                        / channels as f32;
-                    output_buffer.push(mono_sample);
-                }
+                // Convert first, then downmix: both passes are straight-line
+                // loops the compiler vectorises, unlike a per-frame sum.
+                interleaved.clear();
+                interleaved.extend(data.iter().map(|&sample| sample.to_sample::<f32>()));
+                downmix_into(&interleaved, channels, &mut output_buffer);
             }
 
-            if sample_tx.send(output_buffer.clone()).is_err() {
-                log::error!("Failed to send samples");
-            }
+            // Never blocks: overflow is counted and reported by the consumer.
+            producer.push_slice(&output_buffer);
         };
 
         device.build_input_stream(
@@ -345,20 +618,54 @@ impl AudioRecorder {
     }
 }
 
+/// Averages interleaved frames to mono. Common channel counts get a
+/// fixed-width loop the compiler can unroll and vectorise.
+fn downmix_into(interleaved: &[f32], channels: usize, out: &mut Vec<f32>) {
+    match channels {
+        2 => downmix_fixed::<2>(interleaved, out),
+        4 => downmix_fixed::<4>(interleaved, out),
+        6 => downmix_fixed::<6>(interleaved, out),
+        8 => downmix_fixed::<8>(interleaved, out),
+        _ => {
+            let scale = 1.0 / channels as f32;
+            out.extend(
+                interleaved
+                    .chunks_exact(channels)
+                    .map(|frame| frame.iter().sum::<f32>() * scale),
+            );
+        }
+    }
+}
+
+fn downmix_fixed<const CHANNELS: usize>(interleaved: &[f32], out: &mut Vec<f32>) {
+    let scale = 1.0 / CHANNELS as f32;
+    out.extend(interleaved.chunks_exact(CHANNELS).map(|frame| {
+        let mut sum = 0.0;
+        for &sample in frame {
+            sum += sample;
+        }
+        sum * scale
+    }));
+}
+
 fn run_consumer(
     in_sample_rate: u32,
-    vad: Option<Arc<Mutex<Box<dyn vad::VoiceActivityDetector>>>>,
-    sample_rx: mpsc::Receiver<Vec<f32>>,
+    resampler_mode: ResamplerMode,
+    vad: &mut Option<Box<dyn VoiceActivityDetector>>,
+    mut sample_ring: RingConsumer,
     cmd_rx: mpsc::Receiver<Cmd>,
-    level_cb: Option<Arc<dyn Fn(Vec<f32>) + Send + Sync + 'static>>,
+    level_tap: Option<LevelTap>,
+    speech_onset: SpeechOnset,
+    activity: &SpeechActivity,
 ) {
     let mut frame_resampler = FrameResampler::new(
         in_sample_rate as usize,
         constants::WHISPER_SAMPLE_RATE as usize,
         Duration::from_millis(30),
+        resampler_mode,
     );
 
-    let mut processed_samples = Vec::<f32>::new();
+    let mut processed_samples = SampleStore::new();
     let mut recording = false;
 
     // ---------- spectrum visualisation setup ---------------------------- //
@@ -375,97 +682,220 @@ fn run_consumer(
     fn handle_frame(
         samples: &[f32],
         recording: bool,
-        vad: &Option<Arc<Mutex<Box<dyn vad::VoiceActivityDetector>>>>,
-        out_buf: &mut Vec<f32>,
+        vad: &mut Option<Box<dyn VoiceActivityDetector>>,
+        out_buf: &mut SampleStore,
+        activity: &SpeechActivity,
     ) {
         if !recording {
             return;
         }
 
-        if let Some(vad_arc) = vad {
-            let mut det = vad_arc.lock().unwrap();
-            match det.push_frame(samples).unwrap_or(VadFrame::Speech(samples)) {
-                VadFrame::Speech(buf) => out_buf.extend_from_slice(buf),
-                VadFrame::Noise => {}
-            }
+        if let Some(det) = vad {
+            // Frames the VAD fails on are still emitted as speech.
+            let _ = det.push_frame_with(samples, &mut |frame| {
+                store_vad_frame(frame, out_buf, activity)
+            });
         } else {
             out_buf.extend_from_slice(samples);
+            if has_speech_energy(samples) {
+                activity.bump();
+            }
+        }
+    }
+
+    fn store_vad_frame(frame: VadFrame<'_>, out_buf: &mut SampleStore, activity: &SpeechActivity) {
+        match frame {
+            VadFrame::Speech(buf) => {
+                out_buf.extend_from_slice(buf);
+                activity.bump();
+            }
+            // Silence frames are dropped; remember where the speech ended.
+            VadFrame::Noise => out_buf.mark_boundary(),
         }
     }
 
     fn process_cmd(
         cmd: Cmd,
         recording: &mut bool,
-        vad: &Option<Arc<Mutex<Box<dyn vad::VoiceActivityDetector>>>>,
+        vad: &mut Option<Box<dyn VoiceActivityDetector>>,
         visualizer: &mut AudioVisualiser,
         frame_resampler: &mut FrameResampler,
-        processed_samples: &mut Vec<f32>,
+        processed_samples: &mut SampleStore,
+        activity: &SpeechActivity,
     ) -> bool {
         match cmd {
-            Cmd::Start => {
+            Cmd::Start { spill_dir } => {
                 processed_samples.clear();
+                if let Some(dir) = spill_dir {
+                    if let Err(e) = processed_samples.start_spilling(&dir) {
+                        log::warn!("Recording in memory; cannot spill to {:?}: {}", dir, e);
+                    }
+                }
                 *recording = true;
                 visualizer.reset();
                 if let Some(v) = vad {
-                    v.lock().unwrap().reset();
+                    v.reset();
                 }
                 false
             }
             Cmd::Stop(reply_tx) => {
                 *recording = false;
-                frame_resampler
-                    .finish(&mut |frame: &[f32]| handle_frame(frame, true, vad, processed_samples));
-                let _ = reply_tx.send(std::mem::take(processed_samples));
+                frame_resampler.finish(&mut |frame: &[f32]| {
+                    handle_frame(frame, true, vad, processed_samples, activity)
+                });
+                if let Some(v) = vad {
+                    // Decide frames a batching VAD is still holding back.
+                    let _ =
+                        v.flush(&mut |frame| store_vad_frame(frame, processed_samples, activity));
+                }
+                let _ = reply_tx.send(processed_samples.take_view());
+                // Waiters re-check their session now rather than at a timeout.
+                activity.bump();
                 false
             }
             Cmd::Snapshot(reply_tx) => {
-                let _ = reply_tx.send(processed_samples.clone());
+                let _ = reply_tx.send(processed_samples.view_from(0));
                 false
             }
             Cmd::SnapshotWindow {
                 max_samples,
                 reply_tx,
             } => {
-                if max_samples == 0 || processed_samples.len() <= max_samples {
-                    let _ = reply_tx.send(processed_samples.clone());
-                } else {
-                    let start = processed_samples.len().saturating_sub(max_samples);
-                    let _ = reply_tx.send(processed_samples[start..].to_vec());
-                }
+                let _ = reply_tx.send(processed_samples.view_last(max_samples));
+                false
+            }
+            Cmd::SnapshotSince { start, reply_tx } => {
+                let _ =
+                    reply_tx.send((processed_samples.len(), processed_samples.view_from(start)));
+                false
+            }
+            Cmd::SegmentSince {
+                start,
+                min_len,
+                max_len,
+                reply_tx,
+            } => {
+                let segment = processed_samples
+                    .segment_end(start, min_len, max_len)
+                    .map(|end| (end, processed_samples.view_range(start, end)));
+                let _ = reply_tx.send(segment);
                 false
             }
             Cmd::Shutdown => true,
         }
     }
 
+    let mut raw = Vec::<f32>::with_capacity(CONSUMER_CHUNK_SAMPLES);
+    let mut reported_overrun_samples: u64 = 0;
+    let mut metering_rate_hz = 0;
+    let mut awaiting_onset = false;
+
     loop {
-        while let Ok(cmd) = cmd_rx.try_recv() {
-            if process_cmd(
-                cmd,
-                &mut recording,
-                &vad,
-                &mut visualizer,
-                &mut frame_resampler,
-                &mut processed_samples,
-            ) {
-                return;
+        loop {
+            match cmd_rx.try_recv() {
+                Ok(cmd) => {
+                    if matches!(cmd, Cmd::Start { .. }) {
+                        awaiting_onset = true;
+                        *speech_onset.lock().unwrap() = None;
+                    }
+                    if process_cmd(
+                        cmd,
+                        &mut recording,
+                        vad,
+                        &mut visualizer,
+                        &mut frame_resampler,
+                        &mut processed_samples,
+                        activity,
+                    ) {
+                        return;
+                    }
+                }
+                Err(mpsc::TryRecvError::Empty) => break,
+                Err(mpsc::TryRecvError::Disconnected) => return,
             }
         }
 
-        let raw = match sample_rx.recv_timeout(Duration::from_millis(20)) {
-            Ok(raw) => raw,
-            Err(mpsc::RecvTimeoutError::Timeout) => continue,
-            Err(mpsc::RecvTimeoutError::Disconnected) => return,
-        };
+        if sample_ring.pop_into(&mut raw, CONSUMER_CHUNK_SAMPLES) == 0 {
+            thread::park_timeout(Duration::from_millis(CONSUMER_IDLE_PARK_MS));
+            continue;
+        }
 
-        if let Some(buckets) = visualizer.feed(&raw) {
-            if let Some(cb) = &level_cb {
-                cb(buckets);
+        let overrun_samples = sample_ring.overrun_samples();
+        if overrun_samples != reported_overrun_samples {
+            log::warn!(
+                "Capture ring overrun: {} input samples dropped ({} total)",
+                overrun_samples - reported_overrun_samples,
+                overrun_samples
+            );
+            reported_overrun_samples = overrun_samples;
+        }
+
+        if let Some(tap) = &level_tap {
+            let rate_hz = tap.rate_hz.load(Ordering::Relaxed);
+            if rate_hz != metering_rate_hz {
+                if metering_rate_hz == 0 {
+                    // Drop whatever was buffered before the last unsubscribe.
+                    visualizer.reset();
+                }
+                visualizer.set_update_rate(rate_hz);
+                metering_rate_hz = rate_hz;
+            }
+            if rate_hz > 0 {
+                if let Some(levels) = visualizer.feed(&raw) {
+                    (tap.callback)(levels);
+                }
             }
         }
 
         frame_resampler.push(&raw, &mut |frame: &[f32]| {
-            handle_frame(frame, recording, &vad, &mut processed_samples)
+            handle_frame(frame, recording, vad, &mut processed_samples, activity)
         });
+        if awaiting_onset && recording && !processed_samples.is_empty() {
+            awaiting_onset = false;
+            *speech_onset.lock().unwrap() = Some(Instant::now());
+        }
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn downmix_averages_each_frame() {
+        for channels in 1..=8 {
+            let interleaved: Vec<f32> = (0..channels * 3)
+                .map(|i| (i / channels) as f32 + (i % channels) as f32)
+                .collect();
+            let mut out = Vec::new();
+            downmix_into(&interleaved, channels, &mut out);
+            let offset = (channels - 1) as f32 / 2.0;
+            assert_eq!(out.len(), 3);
+            for (frame, mono) in out.iter().enumerate() {
+                assert!((mono - (frame as f32 + offset)).abs() < 1e-5);
+            }
+        }
+    }
+
+    #[test]
+    fn replay_resamples_every_input_sample() {
+        // One second of 48 kHz stereo in 10 ms callbacks.
+        let interleaved: Vec<f32> = (0..48_000 * 2)
+            .map(|i| ((i / 2) as f32 * 0.05).sin() * 0.5)
+            .collect();
+        let mut recorder = AudioRecorder::new().unwrap();
+        let mut last_onset = None;
+        for _ in 0..2 {
+            let samples = recorder.replay(&interleaved, 48_000, 2, 480).unwrap();
+            assert!(
+                (15_500..17_500).contains(&samples.len()),
+                "got {} samples",
+                samples.len()
+            );
+            // Without a VAD the first frame is the onset, once per recording.
+            let onset = recorder.speech_onset();
+            assert!(onset.is_some() && onset != last_onset);
+            last_onset = onset;
+        }
     }
 }
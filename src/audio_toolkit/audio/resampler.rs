@@ -3,74 +3,148 @@ use std::time::Duration;
 
 // Make this a constant you can tweak
 const RESAMPLER_CHUNK_SIZE: usize = 1024;
+/// FFT chunk for non-integer ratios in low-latency mode (~5 ms at 48 kHz).
+const LOW_LATENCY_CHUNK_SIZE: usize = 256;
+/// Low-pass taps per unit of decimation factor (73 taps for 48k -> 16k).
+const DECIMATOR_TAPS_PER_FACTOR: usize = 24;
+/// Low-pass cutoff as a fraction of the output Nyquist frequency.
+const DECIMATOR_CUTOFF: f64 = 0.9;
+
+#[derive(Clone, Copy, Debug, Default, PartialEq, Eq)]
+pub enum ResamplerMode {
+    /// FFT resampling over 1024-sample input chunks.
+    #[default]
+    Quality,
+    /// Direct FIR decimation for integer ratios (48k -> 16k), otherwise FFT
+    /// resampling over small chunks, so frames are emitted sooner.
+    LowLatency,
+}
+
+enum Backend {
+    Passthrough,
+    Fft {
+        resampler: Box<FftFixedIn<f32>>,
+        chunk_in: usize,
+        in_buf: Vec<f32>,
+    },
+    Decimate(Decimator),
+}
 
 pub struct FrameResampler {
-    resampler: Option<FftFixedIn<f32>>,
-    chunk_in: usize,
-    in_buf: Vec<f32>,
+    backend: Backend,
     frame_samples: usize,
     pending: Vec<f32>,
+    /// Reused output of the decimator before it is cut into frames.
+    decimated: Vec<f32>,
 }
 
 impl FrameResampler {
-    pub fn new(in_hz: usize, out_hz: usize, frame_dur: Duration) -> Self {
+    pub fn new(in_hz: usize, out_hz: usize, frame_dur: Duration, mode: ResamplerMode) -> Self {
         let frame_samples = ((out_hz as f64 * frame_dur.as_secs_f64()).round()) as usize;
         assert!(frame_samples > 0, "frame duration too short");
 
-        // Use fixed chunk size instead of GCD-based
-        let chunk_in = RESAMPLER_CHUNK_SIZE;
+        let fft = |chunk_in: usize| Backend::Fft {
+            resampler: Box::new(
+                FftFixedIn::<f32>::new(in_hz, out_hz, chunk_in, 1, 1)
+                    .expect("Failed to create resampler"),
+            ),
+            chunk_in,
+            in_buf: Vec::with_capacity(chunk_in),
+        };
 
-        let resampler = (in_hz != out_hz).then(|| {
-            FftFixedIn::<f32>::new(in_hz, out_hz, chunk_in, 1, 1)
-                .expect("Failed to create resampler")
-        });
+        let backend = if in_hz == out_hz {
+            Backend::Passthrough
+        } else {
+            match mode {
+                ResamplerMode::Quality => fft(RESAMPLER_CHUNK_SIZE),
+                ResamplerMode::LowLatency if in_hz.is_multiple_of(out_hz) => {
+                    Backend::Decimate(Decimator::new(in_hz / out_hz))
+                }
+                ResamplerMode::LowLatency => fft(LOW_LATENCY_CHUNK_SIZE),
+            }
+        };
 
         Self {
-            resampler,
-            chunk_in,
-            in_buf: Vec::with_capacity(chunk_in),
+            backend,
             frame_samples,
             pending: Vec::with_capacity(frame_samples),
+            decimated: Vec::new(),
         }
     }
 
     pub fn push(&mut self, mut src: &[f32], mut emit: impl FnMut(&[f32])) {
-        if self.resampler.is_none() {
-            self.emit_frames(src, &mut emit);
-            return;
-        }
+        match &mut self.backend {
+            Backend::Passthrough => {
+                Self::emit_frames(&mut self.pending, self.frame_samples, src, &mut emit);
+            }
+            Backend::Decimate(decimator) => {
+                self.decimated.clear();
+                decimator.push(src, &mut self.decimated);
+                Self::emit_frames(
+                    &mut self.pending,
+                    self.frame_samples,
+                    &self.decimated,
+                    &mut emit,
+                );
+            }
+            Backend::Fft {
+                resampler,
+                chunk_in,
+                in_buf,
+            } => {
+                while !src.is_empty() {
+                    let space = *chunk_in - in_buf.len();
+                    let take = space.min(src.len());
+                    in_buf.extend_from_slice(&src[..take]);
+                    src = &src[take..];
 
-        while !src.is_empty() {
-            let space = self.chunk_in - self.in_buf.len();
-            let take = space.min(src.len());
-            self.in_buf.extend_from_slice(&src[..take]);
-            src = &src[take..];
-
-            if self.in_buf.len() == self.chunk_in {
-                // let start = std::time::Instant::now();
-                if let Ok(out) = self
-                    .resampler
-                    .as_mut()
-                    .unwrap()
-                    .process(&[&self.in_buf[..]], None)
-                {
-                    // let duration = start.elapsed();
-                    // log::debug!("Resampler took: {:?}", duration);
-                    self.emit_frames(&out[0], &mut emit);
+                    if in_buf.len() == *chunk_in {
+                        if let Ok(out) = resampler.process(&[&in_buf[..]], None) {
+                            Self::emit_frames(
+                                &mut self.pending,
+                                self.frame_samples,
+                                &out[0],
+                                &mut emit,
+                            );
+                        }
+                        in_buf.clear();
+                    }
                 }
-                self.in_buf.clear();
             }
         }
     }
 
     pub fn finish(&mut self, mut emit: impl FnMut(&[f32])) {
         // Process any remaining input samples
-        if let Some(ref mut resampler) = self.resampler {
-            if !self.in_buf.is_empty() {
-                // Pad with zeros to reach chunk size
-                self.in_buf.resize(self.chunk_in, 0.0);
-                if let Ok(out) = resampler.process(&[&self.in_buf[..]], None) {
-                    self.emit_frames(&out[0], &mut emit);
+        match &mut self.backend {
+            Backend::Passthrough => {}
+            Backend::Decimate(decimator) => {
+                self.decimated.clear();
+                decimator.flush(&mut self.decimated);
+                Self::emit_frames(
+                    &mut self.pending,
+                    self.frame_samples,
+                    &self.decimated,
+                    &mut emit,
+                );
+            }
+            Backend::Fft {
+                resampler,
+                chunk_in,
+                in_buf,
+            } => {
+                if !in_buf.is_empty() {
+                    // Pad with zeros to reach chunk size
+                    in_buf.resize(*chunk_in, 0.0);
+                    if let Ok(out) = resampler.process(&[&in_buf[..]], None) {
+                        Self::emit_frames(
+                            &mut self.pending,
+                            self.frame_samples,
+                            &out[0],
+                            &mut emit,
+                        );
+                    }
+                    in_buf.clear();
                 }
             }
         }
@@ -83,17 +157,183 @@ impl FrameResampler {
         }
     }
 
-    fn emit_frames(&mut self, mut data: &[f32], emit: &mut impl FnMut(&[f32])) {
+    fn emit_frames(
+        pending: &mut Vec<f32>,
+        frame_samples: usize,
+        mut data: &[f32],
+        emit: &mut impl FnMut(&[f32]),
+    ) {
         while !data.is_empty() {
-            let space = self.frame_samples - self.pending.len();
+            if pending.is_empty() && data.len() >= frame_samples {
+                // Whole frames straight from the input, without staging them.
+                let (frame, rest) = data.split_at(frame_samples);
+                emit(frame);
+                data = rest;
+                continue;
+            }
+
+            let space = frame_samples - pending.len();
             let take = space.min(data.len());
-            self.pending.extend_from_slice(&data[..take]);
+            pending.extend_from_slice(&data[..take]);
             data = &data[take..];
 
-            if self.pending.len() == self.frame_samples {
-                emit(&self.pending);
-                self.pending.clear();
+            if pending.len() == frame_samples {
+                emit(pending);
+                pending.clear();
             }
         }
     }
 }
+
+/// Integer-ratio decimator. A windowed-sinc low-pass is evaluated only at the
+/// kept output positions (the polyphase form of decimation), so each output
+/// costs one short dot product and nothing waits for a block to fill.
+struct Decimator {
+    factor: usize,
+    taps: Vec<f32>,
+    /// Input not yet fully consumed: the last `taps.len() - 1` samples plus
+    /// whatever arrived since.
+    history: Vec<f32>,
+}
+
+impl Decimator {
+    fn new(factor: usize) -> Self {
+        let len = DECIMATOR_TAPS_PER_FACTOR * factor + 1;
+        let center = (len - 1) as f64 / 2.0;
+        let cutoff = DECIMATOR_CUTOFF / (2.0 * factor as f64);
+        let mut taps: Vec<f64> = (0..len)
+            .map(|i| {
+                let t = i as f64 - center;
+                let sinc = if t == 0.0 {
+                    2.0 * cutoff
+                } else {
+                    (2.0 * std::f64::consts::PI * cutoff * t).sin() / (std::f64::consts::PI * t)
+                };
+                let phase = 2.0 * std::f64::consts::PI * i as f64 / (len - 1) as f64;
+                let blackman = 0.42 - 0.5 * phase.cos() + 0.08 * (2.0 * phase).cos();
+                sinc * blackman
+            })
+            .collect();
+        let gain: f64 = taps.iter().sum();
+        taps.iter_mut().for_each(|tap| *tap /= gain);
+
+        Self {
+            factor,
+            taps: taps.into_iter().map(|tap| tap as f32).collect(),
+            // Start from silence so the first output lines up with input 0.
+            history: vec![0.0; len - 1],
+        }
+    }
+
+    fn push(&mut self, src: &[f32], out: &mut Vec<f32>) {
+        self.history.extend_from_slice(src);
+        let len = self.taps.len();
+        let mut start = 0;
+        while start + len <= self.history.len() {
+            out.push(dot(&self.history[start..start + len], &self.taps));
+            start += self.factor;
+        }
+        // Shifts in place; capacity settles at the largest callback size.
+        self.history.drain(..start);
+    }
+
+    /// Pushes the filter's group delay worth of silence so the last input
+    /// samples reach the output.
+    fn flush(&mut self, out: &mut Vec<f32>) {
+        let delay = (self.taps.len() - 1) / 2;
+        let padded = self.history.len() + delay.div_ceil(self.factor) * self.factor;
+        self.history.resize(padded, 0.0);
+        self.push(&[], out);
+    }
+}
+
+/// Dot product over eight independent accumulators, which the compiler keeps
+/// in vector registers instead of serialising on one running sum.
+#[inline]
+fn dot(a: &[f32], b: &[f32]) -> f32 {
+    const LANES: usize = 8;
+    let mut acc = [0.0f32; LANES];
+    let (a_chunks, b_chunks) = (a.chunks_exact(LANES), b.chunks_exact(LANES));
+    let tail: f32 = a_chunks
+        .remainder()
+        .iter()
+        .zip(b_chunks.remainder())
+        .map(|(x, y)| x * y)
+        .sum();
+    for (x, y) in a_chunks.zip(b_chunks) {
+        for lane in 0..LANES {
+            acc[lane] += x[lane] * y[lane];
+        }
+    }
+    acc.iter().sum::<f32>() + tail
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn sine(hz: f64, rate: usize, len: usize) -> Vec<f32> {
+        (0..len)
+            .map(|i| (2.0 * std::f64::consts::PI * hz * i as f64 / rate as f64).sin() as f32)
+            .collect()
+    }
+
+    fn rms(samples: &[f32]) -> f32 {
+        (samples.iter().map(|s| s * s).sum::<f32>() / samples.len() as f32).sqrt()
+    }
+
+    fn decimate(input: &[f32], piece: usize) -> Vec<f32> {
+        let mut resampler = FrameResampler::new(
+            48000,
+            16000,
+            Duration::from_millis(30),
+            ResamplerMode::LowLatency,
+        );
+        let mut out = Vec::new();
+        for chunk in input.chunks(piece) {
+            resampler.push(chunk, |frame| {
+                assert_eq!(frame.len(), 480);
+                out.extend_from_slice(frame);
+            });
+        }
+        resampler.finish(|frame| out.extend_from_slice(frame));
+        out
+    }
+
+    #[test]
+    fn low_latency_decimation_keeps_voice_and_rejects_aliases() {
+        let voice = decimate(&sine(1000.0, 48000, 48000), 441);
+        assert_eq!(voice.len(), 16320);
+        let settled = &voice[1000..15000];
+        assert!((rms(settled) - std::f32::consts::FRAC_1_SQRT_2).abs() < 0.01);
+        // 1 kHz at 16 kHz completes a cycle every 16 samples.
+        for i in (0..settled.len() - 16).step_by(97) {
+            assert!((settled[i] - settled[i + 16]).abs() < 1e-3);
+        }
+
+        // 12 kHz would fold onto 4 kHz without the low-pass.
+        let alias = decimate(&sine(12000.0, 48000, 48000), 480);
+        assert!(rms(&alias[1000..15000]) < 0.01);
+    }
+
+    #[test]
+    fn low_latency_decimation_emits_first_frame_without_block_delay() {
+        let mut resampler = FrameResampler::new(
+            48000,
+            16000,
+            Duration::from_millis(30),
+            ResamplerMode::LowLatency,
+        );
+        let mut frames = 0;
+        // Exactly one 30 ms frame of input is enough; FFT mode would still be
+        // waiting for a 1024-sample block at the second frame.
+        resampler.push(&[0.5; 1440], |_| frames += 1);
+        assert_eq!(frames, 1);
+    }
+
+    #[test]
+    fn decimation_is_independent_of_callback_size() {
+        let input = sine(440.0, 48000, 9600);
+        assert_eq!(decimate(&input, 1), decimate(&input, 1024));
+    }
+}
@@ -0,0 +1,225 @@
+//! Preallocated single-producer/single-consumer ring of mono f32 samples.
+//!
+//! The cpal input callback is the only producer and the recorder worker the
+//! only consumer. Pushing never allocates, locks or blocks: when the consumer
+//! falls behind, the samples that do not fit are dropped and counted as an
+//! overrun instead of stalling the real-time thread.
+
+use std::cell::UnsafeCell;
+use std::sync::atomic::{AtomicU64, AtomicUsize, Ordering};
+use std::sync::Arc;
+use std::thread::Thread;
+
+struct Shared {
+    buf: Box<[UnsafeCell<f32>]>,
+    mask: usize,
+    /// Total samples ever written; only the producer stores it.
+    head: AtomicUsize,
+    /// Total samples ever read; only the consumer stores it.
+    tail: AtomicUsize,
+    overrun_samples: AtomicU64,
+}
+
+// SAFETY: the producer only writes slots in `[head, tail + capacity)` and the
+// consumer only reads slots in `[tail, head)`. The Release/Acquire pairs on
+// `head` and `tail` hand each slot over before the other side touches it.
+unsafe impl Sync for Shared {}
+
+impl Shared {
+    fn base(&self) -> *mut f32 {
+        // UnsafeCell<f32> has the same layout as f32.
+        self.buf.as_ptr() as *mut f32
+    }
+
+    fn capacity(&self) -> usize {
+        self.buf.len()
+    }
+}
+
+pub struct RingProducer {
+    shared: Arc<Shared>,
+    consumer_thread: Thread,
+}
+
+pub struct RingConsumer {
+    shared: Arc<Shared>,
+}
+
+/// Creates a ring holding at least `min_capacity` samples. `consumer_thread`
+/// is unparked after every push so the consumer can sleep in `park_timeout`.
+pub fn sample_ring(min_capacity: usize, consumer_thread: Thread) -> (RingProducer, RingConsumer) {
+    let capacity = min_capacity.max(2).next_power_of_two();
+    let buf = (0..capacity)
+        .map(|_| UnsafeCell::new(0.0))
+        .collect::<Vec<_>>()
+        .into_boxed_slice();
+    let shared = Arc::new(Shared {
+        buf,
+        mask: capacity - 1,
+        head: AtomicUsize::new(0),
+        tail: AtomicUsize::new(0),
+        overrun_samples: AtomicU64::new(0),
+    });
+    (
+        RingProducer {
+            shared: shared.clone(),
+            consumer_thread,
+        },
+        RingConsumer { shared },
+    )
+}
+
+impl RingProducer {
+    /// Copies as many samples as fit and wakes the consumer. Returns the
+    /// number of samples written; the rest are counted as overrun.
+    pub fn push_slice(&mut self, samples: &[f32]) -> usize {
+        let shared = &*self.shared;
+        let head = shared.head.load(Ordering::Relaxed);
+        let tail = shared.tail.load(Ordering::Acquire);
+        let free = shared.capacity() - head.wrapping_sub(tail);
+        let n = samples.len().min(free);
+
+        if n > 0 {
+            let start = head & shared.mask;
+            let first = n.min(shared.capacity() - start);
+            // SAFETY: slots `[head, head + n)` are free (see `Shared`).
+            unsafe {
+                std::ptr::copy_nonoverlapping(samples.as_ptr(), shared.base().add(start), first);
+                std::ptr::copy_nonoverlapping(
+                    samples.as_ptr().add(first),
+                    shared.base(),
+                    n - first,
+                );
+            }
+            shared.head.store(head.wrapping_add(n), Ordering::Release);
+        }
+
+        if n < samples.len() {
+            shared
+                .overrun_samples
+                .fetch_add((samples.len() - n) as u64, Ordering::Relaxed);
+        }
+        self.consumer_thread.unpark();
+        n
+    }
+
+    /// Samples pushed but not yet taken by the consumer.
+    pub fn queued(&self) -> usize {
+        let shared = &*self.shared;
+        shared
+            .head
+            .load(Ordering::Relaxed)
+            .wrapping_sub(shared.tail.load(Ordering::Acquire))
+    }
+
+    pub fn capacity(&self) -> usize {
+        self.shared.capacity()
+    }
+}
+
+impl RingConsumer {
+    /// Replaces the contents of `out` with up to `max` queued samples and
+    /// returns how many were read. `out` keeps its capacity across calls.
+    pub fn pop_into(&mut self, out: &mut Vec<f32>, max: usize) -> usize {
+        out.clear();
+        let shared = &*self.shared;
+        let tail = shared.tail.load(Ordering::Relaxed);
+        let head = shared.head.load(Ordering::Acquire);
+        let n = head.wrapping_sub(tail).min(max);
+        if n == 0 {
+            return 0;
+        }
+
+        let start = tail & shared.mask;
+        let first = n.min(shared.capacity() - start);
+        // SAFETY: slots `[tail, tail + n)` were published by the producer.
+        unsafe {
+            out.extend_from_slice(std::slice::from_raw_parts(shared.base().add(start), first));
+            out.extend_from_slice(std::slice::from_raw_parts(shared.base(), n - first));
+        }
+        shared.tail.store(tail.wrapping_add(n), Ordering::Release);
+        n
+    }
+
+    /// Total samples dropped because the ring was full.
+    pub fn overrun_samples(&self) -> u64 {
+        self.shared.overrun_samples.load(Ordering::Relaxed)
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn ring_preserves_order_across_wraparound() {
+        let (mut producer, mut consumer) = sample_ring(8, std::thread::current());
+        let mut out = Vec::new();
+        let mut next = 0.0f32;
+        let mut expected = 0.0f32;
+
+        for _ in 0..10 {
+            let chunk = (0..5)
+                .map(|_| {
+                    next += 1.0;
+                    next
+                })
+                .collect::<Vec<_>>();
+            assert_eq!(producer.push_slice(&chunk), 5);
+            assert_eq!(consumer.pop_into(&mut out, usize::MAX), 5);
+            for sample in &out {
+                expected += 1.0;
+                assert_eq!(*sample, expected);
+            }
+        }
+        assert_eq!(consumer.pop_into(&mut out, usize::MAX), 0);
+        assert_eq!(consumer.overrun_samples(), 0);
+    }
+
+    #[test]
+    fn ring_drops_and_counts_samples_when_full() {
+        let (mut producer, mut consumer) = sample_ring(4, std::thread::current());
+        assert_eq!(producer.push_slice(&[1.0, 2.0, 3.0]), 3);
+        assert_eq!(producer.push_slice(&[4.0, 5.0, 6.0]), 1);
+        assert_eq!(consumer.overrun_samples(), 2);
+
+        let mut out = Vec::new();
+        assert_eq!(consumer.pop_into(&mut out, 2), 2);
+        assert_eq!(out, vec![1.0, 2.0]);
+        assert_eq!(consumer.pop_into(&mut out, usize::MAX), 2);
+        assert_eq!(out, vec![3.0, 4.0]);
+    }
+
+    #[test]
+    fn ring_hands_samples_across_threads() {
+        let (mut producer, mut consumer) = sample_ring(64, std::thread::current());
+        let writer = std::thread::spawn(move || {
+            let mut value = 0.0f32;
+            let mut chunk = [0.0f32; 7];
+            while value < 7_000.0 {
+                for sample in chunk.iter_mut() {
+                    value += 1.0;
+                    *sample = value;
+                }
+                let mut written = 0;
+                while written < chunk.len() {
+                    written += producer.push_slice(&chunk[written..]);
+                }
+            }
+        });
+
+        let mut out = Vec::new();
+        let mut expected = 0.0f32;
+        while expected < 7_000.0 {
+            if consumer.pop_into(&mut out, 16) == 0 {
+                std::thread::park_timeout(std::time::Duration::from_millis(5));
+                continue;
+            }
+            for sample in &out {
+                expected += 1.0;
+                assert_eq!(*sample, expected);
+            }
+        }
+        writer.join().unwrap();
+    }
+}
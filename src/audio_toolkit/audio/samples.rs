@@ -0,0 +1,454 @@
+//! Append-only store for recorded 16 kHz samples.
+//!
+//! Audio is kept in fixed-size chunks that are sealed once full and shared
+//! behind `Arc`s afterwards. Snapshots hand out a [`SampleView`] that clones
+//! the chunk pointers and copies at most the partially filled tail chunk, so
+//! repeated previews of a long dictation do not copy the whole recording.
+//!
+//! The store also remembers silence boundaries reported by the VAD so long
+//! recordings can be split into segments without cutting through words.
+//!
+//! With [`SampleStore::start_spilling`], sealed chunks are also written to a
+//! [`SpillFile`] and only the last [`HOT_CHUNKS`] stay in memory; views read
+//! older chunks back from the file when they are materialized.
+
+use std::io;
+use std::path::Path;
+use std::sync::Arc;
+
+use log::warn;
+
+use crate::audio_toolkit::audio::spill::SpillFile;
+
+/// One second of audio at the transcription sample rate.
+pub const SAMPLE_CHUNK_LEN: usize = 16000;
+/// Sealed chunks kept in memory while spilling: enough for the live preview
+/// window and a segment worker running a little behind.
+const HOT_CHUNKS: usize = 90;
+
+#[derive(Clone)]
+enum Chunk {
+    Hot(Arc<Vec<f32>>),
+    /// A full chunk stored at this chunk index in the spill file.
+    Spilled(Arc<SpillFile>, usize),
+}
+
+impl Chunk {
+    fn len(&self) -> usize {
+        match self {
+            Chunk::Hot(samples) => samples.len(),
+            Chunk::Spilled(..) => SAMPLE_CHUNK_LEN,
+        }
+    }
+}
+
+#[derive(Default)]
+pub struct SampleStore {
+    sealed: Vec<Chunk>,
+    tail: Vec<f32>,
+    len: usize,
+    /// Offsets where a speech run ended, ascending.
+    boundaries: Vec<usize>,
+    spill: Option<Arc<SpillFile>>,
+    /// Leading sealed chunks written to the spill file.
+    spilled: usize,
+    /// Leading sealed chunks no longer held in memory.
+    cold: usize,
+}
+
+impl SampleStore {
+    pub fn new() -> Self {
+        Self::default()
+    }
+
+    pub fn len(&self) -> usize {
+        self.len
+    }
+
+    pub fn is_empty(&self) -> bool {
+        self.len == 0
+    }
+
+    pub fn clear(&mut self) {
+        self.sealed.clear();
+        self.tail.clear();
+        self.len = 0;
+        self.boundaries.clear();
+        self.stop_spilling();
+    }
+
+    /// Writes chunks sealed from now on to a new spill file in `dir`. Call
+    /// on an empty store so the file holds the whole recording.
+    pub fn start_spilling(&mut self, dir: &Path) -> io::Result<()> {
+        self.stop_spilling();
+        self.spill = Some(Arc::new(SpillFile::create(dir)?));
+        Ok(())
+    }
+
+    fn stop_spilling(&mut self) {
+        self.spill = None;
+        self.spilled = 0;
+        self.cold = 0;
+    }
+
+    fn seal_tail(&mut self) {
+        let chunk = Arc::new(std::mem::take(&mut self.tail));
+        if let Some(spill) = &self.spill {
+            // After a failed write the rest of the recording stays in memory.
+            if self.spilled == self.sealed.len() {
+                match spill.append(&chunk) {
+                    Ok(()) => self.spilled += 1,
+                    Err(e) => warn!("Failed to spill recording to {:?}: {}", spill.path(), e),
+                }
+            }
+            while self.sealed.len() + 1 - self.cold > HOT_CHUNKS && self.cold < self.spilled {
+                self.sealed[self.cold] = Chunk::Spilled(spill.clone(), self.cold);
+                self.cold += 1;
+            }
+        }
+        self.sealed.push(Chunk::Hot(chunk));
+    }
+
+    /// Records the current end as a silence boundary.
+    pub fn mark_boundary(&mut self) {
+        if self.len > 0 && self.boundaries.last() != Some(&self.len) {
+            self.boundaries.push(self.len);
+        }
+    }
+
+    /// End of the next segment starting at `start`: the latest boundary giving
+    /// a segment of `min_len..=max_len` samples, or failing that the first
+    /// boundary past `min_len`.
+    pub fn segment_end(&self, start: usize, min_len: usize, max_len: usize) -> Option<usize> {
+        let mut candidates = self
+            .boundaries
+            .iter()
+            .copied()
+            .filter(|&b| b >= start.saturating_add(min_len));
+        let first = candidates.next()?;
+        let limit = start.saturating_add(max_len);
+        Some(
+            std::iter::once(first)
+                .chain(candidates)
+                .take_while(|&b| b <= limit)
+                .last()
+                .unwrap_or(first),
+        )
+    }
+
+    pub fn extend_from_slice(&mut self, mut samples: &[f32]) {
+        self.len += samples.len();
+        while !samples.is_empty() {
+            if self.tail.capacity() == 0 {
+                self.tail.reserve_exact(SAMPLE_CHUNK_LEN);
+            }
+            let room = SAMPLE_CHUNK_LEN - self.tail.len();
+            let (head, rest) = samples.split_at(room.min(samples.len()));
+            self.tail.extend_from_slice(head);
+            samples = rest;
+            if self.tail.len() == SAMPLE_CHUNK_LEN {
+                self.seal_tail();
+            }
+        }
+    }
+
+    /// View of the samples from absolute offset `start` to the current end.
+    pub fn view_from(&self, start: usize) -> SampleView {
+        self.view_range(start, self.len)
+    }
+
+    /// View of the samples in `[start, end)`, clamped to what was recorded.
+    pub fn view_range(&self, start: usize, end: usize) -> SampleView {
+        let end = end.min(self.len);
+        let start = start.min(end);
+        let first_chunk = start / SAMPLE_CHUNK_LEN;
+        let last_chunk = end.div_ceil(SAMPLE_CHUNK_LEN).min(self.sealed.len());
+        let mut chunks = self
+            .sealed
+            .get(first_chunk..last_chunk)
+            .unwrap_or_default()
+            .to_vec();
+        let mut offset = start - first_chunk * SAMPLE_CHUNK_LEN;
+        let sealed_len = self.sealed.len() * SAMPLE_CHUNK_LEN;
+        if end > sealed_len {
+            // The tail is still being filled, so only the requested part is copied.
+            let tail_end = end - sealed_len;
+            if chunks.is_empty() {
+                chunks.push(Chunk::Hot(Arc::new(self.tail[offset..tail_end].to_vec())));
+                offset = 0;
+            } else {
+                chunks.push(Chunk::Hot(Arc::new(self.tail[..tail_end].to_vec())));
+            }
+        }
+        SampleView {
+            chunks,
+            offset,
+            len: end - start,
+        }
+    }
+
+    /// View of at most the last `max_samples` samples (everything when 0).
+    pub fn view_last(&self, max_samples: usize) -> SampleView {
+        if max_samples == 0 {
+            return self.view_from(0);
+        }
+        self.view_from(self.len.saturating_sub(max_samples))
+    }
+
+    /// Moves the whole recording into a view without copying and empties the
+    /// store. A spill file lives on until the view is dropped.
+    pub fn take_view(&mut self) -> SampleView {
+        let mut chunks = std::mem::take(&mut self.sealed);
+        if !self.tail.is_empty() {
+            chunks.push(Chunk::Hot(Arc::new(std::mem::take(&mut self.tail))));
+        }
+        let len = std::mem::take(&mut self.len);
+        self.boundaries.clear();
+        self.stop_spilling();
+        SampleView {
+            chunks,
+            offset: 0,
+            len,
+        }
+    }
+}
+
+/// Immutable, cheaply clonable window over recorded samples.
+#[derive(Clone, Default)]
+pub struct SampleView {
+    chunks: Vec<Chunk>,
+    /// Samples to skip at the start of the first chunk.
+    offset: usize,
+    len: usize,
+}
+
+impl SampleView {
+    pub fn len(&self) -> usize {
+        self.len
+    }
+
+    pub fn is_empty(&self) -> bool {
+        self.len == 0
+    }
+
+    /// Calls `f` with the contiguous slices making up the view, in order.
+    /// Spilled chunks are read back one at a time; one that cannot be read
+    /// is replaced by silence so the timeline stays intact.
+    pub fn for_each_segment(&self, mut f: impl FnMut(&[f32])) {
+        let mut skip = self.offset;
+        let mut remaining = self.len;
+        let mut loaded = Vec::new();
+        for chunk in &self.chunks {
+            if remaining == 0 {
+                break;
+            }
+            let start = skip.min(chunk.len());
+            skip = 0;
+            let end = (start + remaining).min(chunk.len());
+            remaining -= end - start;
+            match chunk {
+                Chunk::Hot(samples) => f(&samples[start..end]),
+                Chunk::Spilled(file, index) => {
+                    let first = index * SAMPLE_CHUNK_LEN + start;
+                    if let Err(e) = file.read(first, end - start, &mut loaded) {
+                        warn!("Failed to read spilled recording {:?}: {}", file.path(), e);
+                        loaded.clear();
+                        loaded.resize(end - start, 0.0);
+                    }
+                    f(&loaded);
+                }
+            }
+        }
+    }
+
+    /// The part of the view after the first `start` samples.
+    pub fn slice_from(&self, start: usize) -> SampleView {
+        let start = start.min(self.len);
+        let mut skip = self.offset + start;
+        let mut chunks = self.chunks.iter();
+        let mut kept = Vec::new();
+        for chunk in chunks.by_ref() {
+            if skip < chunk.len() {
+                kept.push(chunk.clone());
+                break;
+            }
+            skip -= chunk.len();
+        }
+        kept.extend(chunks.cloned());
+        SampleView {
+            chunks: kept,
+            offset: skip,
+            len: self.len - start,
+        }
+    }
+
+    pub fn to_vec(&self) -> Vec<f32> {
+        let mut out = Vec::with_capacity(self.len);
+        self.for_each_segment(|segment| out.extend_from_slice(segment));
+        out
+    }
+
+    /// Materializes the view, reusing the buffer when it is a single chunk
+    /// nobody else references (e.g. a short recording taken on stop).
+    pub fn into_vec(mut self) -> Vec<f32> {
+        if self.chunks.len() == 1 && self.offset == 0 && self.chunks[0].len() == self.len {
+            if let Some(Chunk::Hot(chunk)) = self.chunks.pop() {
+                match Arc::try_unwrap(chunk) {
+                    Ok(samples) => return samples,
+                    Err(chunk) => self.chunks.push(Chunk::Hot(chunk)),
+                }
+            }
+        }
+        self.to_vec()
+    }
+}
+
+impl From<Vec<f32>> for SampleView {
+    fn from(samples: Vec<f32>) -> Self {
+        let len = samples.len();
+        Self {
+            chunks: vec![Chunk::Hot(Arc::new(samples))],
+            offset: 0,
+            len,
+        }
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn ramp(len: usize) -> Vec<f32> {
+        (0..len).map(|i| i as f32).collect()
+    }
+
+    #[test]
+    fn store_views_match_contiguous_copy() {
+        let input = ramp(SAMPLE_CHUNK_LEN * 2 + 123);
+        let mut store = SampleStore::new();
+        for piece in input.chunks(480) {
+            store.extend_from_slice(piece);
+        }
+        assert_eq!(store.len(), input.len());
+
+        for start in [
+            0,
+            1,
+            SAMPLE_CHUNK_LEN,
+            SAMPLE_CHUNK_LEN * 2 + 5,
+            input.len(),
+        ] {
+            let view = store.view_from(start);
+            assert_eq!(view.len(), input.len() - start);
+            assert_eq!(view.to_vec(), input[start..].to_vec());
+        }
+        assert_eq!(store.view_last(100).to_vec(), input[input.len() - 100..]);
+        assert_eq!(store.view_last(0).len(), input.len());
+    }
+
+    #[test]
+    fn store_views_share_sealed_chunks() {
+        let mut store = SampleStore::new();
+        store.extend_from_slice(&ramp(SAMPLE_CHUNK_LEN + 10));
+        let view = store.view_from(0);
+        match (&view.chunks[0], &store.sealed[0]) {
+            (Chunk::Hot(a), Chunk::Hot(b)) => assert!(Arc::ptr_eq(a, b)),
+            _ => panic!("expected in-memory chunks"),
+        }
+        assert_eq!(view.chunks.len(), 2);
+    }
+
+    #[test]
+    fn view_range_and_slice_from_match_contiguous_copy() {
+        let input = ramp(SAMPLE_CHUNK_LEN * 3 + 50);
+        let mut store = SampleStore::new();
+        store.extend_from_slice(&input);
+
+        let ranges = [
+            (0, 10),
+            (5, SAMPLE_CHUNK_LEN),
+            (SAMPLE_CHUNK_LEN - 1, SAMPLE_CHUNK_LEN * 2 + 1),
+            (SAMPLE_CHUNK_LEN * 3, input.len()),
+        ];
+        for (start, end) in ranges {
+            assert_eq!(store.view_range(start, end).to_vec(), input[start..end]);
+        }
+
+        let view = store.view_from(7);
+        for start in [0, 1, SAMPLE_CHUNK_LEN - 7, SAMPLE_CHUNK_LEN * 2, view.len()] {
+            assert_eq!(view.slice_from(start).to_vec(), input[7 + start..]);
+        }
+    }
+
+    #[test]
+    fn segment_end_prefers_latest_boundary_within_limit() {
+        let mut store = SampleStore::new();
+        for _ in 0..10 {
+            store.extend_from_slice(&[0.0; 1000]);
+            store.mark_boundary();
+        }
+        store.mark_boundary();
+        assert_eq!(store.boundaries.len(), 10);
+
+        assert_eq!(store.segment_end(0, 2500, 5500), Some(5000));
+        assert_eq!(store.segment_end(5000, 1000, 1000), Some(6000));
+        // Nothing fits under the limit: fall back to the first usable boundary.
+        assert_eq!(store.segment_end(0, 2500, 2000), Some(3000));
+        assert_eq!(store.segment_end(9500, 1000, 5000), None);
+    }
+
+    #[test]
+    fn take_view_reuses_single_chunk_buffer() {
+        let mut store = SampleStore::new();
+        store.extend_from_slice(&ramp(1000));
+        let view = store.take_view();
+        assert!(store.is_empty());
+        let Chunk::Hot(chunk) = &view.chunks[0] else {
+            panic!("expected an in-memory chunk");
+        };
+        let ptr = chunk.as_ptr();
+        let samples = view.into_vec();
+        assert_eq!(samples.as_ptr(), ptr);
+        assert_eq!(samples, ramp(1000));
+    }
+
+    #[test]
+    fn spilling_store_keeps_recent_window_in_memory() {
+        let dir = std::env::temp_dir().join(format!("dikt-samples-{}", std::process::id()));
+        // Values on the 16-bit grid survive the round trip through the file.
+        let input: Vec<f32> = (0..SAMPLE_CHUNK_LEN * (HOT_CHUNKS + 3) + 77)
+            .map(|i| ((i % 601) as f32 - 300.0) / i16::MAX as f32)
+            .collect();
+        let mut store = SampleStore::new();
+        store.start_spilling(&dir).unwrap();
+        for piece in input.chunks(4800) {
+            store.extend_from_slice(piece);
+            store.mark_boundary();
+        }
+        assert_eq!(store.cold, 3);
+        let hot = store
+            .sealed
+            .iter()
+            .filter(|c| matches!(c, Chunk::Hot(_)))
+            .count();
+        assert_eq!(hot, HOT_CHUNKS);
+
+        let start = SAMPLE_CHUNK_LEN * 2 - 5;
+        let end = SAMPLE_CHUNK_LEN * 4 + 9;
+        let close = |a: &[f32], b: &[f32]| {
+            a.len() == b.len() && a.iter().zip(b).all(|(x, y)| (x - y).abs() < 1e-6)
+        };
+        assert!(close(
+            &store.view_range(start, end).to_vec(),
+            &input[start..end]
+        ));
+
+        let path = store.spill.as_ref().unwrap().path().to_path_buf();
+        let view = store.take_view();
+        assert!(close(&view.slice_from(start).to_vec(), &input[start..]));
+        assert!(path.exists());
+        drop(view);
+        assert!(!path.exists());
+        let _ = std::fs::remove_dir_all(&dir);
+    }
+}
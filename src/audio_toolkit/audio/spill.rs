@@ -0,0 +1,243 @@
+//! Scratch files for long recordings.
+//!
+//! While spilling, every sealed chunk is written as 16-bit PCM to a file
+//! under `$XDG_RUNTIME_DIR/dikt`, and chunks older than a recent window are
+//! dropped from memory and read back only when a view is materialized. Memory
+//! use while capturing a long dictation stays bounded by that window (the
+//! final decode still materializes the whole recording), and because the
+//! file is written as the recording grows, a daemon that dies mid-session
+//! leaves the audio behind for [`recover_spilled_recordings`].
+
+use std::fs::{self, File, OpenOptions};
+use std::io::{Error, ErrorKind, Result, Write};
+use std::os::unix::fs::{DirBuilderExt, FileExt, OpenOptionsExt};
+use std::path::{Path, PathBuf};
+use std::time::{SystemTime, UNIX_EPOCH};
+
+use hound::{WavSpec, WavWriter};
+use log::warn;
+
+use crate::audio_toolkit::constants;
+
+const FILE_PREFIX: &str = "recording-";
+const FILE_EXTENSION: &str = "s16";
+const BYTES_PER_SAMPLE: usize = 2;
+
+/// `$XDG_RUNTIME_DIR/dikt`, or a per-user directory under the temp dir.
+pub fn default_spill_dir() -> PathBuf {
+    match std::env::var_os("XDG_RUNTIME_DIR") {
+        Some(dir) if !dir.is_empty() => PathBuf::from(dir).join("dikt"),
+        // SAFETY: getuid cannot fail.
+        _ => std::env::temp_dir().join(format!("dikt-{}", unsafe { libc::getuid() })),
+    }
+}
+
+/// Append-only 16-bit PCM file, removed when the last chunk referring to it
+/// is dropped.
+pub struct SpillFile {
+    file: File,
+    path: PathBuf,
+}
+
+impl SpillFile {
+    /// Creates `recording-<pid>-<unix ms>.s16` in `dir`, which only the user
+    /// can read.
+    pub fn create(dir: &Path) -> Result<Self> {
+        fs::DirBuilder::new()
+            .recursive(true)
+            .mode(0o700)
+            .create(dir)?;
+        let started_ms = SystemTime::now()
+            .duration_since(UNIX_EPOCH)
+            .map(|elapsed| elapsed.as_millis())
+            .unwrap_or(0);
+        let path = dir.join(format!(
+            "{}{}-{}.{}",
+            FILE_PREFIX,
+            std::process::id(),
+            started_ms,
+            FILE_EXTENSION
+        ));
+        let file = OpenOptions::new()
+            .read(true)
+            .append(true)
+            .create_new(true)
+            .mode(0o600)
+            .open(&path)?;
+        Ok(Self { file, path })
+    }
+
+    pub fn path(&self) -> &Path {
+        &self.path
+    }
+
+    pub fn append(&self, samples: &[f32]) -> Result<()> {
+        let mut bytes = Vec::with_capacity(samples.len() * BYTES_PER_SAMPLE);
+        for sample in samples {
+            bytes.extend_from_slice(&quantize(*sample).to_le_bytes());
+        }
+        (&self.file).write_all(&bytes)
+    }
+
+    /// Reads `len` samples starting at sample `start` into `out`.
+    pub fn read(&self, start: usize, len: usize, out: &mut Vec<f32>) -> Result<()> {
+        let mut bytes = vec![0_u8; len * BYTES_PER_SAMPLE];
+        self.file
+            .read_exact_at(&mut bytes, (start * BYTES_PER_SAMPLE) as u64)?;
+        out.clear();
+        out.extend(
+            bytes
+                .chunks_exact(BYTES_PER_SAMPLE)
+                .map(|pair| dequantize(i16::from_le_bytes([pair[0], pair[1]]))),
+        );
+        Ok(())
+    }
+}
+
+impl Drop for SpillFile {
+    fn drop(&mut self) {
+        if let Err(e) = fs::remove_file(&self.path) {
+            if e.kind() != ErrorKind::NotFound {
+                warn!("Failed to remove recording spill {:?}: {}", self.path, e);
+            }
+        }
+    }
+}
+
+fn quantize(sample: f32) -> i16 {
+    (sample.clamp(-1.0, 1.0) * i16::MAX as f32).round() as i16
+}
+
+fn dequantize(sample: i16) -> f32 {
+    sample as f32 / i16::MAX as f32
+}
+
+/// Pid of the process that wrote a spill file, from its name.
+fn spill_owner(path: &Path) -> Option<i32> {
+    if path.extension()? != FILE_EXTENSION {
+        return None;
+    }
+    let stem = path.file_stem()?.to_str()?;
+    stem.strip_prefix(FILE_PREFIX)?
+        .split('-')
+        .next()?
+        .parse()
+        .ok()
+}
+
+fn process_alive(pid: i32) -> bool {
+    // SAFETY: signal 0 only checks that the pid exists.
+    let result = unsafe { libc::kill(pid, 0) };
+    result == 0 || Error::last_os_error().raw_os_error() == Some(libc::EPERM)
+}
+
+/// Turns spill files left by a daemon that is no longer running into WAV
+/// files in `output_dir` and returns their paths.
+pub fn recover_spilled_recordings(spill_dir: &Path, output_dir: &Path) -> Result<Vec<PathBuf>> {
+    let entries = match fs::read_dir(spill_dir) {
+        Ok(entries) => entries,
+        Err(e) if e.kind() == ErrorKind::NotFound => return Ok(Vec::new()),
+        Err(e) => return Err(e),
+    };
+    let mut recovered = Vec::new();
+    for entry in entries.flatten() {
+        let path = entry.path();
+        let Some(pid) = spill_owner(&path) else {
+            continue;
+        };
+        if pid as u32 == std::process::id() || process_alive(pid) {
+            continue;
+        }
+        match recover_one(&path, output_dir) {
+            Ok(wav_path) => {
+                fs::remove_file(&path)?;
+                recovered.push(wav_path);
+            }
+            Err(e) => warn!("Failed to recover recording spill {:?}: {}", path, e),
+        }
+    }
+    Ok(recovered)
+}
+
+fn recover_one(path: &Path, output_dir: &Path) -> Result<PathBuf> {
+    let bytes = fs::read(path)?;
+    fs::create_dir_all(output_dir)?;
+    let stem = path
+        .file_stem()
+        .and_then(|s| s.to_str())
+        .unwrap_or("recording");
+    let wav_path = output_dir.join(format!("{}.wav", stem));
+    let spec = WavSpec {
+        channels: 1,
+        sample_rate: constants::WHISPER_SAMPLE_RATE,
+        bits_per_sample: 16,
+        sample_format: hound::SampleFormat::Int,
+    };
+    let mut writer = WavWriter::create(&wav_path, spec).map_err(Error::other)?;
+    for pair in bytes.chunks_exact(BYTES_PER_SAMPLE) {
+        writer
+            .write_sample(i16::from_le_bytes([pair[0], pair[1]]))
+            .map_err(Error::other)?;
+    }
+    writer.finalize().map_err(Error::other)?;
+    Ok(wav_path)
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn scratch_dir(name: &str) -> PathBuf {
+        let dir = std::env::temp_dir().join(format!("dikt-spill-{}-{}", name, std::process::id()));
+        let _ = fs::remove_dir_all(&dir);
+        dir
+    }
+
+    #[test]
+    fn spill_round_trips_at_16_bit_precision_and_cleans_up() {
+        let dir = scratch_dir("roundtrip");
+        let samples: Vec<f32> = (0..1000).map(|i| (i as f32 / 500.0) - 1.0).collect();
+        let spill = SpillFile::create(&dir).unwrap();
+        spill.append(&samples).unwrap();
+        spill.append(&[2.0]).unwrap();
+
+        let mut out = Vec::new();
+        spill.read(10, 990, &mut out).unwrap();
+        assert_eq!(out.len(), 990);
+        for (read, written) in out.iter().zip(&samples[10..]) {
+            assert!((read - written).abs() <= 1.0 / i16::MAX as f32);
+        }
+        spill.read(1000, 1, &mut out).unwrap();
+        assert_eq!(out, [1.0]);
+
+        let path = spill.path().to_path_buf();
+        drop(spill);
+        assert!(!path.exists());
+        let _ = fs::remove_dir_all(&dir);
+    }
+
+    #[test]
+    fn recovery_converts_files_of_dead_processes_only() {
+        let dir = scratch_dir("recover");
+        let out_dir = dir.join("recovered");
+        fs::create_dir_all(&dir).unwrap();
+        // No process has this pid; the live one belongs to this test.
+        let orphan = dir.join(format!("{}{}-1.{}", FILE_PREFIX, i32::MAX, FILE_EXTENSION));
+        fs::write(&orphan, [0x01, 0x00, 0xff, 0x7f, 0x00, 0x80]).unwrap();
+        let live = SpillFile::create(&dir).unwrap();
+        live.append(&[0.5]).unwrap();
+
+        let recovered = recover_spilled_recordings(&dir, &out_dir).unwrap();
+        assert_eq!(recovered.len(), 1);
+        assert!(!orphan.exists());
+        assert!(live.path().exists());
+
+        let reader = hound::WavReader::open(&recovered[0]).unwrap();
+        assert_eq!(reader.spec().sample_rate, constants::WHISPER_SAMPLE_RATE);
+        let samples: Vec<i16> = reader.into_samples().map(|s| s.unwrap()).collect();
+        assert_eq!(samples, [1, i16::MAX, i16::MIN]);
+
+        drop(live);
+        let _ = fs::remove_dir_all(&dir);
+    }
+}
@@ -11,10 +11,17 @@ pub struct AudioVisualiser {
     window: Vec<f32>,
     bucket_ranges: Vec<(usize, usize)>,
     fft_input: Vec<Complex32>,
+    fft_scratch: Vec<Complex32>,
     noise_floor: Vec<f32>,
+    /// The most recent `window_size` input samples, so each analysis sees
+    /// the latest window whatever the callback size.
     buffer: Vec<f32>,
+    levels: Vec<f32>,
+    sample_rate: u32,
     window_size: usize,
-    buckets: usize,
+    /// Input samples between updates.
+    hop: usize,
+    since_update: usize,
 }
 
 impl AudioVisualiser {
@@ -65,29 +72,48 @@ impl AudioVisualiser {
             bucket_ranges.push((start_bin, end_bin));
         }
 
+        let fft_scratch = vec![Complex32::new(0.0, 0.0); fft.get_inplace_scratch_len()];
+
         Self {
             fft,
             window,
             bucket_ranges,
             fft_input: vec![Complex32::new(0.0, 0.0); window_size],
+            fft_scratch,
             noise_floor: vec![-40.0; buckets], // Initialize to reasonable noise floor
             buffer: Vec::with_capacity(window_size * 2),
+            levels: vec![0.0; buckets],
+            sample_rate,
             window_size,
-            buckets,
+            hop: window_size,
+            since_update: 0,
         }
     }
 
-    pub fn feed(&mut self, samples: &[f32]) -> Option<Vec<f32>> {
-        // Add new samples to buffer
-        self.buffer.extend_from_slice(samples);
+    /// Sets how many level updates per second `feed` produces. Windows
+    /// overlap when the hop is shorter than the window, and intermediate
+    /// windows are skipped when it is longer.
+    pub fn set_update_rate(&mut self, rate_hz: u32) {
+        self.hop = (self.sample_rate / rate_hz.max(1)).max(1) as usize;
+    }
+
+    /// Returns fresh levels once a hop's worth of new samples has arrived.
+    pub fn feed(&mut self, samples: &[f32]) -> Option<&[f32]> {
+        // Only the newest window can be analysed; older input is dropped
+        // before it is copied.
+        let recent = &samples[samples.len().saturating_sub(self.window_size)..];
+        self.buffer.extend_from_slice(recent);
+        let excess = self.buffer.len().saturating_sub(self.window_size);
+        self.buffer.drain(..excess);
 
+        self.since_update += samples.len();
         // Only process if we have enough samples
-        if self.buffer.len() < self.window_size {
+        if self.buffer.len() < self.window_size || self.since_update < self.hop {
             return None;
         }
+        self.since_update %= self.hop;
 
-        // Take the required window of samples
-        let window_samples = &self.buffer[..self.window_size];
+        let window_samples = &self.buffer[..];
 
         // Remove DC component
         let mean = window_samples.iter().sum::<f32>() / self.window_size as f32;
@@ -99,10 +125,12 @@ impl AudioVisualiser {
         }
 
         // Perform FFT
-        self.fft.process(&mut self.fft_input);
+        self.fft
+            .process_with_scratch(&mut self.fft_input, &mut self.fft_scratch);
 
         // Compute power spectrum and bucket levels
-        let mut buckets = vec![0.0; self.buckets];
+        let buckets = &mut self.levels;
+        buckets.fill(0.0);
 
         for (bucket_idx, &(start_bin, end_bin)) in self.bucket_ranges.iter().enumerate() {
             if start_bin >= end_bin || end_bin > self.fft_input.len() / 2 {
@@ -142,14 +170,12 @@ impl AudioVisualiser {
             buckets[i] = buckets[i] * 0.7 + buckets[i - 1] * 0.15 + buckets[i + 1] * 0.15;
         }
 
-        // Clear processed samples from buffer
-        self.buffer.clear();
-
-        Some(buckets)
+        Some(&self.levels)
     }
 
     pub fn reset(&mut self) {
         self.buffer.clear();
+        self.since_update = 0;
         // Reset noise floor to initial values
         self.noise_floor.fill(-40.0);
     }
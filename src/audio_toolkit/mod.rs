@@ -5,8 +5,11 @@ pub mod utils;
 pub mod vad;
 
 pub use audio::{
-    list_input_devices, list_output_devices, save_wav_file, AudioRecorder, CpalDeviceInfo,
+    default_spill_dir, list_input_devices, list_output_devices, recover_spilled_recordings,
+    save_wav_file, AudioRecorder, CpalDeviceInfo, ResamplerMode, SampleView, SpeechActivity,
+};
+pub use text::{
+    apply_custom_words, filter_transcription_output, process_transcript, CustomVocabulary,
 };
-pub use text::{apply_custom_words, filter_transcription_output};
 pub use utils::get_cpal_host;
 pub use vad::{SileroVad, VoiceActivityDetector};
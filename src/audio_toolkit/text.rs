@@ -1,158 +1,283 @@
-use natural::phonetics::soundex;
 use regex::Regex;
+use std::cell::RefCell;
 use std::sync::LazyLock;
-use strsim::levenshtein;
 
 /// Builds an n-gram string by cleaning and concatenating words
 ///
 /// Strips punctuation from each word, lowercases, and joins without spaces.
-/// This allows matching "Charge B" against "ChargeBee".
-fn build_ngram(words: &[&str]) -> String {
-    words
-        .iter()
-        .map(|w| {
-            w.trim_matches(|c: char| !c.is_alphanumeric())
-                .to_lowercase()
-        })
-        .collect::<Vec<_>>()
-        .concat()
+/// This allows matching "Charge B" against "ChargeBee". `out` is cleared
+/// first so one buffer can be reused for every n-gram of a transcript.
+fn build_ngram_into(words: &[&str], out: &mut String) {
+    out.clear();
+    for word in words {
+        out.extend(
+            word.trim_matches(|c: char| !c.is_alphanumeric())
+                .chars()
+                .flat_map(char::to_lowercase),
+        );
+    }
 }
 
-/// Finds the best matching custom word for a candidate string
-///
-/// Uses Levenshtein distance and Soundex phonetic matching to find
-/// the best match above the given threshold.
-///
-/// # Arguments
-/// * `candidate` - The cleaned/lowercased candidate string to match
-/// * `custom_words` - Original custom words (for returning the replacement)
-/// * `custom_words_nospace` - Custom words with spaces removed, lowercased (for comparison)
-/// * `threshold` - Maximum similarity score to accept
-///
-/// # Returns
-/// The best matching custom word and its score, if any match was found
-fn find_best_match<'a>(
-    candidate: &str,
-    custom_words: &'a [String],
-    custom_words_nospace: &[String],
-    threshold: f64,
-) -> Option<(&'a String, f64)> {
-    if candidate.is_empty() || candidate.len() > 50 {
-        return None;
+/// Candidates longer than this (in bytes) are never corrected.
+const MAX_CANDIDATE_LEN: usize = 50;
+/// Score multiplier for candidates that sound like the custom word.
+const PHONETIC_MATCH_WEIGHT: f64 = 0.3;
+
+/// American Soundex code of the ASCII letters in `word` (e.g. "R163"), or
+/// `None` when it has no letters.
+fn soundex_code(word: &str) -> Option<[u8; 4]> {
+    fn digit(c: u8) -> u8 {
+        match c {
+            b'b' | b'f' | b'p' | b'v' => b'1',
+            b'c' | b'g' | b'j' | b'k' | b'q' | b's' | b'x' | b'z' => b'2',
+            b'd' | b't' => b'3',
+            b'l' => b'4',
+            b'm' | b'n' => b'5',
+            b'r' => b'6',
+            // 'h' and 'w' do not separate equal codes, vowels do.
+            b'h' | b'w' => b'-',
+            _ => b'0',
+        }
     }
 
-    let mut best_match: Option<&String> = None;
-    let mut best_score = f64::MAX;
-
-    for (i, custom_word_nospace) in custom_words_nospace.iter().enumerate() {
-        // Skip if lengths are too different (optimization + prevents over-matching)
-        // Use percentage-based check: max 25% length difference (prevents n-grams from
-        // matching significantly shorter custom words, e.g., "openaigpt" vs "openai")
-        let len_diff = (candidate.len() as i32 - custom_word_nospace.len() as i32).abs() as f64;
-        let max_len = candidate.len().max(custom_word_nospace.len()) as f64;
-        let max_allowed_diff = (max_len * 0.25).max(2.0); // At least 2 chars difference allowed
-        if len_diff > max_allowed_diff {
+    let mut letters = word
+        .bytes()
+        .filter(u8::is_ascii_alphabetic)
+        .map(|c| c.to_ascii_lowercase());
+    let first = letters.next()?;
+    let mut code = [first.to_ascii_uppercase(), b'0', b'0', b'0'];
+    let mut last = digit(first);
+    let mut len = 1;
+    for c in letters {
+        if len == code.len() {
+            break;
+        }
+        let d = digit(c);
+        if d == b'-' {
             continue;
         }
+        if d != b'0' && d != last {
+            code[len] = d;
+            len += 1;
+        }
+        last = d;
+    }
+    Some(code)
+}
 
-        // Calculate Levenshtein distance (normalized by length)
-        let levenshtein_dist = levenshtein(candidate, custom_word_nospace);
-        let max_len = candidate.len().max(custom_word_nospace.len()) as f64;
-        let levenshtein_score = if max_len > 0.0 {
-            levenshtein_dist as f64 / max_len
-        } else {
-            1.0
-        };
-
-        // Calculate phonetic similarity using Soundex
-        let phonetic_match = soundex(candidate, custom_word_nospace);
-
-        // Combine scores: favor phonetic matches, but also consider string similarity
-        let combined_score = if phonetic_match {
-            levenshtein_score * 0.3 // Give significant boost to phonetic matches
-        } else {
-            levenshtein_score
-        };
-
-        // Accept if the score is good enough (configurable threshold)
-        if combined_score < threshold && combined_score < best_score {
-            best_match = Some(&custom_words[i]);
-            best_score = combined_score;
+/// Levenshtein distance between `a` and `b` (in chars), or `None` as soon as
+/// it is certain to exceed `max_dist`.
+fn bounded_levenshtein(a: &[char], b: &[char], max_dist: usize) -> Option<usize> {
+    if a.len().abs_diff(b.len()) > max_dist {
+        return None;
+    }
+    let mut prev: Vec<usize> = (0..=b.len()).collect();
+    let mut curr = vec![0; b.len() + 1];
+    for (i, &ca) in a.iter().enumerate() {
+        curr[0] = i + 1;
+        let mut row_min = curr[0];
+        for (j, &cb) in b.iter().enumerate() {
+            let substitution = prev[j] + usize::from(ca != cb);
+            curr[j + 1] = substitution.min(prev[j + 1] + 1).min(curr[j] + 1);
+            row_min = row_min.min(curr[j + 1]);
+        }
+        if row_min > max_dist {
+            return None;
         }
+        std::mem::swap(&mut prev, &mut curr);
     }
+    let dist = prev[b.len()];
+    (dist <= max_dist).then_some(dist)
+}
 
-    best_match.map(|m| (m, best_score))
+/// Whether a custom word key of `word_len` bytes may match a candidate of
+/// `candidate_len` bytes: at most a 25% (and at least 2 byte) difference, so
+/// n-grams do not match significantly shorter words ("openaigpt" vs "openai").
+fn lengths_compatible(candidate_len: usize, word_len: usize) -> bool {
+    let max_len = candidate_len.max(word_len) as f64;
+    candidate_len.abs_diff(word_len) as f64 <= (max_len * 0.25).max(2.0)
 }
 
-/// Applies custom word corrections to transcribed text using fuzzy matching
-///
-/// This function corrects words in the input text by finding the best matches
-/// from a list of custom words using a combination of:
-/// - Levenshtein distance for string similarity
-/// - Soundex phonetic matching for pronunciation similarity
-/// - N-gram matching for multi-word speech artifacts (e.g., "Charge B" -> "ChargeBee")
-///
-/// # Arguments
-/// * `text` - The input text to correct
-/// * `custom_words` - List of custom words to match against
-/// * `threshold` - Maximum similarity score to accept (0.0 = exact match, 1.0 = any match)
+struct VocabularyEntry {
+    /// The custom word as configured, used as the replacement.
+    word: String,
+    /// Lowercased with spaces removed, compared against n-grams.
+    key: Vec<char>,
+    key_len: usize,
+    soundex: Option<[u8; 4]>,
+}
+
+/// Custom words compiled once for fast fuzzy matching.
 ///
-/// # Returns
-/// The corrected text with custom words applied
-pub fn apply_custom_words(text: &str, custom_words: &[String], threshold: f64) -> String {
-    if custom_words.is_empty() {
-        return text.to_string();
-    }
+/// Entries are bucketed by key length so a candidate only visits words whose
+/// length passes the 25% filter, Soundex codes are precomputed, and the
+/// Levenshtein distance is cut off as soon as it cannot beat the threshold or
+/// the best match found so far.
+#[derive(Default)]
+pub struct CustomVocabulary {
+    entries: Vec<VocabularyEntry>,
+    /// Entry indices by key length in bytes, each in configuration order.
+    by_len: Vec<Vec<usize>>,
+}
 
-    // Pre-compute lowercase versions to avoid repeated allocations
-    let custom_words_lower: Vec<String> = custom_words.iter().map(|w| w.to_lowercase()).collect();
+impl CustomVocabulary {
+    pub fn new(custom_words: &[String]) -> Self {
+        let mut vocabulary = Self::default();
+        for word in custom_words {
+            let key = word.to_lowercase().replace(' ', "");
+            let index = vocabulary.entries.len();
+            if vocabulary.by_len.len() <= key.len() {
+                vocabulary.by_len.resize_with(key.len() + 1, Vec::new);
+            }
+            vocabulary.by_len[key.len()].push(index);
+            vocabulary.entries.push(VocabularyEntry {
+                word: word.clone(),
+                soundex: soundex_code(&key),
+                key_len: key.len(),
+                key: key.chars().collect(),
+            });
+        }
+        vocabulary
+    }
 
-    // Pre-compute versions with spaces removed for n-gram comparison
-    let custom_words_nospace: Vec<String> = custom_words_lower
-        .iter()
-        .map(|w| w.replace(' ', ""))
-        .collect();
+    pub fn is_empty(&self) -> bool {
+        self.entries.is_empty()
+    }
 
-    let words: Vec<&str> = text.split_whitespace().collect();
-    let mut result = Vec::new();
-    let mut i = 0;
+    pub fn len(&self) -> usize {
+        self.entries.len()
+    }
 
-    while i < words.len() {
-        let mut matched = false;
+    /// Finds the custom word closest to `candidate` (cleaned and lowercased)
+    /// with a combined score below `threshold`.
+    ///
+    /// The score is the Levenshtein distance normalized by length, scaled down
+    /// for Soundex matches. Ties go to the word configured first.
+    fn find_best_match(&self, candidate: &str, threshold: f64) -> Option<(&str, f64)> {
+        if candidate.is_empty() || candidate.len() > MAX_CANDIDATE_LEN {
+            return None;
+        }
 
-        // Try n-grams from longest (3) to shortest (1) - greedy matching
-        for n in (1..=3).rev() {
-            if i + n > words.len() {
-                continue;
+        let candidate_chars: Vec<char> = candidate.chars().collect();
+        let candidate_soundex = soundex_code(candidate);
+        let min_len = candidate.len().saturating_sub((candidate.len() / 4).max(2));
+        let max_len = (candidate.len() * 4 / 3 + 1)
+            .max(candidate.len() + 2)
+            .min(self.by_len.len().saturating_sub(1));
+
+        let mut best: Option<(usize, f64)> = None;
+        for bucket in self.by_len.get(min_len..=max_len).into_iter().flatten() {
+            for &index in bucket {
+                let entry = &self.entries[index];
+                if !lengths_compatible(candidate.len(), entry.key_len) {
+                    continue;
+                }
+
+                let phonetic_match =
+                    candidate_soundex.is_some() && candidate_soundex == entry.soundex;
+                let weight = if phonetic_match {
+                    PHONETIC_MATCH_WEIGHT
+                } else {
+                    1.0
+                };
+                let pair_len = candidate.len().max(entry.key_len) as f64;
+                let bound = best.map_or(threshold, |(_, score)| score.min(threshold));
+                // Largest distance whose score can still be accepted.
+                let max_dist = (bound * pair_len / weight).ceil() as usize;
+                let Some(dist) = bounded_levenshtein(&candidate_chars, &entry.key, max_dist) else {
+                    continue;
+                };
+
+                let score = dist as f64 / pair_len * weight;
+                let better = match best {
+                    None => score < threshold,
+                    Some((best_index, best_score)) => {
+                        score < best_score || (score == best_score && index < best_index)
+                    }
+                };
+                if better {
+                    best = Some((index, score));
+                }
             }
+        }
 
-            let ngram_words = &words[i..i + n];
-            let ngram = build_ngram(ngram_words);
+        best.map(|(index, score)| (self.entries[index].word.as_str(), score))
+    }
 
-            if let Some((replacement, _score)) =
-                find_best_match(&ngram, custom_words, &custom_words_nospace, threshold)
-            {
-                // Extract punctuation from first and last words of the n-gram
-                let (prefix, _) = extract_punctuation(ngram_words[0]);
-                let (_, suffix) = extract_punctuation(ngram_words[n - 1]);
+    /// Applies custom word corrections to transcribed text using fuzzy matching
+    ///
+    /// Words are corrected using a combination of:
+    /// - Levenshtein distance for string similarity
+    /// - Soundex phonetic matching for pronunciation similarity
+    /// - N-gram matching for multi-word speech artifacts (e.g., "Charge B" -> "ChargeBee")
+    ///
+    /// # Arguments
+    /// * `text` - The input text to correct
+    /// * `threshold` - Maximum similarity score to accept (0.0 = exact match, 1.0 = any match)
+    ///
+    /// # Returns
+    /// The corrected text with custom words applied
+    pub fn apply(&self, text: &str, threshold: f64) -> String {
+        let mut out = String::with_capacity(text.len());
+        self.apply_into(text, threshold, &mut out);
+        out
+    }
+
+    /// Like [`CustomVocabulary::apply`], appending the corrected text to `out`.
+    pub fn apply_into(&self, text: &str, threshold: f64, out: &mut String) {
+        if self.is_empty() {
+            out.push_str(text);
+            return;
+        }
 
-                // Preserve case from first word
-                let corrected = preserve_case_pattern(ngram_words[0], replacement);
+        let words: Vec<&str> = text.split_whitespace().collect();
+        let mut ngram = String::new();
+        let mut i = 0;
 
-                result.push(format!("{}{}{}", prefix, corrected, suffix));
-                i += n;
-                matched = true;
-                break;
+        while i < words.len() {
+            if i > 0 {
+                out.push(' ');
+            }
+            let mut matched = false;
+
+            // Try n-grams from longest (3) to shortest (1) - greedy matching
+            for n in (1..=3).rev() {
+                if i + n > words.len() {
+                    continue;
+                }
+
+                let ngram_words = &words[i..i + n];
+                build_ngram_into(ngram_words, &mut ngram);
+
+                if let Some((replacement, _score)) = self.find_best_match(&ngram, threshold) {
+                    // Extract punctuation from first and last words of the n-gram
+                    let (prefix, _) = extract_punctuation(ngram_words[0]);
+                    let (_, suffix) = extract_punctuation(ngram_words[n - 1]);
+
+                    // Preserve case from first word
+                    out.push_str(prefix);
+                    out.push_str(&preserve_case_pattern(ngram_words[0], replacement));
+                    out.push_str(suffix);
+                    i += n;
+                    matched = true;
+                    break;
+                }
             }
-        }
 
-        if !matched {
-            result.push(words[i].to_string());
-            i += 1;
+            if !matched {
+                out.push_str(words[i]);
+                i += 1;
+            }
         }
     }
+}
 
-    result.join(" ")
+/// Applies custom word corrections to transcribed text using fuzzy matching.
+///
+/// Compiles `custom_words` on every call; hot paths keep a
+/// [`CustomVocabulary`] instead.
+pub fn apply_custom_words(text: &str, custom_words: &[String], threshold: f64) -> String {
+    CustomVocabulary::new(custom_words).apply(text, threshold)
 }
 
 /// Preserves the case pattern of the original word when applying a replacement
@@ -200,58 +325,111 @@ const FILLER_WORDS: &[&str] = &[
     "ehh",
 ];
 
-static MULTI_SPACE_PATTERN: LazyLock<Regex> = LazyLock::new(|| Regex::new(r"\s{2,}").unwrap());
+/// All filler words in one case-insensitive alternation, longest first, each
+/// optionally followed by a comma or period.
+static FILLER_PATTERN: LazyLock<Regex> = LazyLock::new(|| {
+    let mut words = FILLER_WORDS.to_vec();
+    words.sort_by_key(|word| std::cmp::Reverse(word.len()));
+    let alternation = words
+        .iter()
+        .map(|word| regex::escape(word))
+        .collect::<Vec<_>>()
+        .join("|");
+    Regex::new(&format!(r"(?i)\b(?:{})\b[,.]?", alternation)).unwrap()
+});
 
-/// Collapses repeated 1-2 letter words (3+ repetitions) to a single instance.
-/// E.g., "wh wh wh wh" -> "wh", "I I I I" -> "I"
-fn collapse_stutters(text: &str) -> String {
-    let words: Vec<&str> = text.split_whitespace().collect();
-    if words.is_empty() {
-        return text.to_string();
+thread_local! {
+    /// Intermediate buffers reused across transcripts on the same thread.
+    static PIPELINE_SCRATCH: RefCell<(String, String)> = const {
+        RefCell::new((String::new(), String::new()))
+    };
+}
+
+/// Appends `text` to `out` with every filler word match removed.
+fn remove_fillers_into(text: &str, out: &mut String) {
+    let mut last = 0;
+    for m in FILLER_PATTERN.find_iter(text) {
+        out.push_str(&text[last..m.start()]);
+        last = m.end();
     }
+    out.push_str(&text[last..]);
+}
 
-    let mut result: Vec<&str> = Vec::new();
-    let mut i = 0;
+/// 1-2 letter alphabetic words (after lowercasing) are stutter candidates.
+fn is_stutter_candidate(word: &str) -> bool {
+    let mut lower_len = 0;
+    for c in word.chars().flat_map(char::to_lowercase) {
+        if !c.is_alphabetic() {
+            return false;
+        }
+        lower_len += c.len_utf8();
+    }
+    lower_len <= 2
+}
 
-    while i < words.len() {
-        let word = words[i];
-        let word_lower = word.to_lowercase();
+fn eq_lowercase(a: &str, b: &str) -> bool {
+    a.chars()
+        .flat_map(char::to_lowercase)
+        .eq(b.chars().flat_map(char::to_lowercase))
+}
 
-        // Only process 1-2 letter words
-        if word_lower.len() <= 2 && word_lower.chars().all(|c| c.is_alphabetic()) {
-            // Count consecutive repetitions (case-insensitive)
-            let mut count = 1;
-            while i + count < words.len() && words[i + count].to_lowercase() == word_lower {
-                count += 1;
-            }
+/// Appends the whitespace-separated words of `text` to `out`, single-spaced,
+/// collapsing 3+ consecutive repetitions of a 1-2 letter word (compared
+/// case-insensitively) to its first instance.
+/// E.g., "wh wh wh wh" -> "wh", "I I I I" -> "I"
+fn collapse_stutters_into(text: &str, out: &mut String) {
+    let mut push = |word: &str| {
+        if !out.is_empty() {
+            out.push(' ');
+        }
+        out.push_str(word);
+    };
 
-            // If 3+ repetitions, collapse to single instance
-            if count >= 3 {
-                result.push(word);
-                i += count;
-            } else {
-                result.push(word);
-                i += 1;
+    let mut words = text.split_whitespace().peekable();
+    while let Some(word) = words.next() {
+        if !is_stutter_candidate(word) {
+            push(word);
+            continue;
+        }
+        // Fewer than three repetitions are kept as spoken, so only the second
+        // one needs to be held back until the run length is known.
+        let mut second = None;
+        let mut count = 1;
+        while let Some(next) = words.next_if(|next| eq_lowercase(next, word)) {
+            if count == 1 {
+                second = Some(next);
             }
-        } else {
-            result.push(word);
-            i += 1;
+            count += 1;
+        }
+        push(word);
+        if count == 2 {
+            push(second.unwrap_or(word));
         }
     }
-
-    result.join(" ")
 }
 
-/// Pre-compiled filler word patterns (built lazily)
-static FILLER_PATTERNS: LazyLock<Vec<Regex>> = LazyLock::new(|| {
-    FILLER_WORDS
-        .iter()
-        .map(|word| {
-            // Match filler word with word boundaries, optionally followed by comma or period
-            Regex::new(&format!(r"(?i)\b{}\b[,.]?", regex::escape(word))).unwrap()
-        })
-        .collect()
-});
+/// Applies custom word corrections (when `vocabulary` is given and not empty)
+/// and then the output filters of [`filter_transcription_output`].
+///
+/// Stages write into per-thread scratch buffers, so the returned string is the
+/// only allocation per transcript once the buffers have grown.
+pub fn process_transcript(text: &str, vocabulary: Option<(&CustomVocabulary, f64)>) -> String {
+    PIPELINE_SCRATCH.with_borrow_mut(|(corrected, defillered)| {
+        let mut source = text;
+        if let Some((vocabulary, threshold)) = vocabulary.filter(|(v, _)| !v.is_empty()) {
+            corrected.clear();
+            vocabulary.apply_into(text, threshold, corrected);
+            source = corrected;
+        }
+
+        defillered.clear();
+        remove_fillers_into(source, defillered);
+
+        let mut out = String::with_capacity(defillered.len());
+        collapse_stutters_into(defillered, &mut out);
+        out
+    })
+}
 
 /// Filters transcription output by removing filler words and stutter artifacts.
 ///
@@ -266,21 +444,7 @@ static FILLER_PATTERNS: LazyLock<Vec<Regex>> = LazyLock::new(|| {
 /// # Returns
 /// The filtered text with filler words and stutters removed
 pub fn filter_transcription_output(text: &str) -> String {
-    let mut filtered = text.to_string();
-
-    // Remove filler words
-    for pattern in FILLER_PATTERNS.iter() {
-        filtered = pattern.replace_all(&filtered, "").to_string();
-    }
-
-    // Collapse repeated 1-2 letter words (stutter artifacts like "wh wh wh wh")
-    filtered = collapse_stutters(&filtered);
-
-    // Clean up multiple spaces to single space
-    filtered = MULTI_SPACE_PATTERN.replace_all(&filtered, " ").to_string();
-
-    // Trim leading/trailing whitespace
-    filtered.trim().to_string()
+    process_transcript(text, None)
 }
 
 #[cfg(test)]
@@ -444,6 +608,59 @@ mod tests {
         assert!(result.contains("MacBook"));
     }
 
+    #[test]
+    fn test_filter_stutter_respects_unicode_case() {
+        let text = "É é É ça";
+        let result = filter_transcription_output(text);
+        assert_eq!(result, "É ça");
+    }
+
+    #[test]
+    fn test_process_transcript_corrects_then_filters() {
+        let vocabulary = CustomVocabulary::new(&["ChargeBee".to_string()]);
+        let text = "um, we bill through charge b";
+        let result = process_transcript(text, Some((&vocabulary, 0.5)));
+        assert_eq!(result, "we bill through ChargeBee");
+        assert_eq!(process_transcript(text, None), "we bill through charge b");
+    }
+
+    #[test]
+    fn test_soundex_code() {
+        assert_eq!(soundex_code("robert"), Some(*b"R163"));
+        assert_eq!(soundex_code("rupert"), Some(*b"R163"));
+        assert_eq!(soundex_code("tymczak"), Some(*b"T522"));
+        assert_eq!(soundex_code("pfister"), Some(*b"P236"));
+        assert_eq!(soundex_code("ashcraft"), Some(*b"A261"));
+        assert_eq!(soundex_code("42"), None);
+    }
+
+    #[test]
+    fn test_bounded_levenshtein_matches_full_distance() {
+        let pairs = [("kitten", "sitting"), ("chargeb", "chargebee"), ("", "abc")];
+        for (a, b) in pairs {
+            let a: Vec<char> = a.chars().collect();
+            let b: Vec<char> = b.chars().collect();
+            let full = strsim::generic_levenshtein(&a, &b);
+            assert_eq!(bounded_levenshtein(&a, &b, full), Some(full));
+            if full > 0 {
+                assert_eq!(bounded_levenshtein(&a, &b, full - 1), None);
+            }
+        }
+    }
+
+    #[test]
+    fn test_custom_vocabulary_large_dictionary() {
+        let mut custom_words: Vec<String> = (0..5000).map(|i| format!("Product{}", i)).collect();
+        custom_words.push("ChargeBee".to_string());
+        custom_words.push("Chargebee".to_string());
+        let vocabulary = CustomVocabulary::new(&custom_words);
+        assert_eq!(vocabulary.len(), 5002);
+
+        // Equal scores resolve to the word configured first.
+        let result = vocabulary.apply("invoices come from charge b", 0.5);
+        assert_eq!(result, "invoices come from ChargeBee");
+    }
+
     #[test]
     fn test_apply_custom_words_trailing_number_not_doubled() {
         // Verify that trailing non-alpha chars (like numbers) aren't double-counted
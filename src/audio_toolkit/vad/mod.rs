@@ -22,6 +22,44 @@ pub trait VoiceActivityDetector: Send + Sync {
         Ok(self.push_frame(frame)?.is_speech())
     }
 
+    /// Number of frames this detector wants to evaluate per model call.
+    fn frames_per_call(&self) -> usize {
+        1
+    }
+
+    /// Classifies consecutive `frame_len`-sample frames in `samples`, pushing
+    /// one decision per frame to `out`.
+    fn classify_frames(
+        &mut self,
+        samples: &[f32],
+        frame_len: usize,
+        out: &mut Vec<bool>,
+    ) -> Result<()> {
+        for frame in samples.chunks(frame_len) {
+            out.push(self.is_voice(frame)?);
+        }
+        Ok(())
+    }
+
+    /// Streaming API for detectors that may hold frames back to batch them:
+    /// `emit` is called once per frame decided so far, in order. Frames that
+    /// fail to classify are emitted as speech before the error is returned.
+    fn push_frame_with(&mut self, frame: &[f32], emit: &mut dyn FnMut(VadFrame<'_>)) -> Result<()> {
+        match self.push_frame(frame) {
+            Ok(decided) => emit(decided),
+            Err(e) => {
+                emit(VadFrame::Speech(frame));
+                return Err(e);
+            }
+        }
+        Ok(())
+    }
+
+    /// Decides any frames still held back by `push_frame_with`.
+    fn flush(&mut self, _emit: &mut dyn FnMut(VadFrame<'_>)) -> Result<()> {
+        Ok(())
+    }
+
     fn reset(&mut self) {}
 }
 
@@ -9,10 +9,13 @@ use crate::audio_toolkit::constants;
 const SILERO_FRAME_MS: u32 = 30;
 const SILERO_FRAME_SAMPLES: usize =
     (constants::WHISPER_SAMPLE_RATE * SILERO_FRAME_MS / 1000) as usize;
+/// Longer windows blur onsets more than they save.
+const MAX_FRAMES_PER_CALL: usize = 8;
 
 pub struct SileroVad {
     engine: Vad,
     threshold: f32,
+    frames_per_call: usize,
 }
 
 impl SileroVad {
@@ -25,8 +28,26 @@ impl SileroVad {
             engine: Vad::new(&model_path, constants::WHISPER_SAMPLE_RATE as usize)
                 .map_err(|e| anyhow::anyhow!("Failed to create VAD: {e}"))?,
             threshold,
+            frames_per_call: 1,
         })
     }
+
+    /// Evaluates `frames` consecutive frames as one model window. The model
+    /// is recurrent, so the frames cannot go into separate batch rows; one
+    /// longer window keeps its state continuous while cutting calls by the
+    /// same factor, at the cost of one decision per window.
+    pub fn with_frames_per_call(mut self, frames: usize) -> Self {
+        self.frames_per_call = frames.clamp(1, MAX_FRAMES_PER_CALL);
+        self
+    }
+
+    fn speech_probability(&mut self, samples: &[f32]) -> Result<f32> {
+        let result = self
+            .engine
+            .compute(samples)
+            .map_err(|e| anyhow::anyhow!("Silero VAD error: {e}"))?;
+        Ok(result.prob)
+    }
 }
 
 impl VoiceActivityDetector for SileroVad {
@@ -38,15 +59,36 @@ impl VoiceActivityDetector for SileroVad {
             );
         }
 
-        let result = self
-            .engine
-            .compute(frame)
-            .map_err(|e| anyhow::anyhow!("Silero VAD error: {e}"))?;
-
-        if result.prob > self.threshold {
+        if self.speech_probability(frame)? > self.threshold {
             Ok(VadFrame::Speech(frame))
         } else {
             Ok(VadFrame::Noise)
         }
     }
+
+    fn frames_per_call(&self) -> usize {
+        self.frames_per_call
+    }
+
+    fn classify_frames(
+        &mut self,
+        samples: &[f32],
+        frame_len: usize,
+        out: &mut Vec<bool>,
+    ) -> Result<()> {
+        if frame_len != SILERO_FRAME_SAMPLES || !samples.len().is_multiple_of(frame_len) {
+            anyhow::bail!(
+                "expected whole {SILERO_FRAME_SAMPLES}-sample frames, got {} samples",
+                samples.len()
+            );
+        }
+
+        // `samples` is already contiguous, so each window goes to the model
+        // without being copied.
+        for window in samples.chunks(self.frames_per_call * frame_len) {
+            let is_voice = self.speech_probability(window)? > self.threshold;
+            out.extend(std::iter::repeat_n(is_voice, window.len() / frame_len));
+        }
+        Ok(())
+    }
 }
@@ -1,6 +1,68 @@
 use super::{VadFrame, VoiceActivityDetector};
 use anyhow::Result;
-use std::collections::VecDeque;
+
+/// Fixed-capacity ring of the most recent frames, kept for speech pre-roll.
+///
+/// Every frame is written twice, at its slot and at the mirrored slot one
+/// ring length further, so the latest `n` frames are always one contiguous
+/// slice and onset can hand them out without assembling a copy.
+struct PrerollRing {
+    frames: usize,
+    frame_len: usize,
+    buf: Vec<f32>,
+    /// Slot the next frame is written to.
+    next: usize,
+    filled: usize,
+}
+
+impl PrerollRing {
+    fn new(frames: usize) -> Self {
+        Self {
+            frames,
+            frame_len: 0,
+            buf: Vec::new(),
+            next: 0,
+            filled: 0,
+        }
+    }
+
+    fn push(&mut self, frame: &[f32]) {
+        if frame.len() != self.frame_len {
+            // Sized on the first frame; callers feed fixed-length frames, so
+            // this only allocates again if the frame length ever changes.
+            self.frame_len = frame.len();
+            self.buf.clear();
+            self.buf.resize(2 * self.frames * self.frame_len, 0.0);
+            self.clear();
+        }
+        let len = self.frame_len;
+        let slot = self.next * len;
+        let mirror = slot + self.frames * len;
+        self.buf[slot..slot + len].copy_from_slice(frame);
+        self.buf[mirror..mirror + len].copy_from_slice(frame);
+        self.next = (self.next + 1) % self.frames;
+        self.filled = (self.filled + 1).min(self.frames);
+    }
+
+    /// Up to `count` buffered frames, oldest first, ending `back` frames
+    /// before the latest push.
+    fn span(&self, count: usize, back: usize) -> &[f32] {
+        let count = count.min(self.filled - back);
+        let end = (self.next + self.frames - back) * self.frame_len;
+        &self.buf[end - count * self.frame_len..end]
+    }
+
+    fn clear(&mut self) {
+        self.next = 0;
+        self.filled = 0;
+    }
+}
+
+enum Decision {
+    Noise,
+    Frame,
+    Onset,
+}
 
 pub struct SmoothedVad {
     inner_vad: Box<dyn VoiceActivityDetector>,
@@ -8,12 +70,15 @@ pub struct SmoothedVad {
     hangover_frames: usize,
     onset_frames: usize,
 
-    frame_buffer: VecDeque<Vec<f32>>,
+    /// Prefill frames plus the frames awaiting a batched decision.
+    preroll: PrerollRing,
+    frames_per_call: usize,
+    /// Frames pushed through `push_frame_with` that are not decided yet.
+    pending: usize,
+    decisions: Vec<bool>,
     hangover_counter: usize,
     onset_counter: usize,
     in_speech: bool,
-
-    temp_out: Vec<f32>,
 }
 
 impl SmoothedVad {
@@ -23,31 +88,24 @@ impl SmoothedVad {
         hangover_frames: usize,
         onset_frames: usize,
     ) -> Self {
+        let frames_per_call = inner_vad.frames_per_call().max(1);
         Self {
             inner_vad,
             prefill_frames,
             hangover_frames,
             onset_frames,
-            frame_buffer: VecDeque::new(),
+            preroll: PrerollRing::new(prefill_frames + frames_per_call),
+            frames_per_call,
+            pending: 0,
+            decisions: Vec::with_capacity(frames_per_call),
             hangover_counter: 0,
             onset_counter: 0,
             in_speech: false,
-            temp_out: Vec::new(),
         }
     }
-}
-
-impl VoiceActivityDetector for SmoothedVad {
-    fn push_frame<'a>(&'a mut self, frame: &'a [f32]) -> Result<VadFrame<'a>> {
-        // 1. Buffer every incoming frame for possible pre-roll
-        self.frame_buffer.push_back(frame.to_vec());
-        while self.frame_buffer.len() > self.prefill_frames + 1 {
-            self.frame_buffer.pop_front();
-        }
-
-        // 2. Delegate to the wrapped boolean VAD
-        let is_voice = self.inner_vad.is_voice(frame)?;
 
+    /// Advances the onset/hangover state machine by one frame.
+    fn step(&mut self, is_voice: bool) -> Decision {
         match (self.in_speech, is_voice) {
             // Potential start of speech - need to accumulate onset frames
             (false, true) => {
@@ -57,49 +115,230 @@ impl VoiceActivityDetector for SmoothedVad {
                     self.in_speech = true;
                     self.hangover_counter = self.hangover_frames;
                     self.onset_counter = 0; // Reset for next time
-
-                    // Collect prefill + current frame
-                    self.temp_out.clear();
-                    for buf in &self.frame_buffer {
-                        self.temp_out.extend(buf);
-                    }
-                    Ok(VadFrame::Speech(&self.temp_out))
+                    Decision::Onset
                 } else {
                     // Not enough frames yet, still silence
-                    Ok(VadFrame::Noise)
+                    Decision::Noise
                 }
             }
 
             // Ongoing Speech
             (true, true) => {
                 self.hangover_counter = self.hangover_frames;
-                Ok(VadFrame::Speech(frame))
+                Decision::Frame
             }
 
             // End of Speech or interruption during onset phase
             (true, false) => {
                 if self.hangover_counter > 0 {
                     self.hangover_counter -= 1;
-                    Ok(VadFrame::Speech(frame))
+                    Decision::Frame
                 } else {
                     self.in_speech = false;
-                    Ok(VadFrame::Noise)
+                    Decision::Noise
                 }
             }
 
             // Silence or broken onset sequence
             (false, false) => {
                 self.onset_counter = 0; // Reset onset counter on silence
-                Ok(VadFrame::Noise)
+                Decision::Noise
             }
         }
     }
 
+    /// Classifies the pending frames in one call and emits them in order.
+    fn decide_pending(&mut self, emit: &mut dyn FnMut(VadFrame<'_>)) -> Result<()> {
+        if self.pending == 0 {
+            return Ok(());
+        }
+        let frame_len = self.preroll.frame_len;
+        self.decisions.clear();
+        let classified = self.inner_vad.classify_frames(
+            self.preroll.span(self.pending, 0),
+            frame_len,
+            &mut self.decisions,
+        );
+        let pending = std::mem::take(&mut self.pending);
+        if classified.is_err() || self.decisions.len() != pending {
+            // Keep the audio rather than drop it, as for unbatched errors.
+            self.decisions.clear();
+            self.decisions.resize(pending, true);
+        }
+
+        for i in 0..pending {
+            let back = pending - 1 - i;
+            let frame = match self.step(self.decisions[i]) {
+                Decision::Noise => VadFrame::Noise,
+                Decision::Frame => VadFrame::Speech(self.preroll.span(1, back)),
+                // Prefill + this frame
+                Decision::Onset => {
+                    VadFrame::Speech(self.preroll.span(self.prefill_frames + 1, back))
+                }
+            };
+            emit(frame);
+        }
+        classified
+    }
+}
+
+impl VoiceActivityDetector for SmoothedVad {
+    fn push_frame<'a>(&'a mut self, frame: &'a [f32]) -> Result<VadFrame<'a>> {
+        // 1. Buffer every incoming frame for possible pre-roll
+        self.preroll.push(frame);
+
+        // 2. Delegate to the wrapped boolean VAD
+        let is_voice = self.inner_vad.is_voice(frame)?;
+
+        Ok(match self.step(is_voice) {
+            Decision::Noise => VadFrame::Noise,
+            Decision::Frame => VadFrame::Speech(frame),
+            // Prefill + current frame
+            Decision::Onset => VadFrame::Speech(self.preroll.span(self.prefill_frames + 1, 0)),
+        })
+    }
+
+    fn push_frame_with(&mut self, frame: &[f32], emit: &mut dyn FnMut(VadFrame<'_>)) -> Result<()> {
+        if self.frames_per_call == 1 {
+            match self.push_frame(frame) {
+                Ok(decided) => emit(decided),
+                Err(e) => {
+                    emit(VadFrame::Speech(frame));
+                    return Err(e);
+                }
+            }
+            return Ok(());
+        }
+
+        if frame.len() != self.preroll.frame_len {
+            // The ring is about to be resized; decide what it still holds.
+            self.decide_pending(emit)?;
+        }
+        self.preroll.push(frame);
+        self.pending += 1;
+        if self.pending == self.frames_per_call {
+            self.decide_pending(emit)?;
+        }
+        Ok(())
+    }
+
+    fn flush(&mut self, emit: &mut dyn FnMut(VadFrame<'_>)) -> Result<()> {
+        self.decide_pending(emit)
+    }
+
     fn reset(&mut self) {
-        self.frame_buffer.clear();
+        self.preroll.clear();
+        self.pending = 0;
         self.hangover_counter = 0;
         self.onset_counter = 0;
         self.in_speech = false;
-        self.temp_out.clear();
+        self.inner_vad.reset();
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    /// Treats any frame whose first sample is positive as voice.
+    struct SignVad;
+
+    impl VoiceActivityDetector for SignVad {
+        fn push_frame<'a>(&'a mut self, frame: &'a [f32]) -> Result<VadFrame<'a>> {
+            if frame[0] > 0.0 {
+                Ok(VadFrame::Speech(frame))
+            } else {
+                Ok(VadFrame::Noise)
+            }
+        }
+    }
+
+    /// `SignVad` that asks to be called with several frames at once.
+    struct BatchedSignVad {
+        frames_per_call: usize,
+    }
+
+    impl VoiceActivityDetector for BatchedSignVad {
+        fn push_frame<'a>(&'a mut self, frame: &'a [f32]) -> Result<VadFrame<'a>> {
+            SignVad.push_frame(frame).map(|_| VadFrame::Noise)
+        }
+
+        fn frames_per_call(&self) -> usize {
+            self.frames_per_call
+        }
+
+        fn classify_frames(
+            &mut self,
+            samples: &[f32],
+            frame_len: usize,
+            out: &mut Vec<bool>,
+        ) -> Result<()> {
+            out.extend(samples.chunks(frame_len).map(|frame| frame[0] > 0.0));
+            Ok(())
+        }
+    }
+
+    /// Runs `values` through `vad`, recording kept samples and boundaries.
+    fn run(vad: &mut SmoothedVad, values: &[f32]) -> Vec<Option<Vec<f32>>> {
+        let mut out = Vec::new();
+        let mut record = |decided: VadFrame<'_>| {
+            out.push(match decided {
+                VadFrame::Speech(buf) => Some(buf.to_vec()),
+                VadFrame::Noise => None,
+            })
+        };
+        for &value in values {
+            vad.push_frame_with(&frame(value), &mut record).unwrap();
+        }
+        vad.flush(&mut record).unwrap();
+        out
+    }
+
+    fn frame(value: f32) -> [f32; 4] {
+        [value; 4]
+    }
+
+    #[test]
+    fn onset_emits_prefill_in_order_after_ring_wraps() {
+        let mut vad = SmoothedVad::new(Box::new(SignVad), 2, 1, 2);
+        for value in [-1.0, -2.0, -3.0, -4.0, -5.0] {
+            assert!(!vad.push_frame(&frame(value)).unwrap().is_speech());
+        }
+        assert!(!vad.push_frame(&frame(6.0)).unwrap().is_speech());
+        match vad.push_frame(&frame(7.0)).unwrap() {
+            VadFrame::Speech(buf) => {
+                let expected: Vec<f32> = [-5.0, 6.0, 7.0].iter().flat_map(|&v| frame(v)).collect();
+                assert_eq!(buf, expected.as_slice());
+            }
+            VadFrame::Noise => panic!("expected speech onset"),
+        }
+
+        // One hangover frame, then back to silence.
+        assert!(vad.push_frame(&frame(-8.0)).unwrap().is_speech());
+        assert!(!vad.push_frame(&frame(-9.0)).unwrap().is_speech());
+    }
+
+    #[test]
+    fn onset_after_reset_only_emits_frames_since_reset() {
+        let mut vad = SmoothedVad::new(Box::new(SignVad), 5, 0, 1);
+        vad.push_frame(&frame(-1.0)).unwrap();
+        vad.reset();
+        match vad.push_frame(&frame(2.0)).unwrap() {
+            VadFrame::Speech(buf) => assert_eq!(buf, frame(2.0)),
+            VadFrame::Noise => panic!("expected speech onset"),
+        }
+    }
+
+    #[test]
+    fn batched_decisions_match_frame_by_frame() {
+        let values = [
+            -1.0, -2.0, 3.0, 4.0, 5.0, -6.0, -7.0, -8.0, 9.0, -10.0, 11.0, 12.0, -13.0,
+        ];
+        let mut single = SmoothedVad::new(Box::new(SignVad), 3, 1, 2);
+        let expected = run(&mut single, &values);
+
+        let mut batched =
+            SmoothedVad::new(Box::new(BatchedSignVad { frames_per_call: 4 }), 3, 1, 2);
+        assert_eq!(run(&mut batched, &values), expected);
     }
 }
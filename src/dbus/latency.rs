@@ -0,0 +1,363 @@
+//! Per-session stage timing.
+//!
+//! Each session records when it reaches the stages of the dictation path.
+//! When the session ends, the intervals between stages are folded into
+//! fixed-bucket histograms and the timeline is kept in a short ring that can
+//! be exported as a Chrome trace (chrome://tracing, Perfetto).
+
+use serde_json::{json, Value};
+use std::collections::{HashMap, VecDeque};
+use std::sync::{Mutex, OnceLock};
+use std::time::{Duration, Instant};
+
+/// Upper bucket bounds in milliseconds; one more bucket takes the overflow.
+const BUCKET_BOUNDS_MS: [u64; 14] = [
+    1, 2, 5, 10, 20, 50, 100, 200, 500, 1000, 2000, 5000, 10000, 30000,
+];
+const BUCKET_COUNT: usize = BUCKET_BOUNDS_MS.len() + 1;
+/// Finished timelines kept for trace export.
+const TRACE_HISTORY: usize = 32;
+/// A shortcut press older than this is not attributed to a new session.
+const PRESS_ATTRIBUTION_WINDOW: Duration = Duration::from_secs(5);
+
+#[derive(Clone, Copy, Debug, PartialEq, Eq)]
+pub enum Stage {
+    /// Global shortcut press, or the start request when there was none.
+    Press,
+    RecorderOpen,
+    FirstSpeech,
+    Stop,
+    /// Recorder drained and the samples handed back.
+    Captured,
+    ModelReady,
+    Decoded,
+    PostProcessed,
+    Ready,
+    /// The IBus engine took the pending commit.
+    Claimed,
+}
+
+const STAGE_COUNT: usize = Stage::Claimed as usize + 1;
+
+const ALL_STAGES: [Stage; STAGE_COUNT] = [
+    Stage::Press,
+    Stage::RecorderOpen,
+    Stage::FirstSpeech,
+    Stage::Stop,
+    Stage::Captured,
+    Stage::ModelReady,
+    Stage::Decoded,
+    Stage::PostProcessed,
+    Stage::Ready,
+    Stage::Claimed,
+];
+
+/// Reported intervals as (name, from, to). A session contributes only the
+/// intervals whose two stages it reached.
+const INTERVALS: [(&str, Stage, Stage); 8] = [
+    ("press_to_recording", Stage::Press, Stage::RecorderOpen),
+    ("press_to_first_speech", Stage::Press, Stage::FirstSpeech),
+    ("stop_to_captured", Stage::Stop, Stage::Captured),
+    ("model_load_wait", Stage::Captured, Stage::ModelReady),
+    ("decode", Stage::ModelReady, Stage::Decoded),
+    ("post_process", Stage::Decoded, Stage::PostProcessed),
+    ("ready_to_claimed", Stage::Ready, Stage::Claimed),
+    ("stop_to_claimed", Stage::Stop, Stage::Claimed),
+];
+
+static LAST_SHORTCUT_PRESS: OnceLock<Mutex<Option<Instant>>> = OnceLock::new();
+
+fn last_shortcut_press() -> &'static Mutex<Option<Instant>> {
+    LAST_SHORTCUT_PRESS.get_or_init(|| Mutex::new(None))
+}
+
+/// Called by the global shortcut listener when a press starts a recording,
+/// so the session it leads to is timed from the key press.
+pub fn note_shortcut_press() {
+    if let Ok(mut press) = last_shortcut_press().lock() {
+        *press = Some(Instant::now());
+    }
+}
+
+fn take_recent_shortcut_press(now: Instant) -> Option<Instant> {
+    last_shortcut_press()
+        .lock()
+        .ok()?
+        .take()
+        .filter(|press| now.saturating_duration_since(*press) <= PRESS_ATTRIBUTION_WINDOW)
+}
+
+type Timeline = [Option<Instant>; STAGE_COUNT];
+
+#[derive(Clone, Copy)]
+struct Histogram {
+    buckets: [u64; BUCKET_COUNT],
+    count: u64,
+    sum_us: u64,
+    max_us: u64,
+}
+
+impl Default for Histogram {
+    fn default() -> Self {
+        Self {
+            buckets: [0; BUCKET_COUNT],
+            count: 0,
+            sum_us: 0,
+            max_us: 0,
+        }
+    }
+}
+
+impl Histogram {
+    fn record(&mut self, elapsed: Duration) {
+        let us = elapsed.as_micros().min(u128::from(u64::MAX)) as u64;
+        let bucket = BUCKET_BOUNDS_MS
+            .iter()
+            .position(|bound_ms| us <= bound_ms * 1000)
+            .unwrap_or(BUCKET_BOUNDS_MS.len());
+        self.buckets[bucket] += 1;
+        self.count += 1;
+        self.sum_us = self.sum_us.saturating_add(us);
+        self.max_us = self.max_us.max(us);
+    }
+
+    /// Upper bound of the bucket holding the `q` quantile; the overflow
+    /// bucket reports the largest value seen.
+    fn quantile_ms(&self, q: f64) -> f64 {
+        if self.count == 0 {
+            return 0.0;
+        }
+        let rank = ((self.count as f64 * q).ceil() as u64).max(1);
+        let mut seen = 0;
+        for (index, count) in self.buckets.iter().enumerate() {
+            seen += count;
+            if seen >= rank {
+                return match BUCKET_BOUNDS_MS.get(index) {
+                    Some(bound_ms) => (*bound_ms as f64).min(self.max_us as f64 / 1000.0),
+                    None => self.max_us as f64 / 1000.0,
+                };
+            }
+        }
+        self.max_us as f64 / 1000.0
+    }
+
+    fn to_json(self) -> Value {
+        let buckets: Vec<Value> = self
+            .buckets
+            .iter()
+            .enumerate()
+            .map(|(index, count)| {
+                json!({
+                    "le_ms": BUCKET_BOUNDS_MS.get(index),
+                    "count": count,
+                })
+            })
+            .collect();
+        let mean_ms = if self.count == 0 {
+            0.0
+        } else {
+            self.sum_us as f64 / self.count as f64 / 1000.0
+        };
+        json!({
+            "count": self.count,
+            "mean_ms": mean_ms,
+            "max_ms": self.max_us as f64 / 1000.0,
+            "p50_ms": self.quantile_ms(0.50),
+            "p90_ms": self.quantile_ms(0.90),
+            "p99_ms": self.quantile_ms(0.99),
+            "buckets": buckets,
+        })
+    }
+}
+
+struct FinishedSession {
+    session_id: u64,
+    timeline: Timeline,
+}
+
+#[derive(Default)]
+struct Aggregate {
+    histograms: [Histogram; INTERVALS.len()],
+    sessions: u64,
+    recent: VecDeque<FinishedSession>,
+}
+
+pub struct LatencyRecorder {
+    epoch: Instant,
+    open: Mutex<HashMap<u64, Timeline>>,
+    aggregate: Mutex<Aggregate>,
+}
+
+impl Default for LatencyRecorder {
+    fn default() -> Self {
+        Self::new()
+    }
+}
+
+impl LatencyRecorder {
+    pub fn new() -> Self {
+        Self {
+            epoch: Instant::now(),
+            open: Mutex::new(HashMap::new()),
+            aggregate: Mutex::new(Aggregate::default()),
+        }
+    }
+
+    /// Opens a timeline at the shortcut press that led to it, if any.
+    pub fn begin(&self, session_id: u64) {
+        let now = Instant::now();
+        let press = take_recent_shortcut_press(now).unwrap_or(now);
+        let mut timeline = [None; STAGE_COUNT];
+        timeline[Stage::Press as usize] = Some(press);
+        if let Ok(mut open) = self.open.lock() {
+            open.insert(session_id, timeline);
+        }
+    }
+
+    pub fn mark(&self, session_id: u64, stage: Stage) {
+        self.mark_at(session_id, stage, Instant::now());
+    }
+
+    /// Records a stage observed elsewhere, such as the first speech frame on
+    /// the capture thread. Only the first mark of each stage counts.
+    pub fn mark_at(&self, session_id: u64, stage: Stage, at: Instant) {
+        if let Ok(mut open) = self.open.lock() {
+            if let Some(timeline) = open.get_mut(&session_id) {
+                timeline[stage as usize].get_or_insert(at);
+            }
+        }
+    }
+
+    /// Closes the timeline and folds it into the histograms. Later calls for
+    /// the same session do nothing.
+    pub fn finish(&self, session_id: u64) {
+        let Some(timeline) = self
+            .open
+            .lock()
+            .ok()
+            .and_then(|mut open| open.remove(&session_id))
+        else {
+            return;
+        };
+        let Ok(mut aggregate) = self.aggregate.lock() else {
+            return;
+        };
+        for (histogram, (_, from, to)) in aggregate.histograms.iter_mut().zip(INTERVALS) {
+            if let (Some(from), Some(to)) = (timeline[from as usize], timeline[to as usize]) {
+                histogram.record(to.saturating_duration_since(from));
+            }
+        }
+        aggregate.sessions += 1;
+        if aggregate.recent.len() >= TRACE_HISTORY {
+            aggregate.recent.pop_front();
+        }
+        aggregate.recent.push_back(FinishedSession {
+            session_id,
+            timeline,
+        });
+    }
+
+    pub fn stats_json(&self) -> String {
+        let Ok(aggregate) = self.aggregate.lock() else {
+            return json!({ "error": "lock_poisoned" }).to_string();
+        };
+        let intervals: serde_json::Map<String, Value> = INTERVALS
+            .iter()
+            .zip(aggregate.histograms.iter())
+            .map(|((name, _, _), histogram)| (name.to_string(), histogram.to_json()))
+            .collect();
+        json!({
+            "sessions": aggregate.sessions,
+            "open_sessions": self.open.lock().map(|open| open.len()).unwrap_or(0),
+            "intervals": intervals,
+        })
+        .to_string()
+    }
+
+    /// Recent finished sessions in Chrome trace-event format: one track per
+    /// session, one complete event per interval between consecutive stages.
+    pub fn trace_json(&self) -> String {
+        let Ok(aggregate) = self.aggregate.lock() else {
+            return json!({ "traceEvents": [] }).to_string();
+        };
+        let mut events = Vec::new();
+        for session in &aggregate.recent {
+            let reached: Vec<(Stage, Instant)> = ALL_STAGES
+                .iter()
+                .filter_map(|stage| session.timeline[*stage as usize].map(|at| (*stage, at)))
+                .collect();
+            for pair in reached.windows(2) {
+                let ((stage, from), (next, to)) = (pair[0], pair[1]);
+                events.push(json!({
+                    "name": format!("{:?} -> {:?}", stage, next),
+                    "cat": "session",
+                    "ph": "X",
+                    "ts": from.saturating_duration_since(self.epoch).as_micros() as u64,
+                    "dur": to.saturating_duration_since(from).as_micros() as u64,
+                    "pid": std::process::id(),
+                    "tid": session.session_id,
+                }));
+            }
+        }
+        json!({ "traceEvents": events }).to_string()
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn histogram_quantiles_use_bucket_bounds() {
+        let mut histogram = Histogram::default();
+        for ms in [3, 4, 4, 40, 700] {
+            histogram.record(Duration::from_millis(ms));
+        }
+        assert_eq!(histogram.count, 5);
+        assert_eq!(histogram.buckets[2], 3);
+        assert_eq!(histogram.quantile_ms(0.5), 5.0);
+        assert_eq!(histogram.quantile_ms(0.8), 50.0);
+        // Capped at the largest value rather than the 1000 ms bound.
+        assert_eq!(histogram.quantile_ms(0.99), 700.0);
+
+        histogram.record(Duration::from_secs(90));
+        assert_eq!(histogram.buckets[BUCKET_COUNT - 1], 1);
+        assert_eq!(histogram.quantile_ms(1.0), 90_000.0);
+    }
+
+    #[test]
+    fn finish_records_only_reached_intervals_once() {
+        let recorder = LatencyRecorder::new();
+        recorder.begin(7);
+        let press = recorder.open.lock().unwrap()[&7][Stage::Press as usize].unwrap();
+        recorder.mark_at(7, Stage::RecorderOpen, press + Duration::from_millis(30));
+        recorder.mark_at(7, Stage::RecorderOpen, press + Duration::from_millis(90));
+        recorder.mark_at(7, Stage::Stop, press + Duration::from_secs(2));
+        recorder.mark_at(7, Stage::Captured, press + Duration::from_millis(2040));
+        recorder.finish(7);
+        recorder.finish(7);
+        recorder.mark(7, Stage::Claimed);
+
+        let aggregate = recorder.aggregate.lock().unwrap();
+        assert_eq!(aggregate.sessions, 1);
+        let counts: Vec<u64> = aggregate.histograms.iter().map(|h| h.count).collect();
+        assert_eq!(counts, vec![1, 0, 1, 0, 0, 0, 0, 0]);
+        assert_eq!(aggregate.histograms[0].max_us, 30_000);
+        assert_eq!(aggregate.recent.len(), 1);
+    }
+
+    #[test]
+    fn trace_keeps_recent_sessions_only() {
+        let recorder = LatencyRecorder::new();
+        for session_id in 0..(TRACE_HISTORY as u64 + 3) {
+            recorder.begin(session_id);
+            recorder.mark(session_id, Stage::RecorderOpen);
+            recorder.finish(session_id);
+        }
+        let trace: Value = serde_json::from_str(&recorder.trace_json()).unwrap();
+        let events = trace["traceEvents"].as_array().unwrap();
+        assert_eq!(events.len(), TRACE_HISTORY);
+        assert_eq!(events[0]["tid"], 3);
+        assert_eq!(events[0]["name"], "Press -> RecorderOpen");
+    }
+}
@@ -4,6 +4,9 @@
 //! (like the dikt-ibus IBus engine) to control Dikt's transcription
 //! functionality.
 
+mod latency;
 mod server;
+mod sessions;
 
+pub use latency::note_shortcut_press;
 pub use server::{start_dbus_server, stop_dbus_server, DiktDbusState, DiktState};
@@ -3,20 +3,26 @@
 //! This module provides a D-Bus interface that allows the dikt-ibus engine
 //! to control Dikt's transcription functionality.
 
+use crate::audio_toolkit::SampleView;
+use crate::dbus::latency::{LatencyRecorder, Stage};
+use crate::dbus::sessions::{SessionStatusEntry, SessionTable};
 use crate::global_shortcuts::{
     toggle_diagnostics_tuple, toggle_diagnostics_verbose_json, toggle_recent_events,
 };
+use crate::llm_client::provider_for;
 use crate::managers::audio::AudioRecordingManager;
+use crate::managers::segmented::SegmentedTranscription;
 use crate::managers::transcription::TranscriptionManager;
-use crate::settings::{PostProcessProvider, Settings};
+use crate::settings::{settings_snapshot, PostProcessProvider, Settings};
 use crate::text_utils::convert_chinese_variant;
+use crate::utils::executor::{self, WorkerPool};
 use crate::utils::logging::read_recent_logs;
 use crate::{audio_feedback::play_feedback_sound, audio_feedback::SoundType};
 use log::{debug, error, info, warn};
 use serde_json::json;
-use std::collections::{HashMap, HashSet, VecDeque};
+use std::collections::{HashMap, VecDeque};
 use std::sync::atomic::{AtomicBool, AtomicU64, Ordering};
-use std::sync::{Arc, Mutex};
+use std::sync::{mpsc, Arc, Mutex, OnceLock};
 use std::time::{Duration, Instant};
 use zbus::fdo;
 use zbus::object_server::SignalContext;
@@ -24,213 +30,56 @@ use zbus::Connection;
 
 const DIKT_BUS_NAME: &str = "io.dikt.Transcription";
 const DIKT_OBJECT_PATH: &str = "/io/dikt/Transcription";
+const DIKT_INTERFACE: &str = "io.dikt.Transcription";
 
-const MAX_PENDING_COMMIT_QUEUE: usize = 32;
+/// Shortest spacing between live preview polls. Once a preview is decoded the
+/// worker sleeps until the recorder reports new speech, waking this often to
+/// re-check its session.
 const LIVE_PREEDIT_POLL_MS: u64 = 600;
 const LIVE_PREEDIT_MIN_NEW_SAMPLES: usize = 3200;
 const LIVE_PREEDIT_MIN_TOTAL_SAMPLES: usize = 8000;
-const LIVE_PREEDIT_MAX_WINDOW_SAMPLES: usize = 16000 * 8;
 const LIVE_PREEDIT_SNAPSHOT_WARN_EVERY: u64 = 10;
 const SESSION_TTL_MS: u64 = 5 * 60 * 1000;
-
-#[derive(Clone, Debug)]
-struct PendingCommit {
-    session_id: u64,
-    claim_token: String,
-    text: String,
-    created_ms: u64,
-}
-
-struct PendingCommitStore {
-    inner: Mutex<VecDeque<PendingCommit>>,
-    dropped_count: AtomicU64,
-}
-
-impl Default for PendingCommitStore {
-    fn default() -> Self {
-        Self {
-            inner: Mutex::new(VecDeque::with_capacity(MAX_PENDING_COMMIT_QUEUE)),
-            dropped_count: AtomicU64::new(0),
-        }
-    }
-}
-
-impl PendingCommitStore {
-    fn store(&self, session_id: u64, claim_token: String, text: String) {
-        if let Ok(mut queue) = self.inner.lock() {
-            if queue.len() >= MAX_PENDING_COMMIT_QUEUE {
-                let _ = queue.pop_front();
-                self.dropped_count.fetch_add(1, Ordering::SeqCst);
-            }
-            queue.push_back(PendingCommit {
-                session_id,
-                claim_token,
-                text,
-                created_ms: now_millis(),
-            });
-        }
-    }
-
-    fn take_for_session(&self, session_id: u64, claim_token: &str) -> (bool, String) {
-        let Ok(mut queue) = self.inner.lock() else {
-            return (false, String::new());
-        };
-        if let Some(index) = queue
-            .iter()
-            .position(|entry| entry.session_id == session_id && entry.claim_token == claim_token)
-        {
-            return queue
-                .remove(index)
-                .map(|pending| (true, pending.text))
-                .unwrap_or_else(|| (false, String::new()));
-        }
-        (false, String::new())
-    }
-
-    fn has_for_session_claim(&self, session_id: u64, claim_token: &str) -> bool {
-        self.inner
-            .lock()
-            .map(|queue| {
-                queue
-                    .iter()
-                    .any(|entry| entry.session_id == session_id && entry.claim_token == claim_token)
-            })
-            .unwrap_or(false)
-    }
-
-    fn stats_json(&self) -> String {
-        let dropped_count = self.dropped_count.load(Ordering::SeqCst);
-        if let Ok(queue) = self.inner.lock() {
-            let now = now_millis();
-            let oldest_age_ms = queue
-                .front()
-                .map(|entry| now.saturating_sub(entry.created_ms))
-                .unwrap_or(0);
-            let targets = queue
-                .iter()
-                .fold(HashMap::<u64, u64>::new(), |mut acc, item| {
-                    *acc.entry(item.session_id).or_insert(0) += 1;
-                    acc
-                });
-            json!({
-                "queue_len": queue.len(),
-                "oldest_age_ms": oldest_age_ms,
-                "dropped_count": dropped_count,
-                "targets": targets,
-            })
-            .to_string()
-        } else {
-            json!({
-                "queue_len": 0,
-                "oldest_age_ms": 0,
-                "dropped_count": dropped_count,
-                "targets": {},
-                "error": "lock_poisoned",
-            })
-            .to_string()
-        }
-    }
-}
-
-#[derive(Clone, Debug)]
-struct LivePreeditEntry {
-    revision: u64,
-    visible: bool,
-    text: String,
-}
-
-struct LivePreeditStore {
-    inner: Mutex<HashMap<u64, LivePreeditEntry>>,
-}
-
-impl Default for LivePreeditStore {
-    fn default() -> Self {
-        Self {
-            inner: Mutex::new(HashMap::new()),
-        }
-    }
+/// Final decodes share one engine, so a second worker only lets one
+/// session's post-processing overlap the next session's decode.
+const FINALIZE_WORKERS: usize = 2;
+/// Stops queued behind busy workers before new ones are turned away.
+const FINALIZE_QUEUE_DEPTH: usize = 16;
+const BACKGROUND_QUEUE_DEPTH: usize = 8;
+
+static FINALIZE_POOL: OnceLock<WorkerPool> = OnceLock::new();
+static BACKGROUND_POOL: OnceLock<WorkerPool> = OnceLock::new();
+
+fn finalize_pool() -> &'static WorkerPool {
+    FINALIZE_POOL.get_or_init(|| {
+        WorkerPool::new("dikt-finalize", FINALIZE_WORKERS, FINALIZE_QUEUE_DEPTH)
+            .expect("failed to spawn finalize workers")
+    })
 }
 
-impl LivePreeditStore {
-    fn set(&self, session_id: u64, revision: u64, text: String) {
-        let Ok(mut entries) = self.inner.lock() else {
-            return;
-        };
-
-        if let Some(existing) = entries.get(&session_id) {
-            if existing.revision >= revision {
-                return;
-            }
-        }
-
-        info!(
-            "set_live_preedit: session={}, rev={}, text_len={}",
-            session_id,
-            revision,
-            text.len()
-        );
-        entries.insert(
-            session_id,
-            LivePreeditEntry {
-                revision,
-                visible: true,
-                text,
-            },
-        );
-    }
-
-    fn clear(&self, session_id: u64, revision: u64) {
-        let Ok(mut entries) = self.inner.lock() else {
-            return;
-        };
-
-        if let Some(existing) = entries.get(&session_id) {
-            if existing.revision >= revision {
-                return;
-            }
-        }
-
-        info!(
-            "clear_live_preedit: session={}, rev={}",
-            session_id, revision
-        );
-        entries.insert(
-            session_id,
-            LivePreeditEntry {
-                revision,
-                visible: false,
-                text: String::new(),
-            },
-        );
-    }
-
-    fn get_for_session(&self, session_id: u64) -> (u64, bool, String) {
-        let Ok(entries) = self.inner.lock() else {
-            return (0, false, String::new());
-        };
-
-        entries
-            .get(&session_id)
-            .map(|entry| (entry.revision, entry.visible, entry.text.clone()))
-            .unwrap_or((0, false, String::new()))
-    }
+/// Short side jobs off the D-Bus executor, such as applying the mute.
+fn background_pool() -> &'static WorkerPool {
+    BACKGROUND_POOL.get_or_init(|| {
+        WorkerPool::new("dikt-background", 1, BACKGROUND_QUEUE_DEPTH)
+            .expect("failed to spawn background worker")
+    })
 }
 
+/// Signals emitted from a background thread: per-engine wakeups so the IBus
+/// listener only calls back when there is something to fetch, and microphone
+/// levels for clients holding a level lease.
 #[derive(Clone, Debug)]
-struct SessionStatusEntry {
-    state: String,
-    message: String,
-    updated_ms: u64,
-}
-
-impl SessionStatusEntry {
-    fn new(state: &str, message: &str) -> Self {
-        Self {
-            state: state.to_string(),
-            message: message.to_string(),
-            updated_ms: now_millis(),
-        }
-    }
+enum BusSignal {
+    CommitReady {
+        engine_id: u64,
+        session_id: u64,
+    },
+    LivePreeditChanged {
+        engine_id: u64,
+        session_id: u64,
+        revision: u64,
+    },
+    AudioLevels(Vec<f64>),
 }
 
 /// Shared state for the D-Bus server and handlers
@@ -239,18 +88,16 @@ pub struct DiktState {
     pub recording_manager: Arc<AudioRecordingManager>,
     pub transcription_manager: Arc<TranscriptionManager>,
     pub is_recording: AtomicBool,
-    stopping_sessions: Mutex<HashSet<u64>>,
     session_counter: AtomicU64,
     claim_counter: AtomicU64,
-    pending_commit: PendingCommitStore,
-    live_preedit: LivePreeditStore,
     live_preedit_revision: AtomicU64,
     focused_engine_id: AtomicU64,
     focused_engine_last_change_ms: AtomicU64,
-    session_bindings: Mutex<HashMap<u64, u64>>,
-    session_claim_tokens: Mutex<HashMap<u64, String>>,
-    session_statuses: Mutex<HashMap<u64, SessionStatusEntry>>,
+    sessions: Mutex<SessionTable>,
+    segmented_sessions: Mutex<HashMap<u64, SegmentedTranscription>>,
+    bus_signal_tx: Mutex<Option<mpsc::Sender<BusSignal>>>,
     log_buffer: Arc<Mutex<VecDeque<String>>>,
+    latency: LatencyRecorder,
 }
 
 impl DiktState {
@@ -265,18 +112,16 @@ impl DiktState {
             recording_manager,
             transcription_manager,
             is_recording: AtomicBool::new(false),
-            stopping_sessions: Mutex::new(HashSet::new()),
             session_counter: AtomicU64::new(1),
             claim_counter: AtomicU64::new(1),
-            pending_commit: PendingCommitStore::default(),
-            live_preedit: LivePreeditStore::default(),
             live_preedit_revision: AtomicU64::new(1),
             focused_engine_id: AtomicU64::new(0),
             focused_engine_last_change_ms: AtomicU64::new(now_millis()),
-            session_bindings: Mutex::new(HashMap::new()),
-            session_claim_tokens: Mutex::new(HashMap::new()),
-            session_statuses: Mutex::new(HashMap::new()),
+            sessions: Mutex::new(SessionTable::new(SESSION_TTL_MS, now_millis())),
+            segmented_sessions: Mutex::new(HashMap::new()),
+            bus_signal_tx: Mutex::new(None),
             log_buffer,
+            latency: LatencyRecorder::new(),
         }
     }
 
@@ -298,86 +143,90 @@ impl DiktState {
         )
     }
 
+    /// Runs `f` under the session table lock; `None` if the lock is poisoned.
+    fn with_sessions<R>(&self, f: impl FnOnce(&mut SessionTable) -> R) -> Option<R> {
+        match self.sessions.lock() {
+            Ok(mut sessions) => Some(f(&mut sessions)),
+            Err(e) => {
+                error!("Session table lock poisoned: {}", e);
+                None
+            }
+        }
+    }
+
     fn create_session(&self, target_engine_id: u64) -> (u64, String) {
         let session_id = self.next_session_id();
         let claim_token = self.next_claim_token(session_id);
-        if let Ok(mut bindings) = self.session_bindings.lock() {
-            bindings.insert(session_id, target_engine_id);
-        }
-        if let Ok(mut claims) = self.session_claim_tokens.lock() {
-            claims.insert(session_id, claim_token.clone());
-        }
-        self.set_session_status(session_id, "created", "Session created");
+        self.with_sessions(|sessions| {
+            sessions.insert(
+                session_id,
+                target_engine_id,
+                claim_token.clone(),
+                now_millis(),
+            )
+        });
+        self.latency.begin(session_id);
         (session_id, claim_token)
     }
 
     fn session_binding(&self, session_id: u64) -> Option<u64> {
-        self.session_bindings
-            .lock()
-            .ok()
-            .and_then(|bindings| bindings.get(&session_id).copied())
-    }
-
-    fn session_claim_token(&self, session_id: u64) -> Option<String> {
-        self.session_claim_tokens
-            .lock()
-            .ok()
-            .and_then(|claims| claims.get(&session_id).cloned())
-    }
-
-    fn validate_session_claim(&self, session_id: u64, claim_token: &str) -> bool {
-        self.session_claim_tokens
-            .lock()
-            .ok()
-            .and_then(|claims| claims.get(&session_id).cloned())
-            .is_some_and(|token| token == claim_token)
+        self.with_sessions(|sessions| sessions.engine_id(session_id))
+            .flatten()
     }
 
     fn set_session_status(&self, session_id: u64, state: &str, message: &str) {
         if session_id == 0 {
             return;
         }
-        if let Ok(mut statuses) = self.session_statuses.lock() {
-            statuses.insert(session_id, SessionStatusEntry::new(state, message));
+        self.with_sessions(|sessions| {
+            sessions.set_status(session_id, state, message, now_millis())
+        });
+        if matches!(state, "ready" | "failed" | "cancelled" | "committed") {
+            self.transcription_manager.release_session(session_id);
+        }
+        if matches!(state, "failed" | "cancelled" | "committed") {
+            self.latency.finish(session_id);
         }
     }
 
     fn session_status(&self, session_id: u64) -> Option<SessionStatusEntry> {
-        self.session_statuses
+        self.with_sessions(|sessions| sessions.status(session_id).cloned())
+            .flatten()
+    }
+
+    fn remove_session(&self, session_id: u64) {
+        self.with_sessions(|sessions| sessions.remove(session_id));
+        self.release_session_resources(session_id);
+    }
+
+    /// Everything tied to a session outside the table.
+    fn release_session_resources(&self, session_id: u64) {
+        self.cancel_segmented_transcription(session_id);
+        self.transcription_manager.release_session(session_id);
+        self.latency.finish(session_id);
+    }
+
+    fn take_segmented_transcription(&self, session_id: u64) -> Option<SegmentedTranscription> {
+        self.segmented_sessions
             .lock()
             .ok()
-            .and_then(|statuses| statuses.get(&session_id).cloned())
+            .and_then(|mut sessions| sessions.remove(&session_id))
     }
 
-    fn remove_session(&self, session_id: u64) {
-        if let Ok(mut bindings) = self.session_bindings.lock() {
-            bindings.remove(&session_id);
+    fn cancel_segmented_transcription(&self, session_id: u64) {
+        if let Some(pipeline) = self.take_segmented_transcription(session_id) {
+            pipeline.cancel();
         }
-        if let Ok(mut claims) = self.session_claim_tokens.lock() {
-            claims.remove(&session_id);
-        }
-        if let Ok(mut statuses) = self.session_statuses.lock() {
-            statuses.remove(&session_id);
-        }
-        self.clear_session_stopping(session_id);
     }
 
+    /// Drops terminal sessions past their TTL; the timer wheel only hands
+    /// over the ones that are due, so this is cheap enough to run per call.
     fn cleanup_expired_sessions(&self) {
-        let now = now_millis();
-        let mut expired = Vec::new();
-        if let Ok(statuses) = self.session_statuses.lock() {
-            for (session_id, status) in statuses.iter() {
-                let is_terminal = matches!(
-                    status.state.as_str(),
-                    "ready" | "failed" | "cancelled" | "committed"
-                );
-                if is_terminal && now.saturating_sub(status.updated_ms) > SESSION_TTL_MS {
-                    expired.push(*session_id);
-                }
-            }
-        }
+        let expired = self
+            .with_sessions(|sessions| sessions.expire(now_millis()))
+            .unwrap_or_default();
         for session_id in expired {
-            self.remove_session(session_id);
+            self.release_session_resources(session_id);
         }
     }
 
@@ -386,43 +235,31 @@ impl DiktState {
             return (0, String::new(), false);
         }
         self.cleanup_expired_sessions();
-        let Ok(bindings) = self.session_bindings.lock() else {
-            return (0, String::new(), false);
-        };
-        let bindings_snapshot = bindings.clone();
-        drop(bindings);
-        let Ok(claims) = self.session_claim_tokens.lock() else {
-            return (0, String::new(), false);
-        };
-        let claims_snapshot = claims.clone();
-        drop(claims);
-        let Ok(statuses) = self.session_statuses.lock() else {
-            return (0, String::new(), false);
-        };
-        let statuses_snapshot = statuses.clone();
-        drop(statuses);
-
-        select_active_session_for_engine(
-            engine_id,
-            &bindings_snapshot,
-            &claims_snapshot,
-            &statuses_snapshot,
-            |session_id, claim_token| {
-                self.pending_commit
-                    .has_for_session_claim(session_id, claim_token)
-            },
-        )
+        self.with_sessions(|sessions| sessions.active_session_for_engine(engine_id))
+            .unwrap_or((0, String::new(), false))
     }
 
     fn store_pending_commit(&self, session_id: u64, text: String) {
-        let Some(claim_token) = self.session_claim_token(session_id) else {
-            warn!(
-                "Dropping pending commit for unknown session {} (no claim token)",
-                session_id
-            );
+        let engine_id = self.with_sessions(|sessions| {
+            sessions.store_pending_commit(session_id, text, now_millis())
+        });
+        let Some(Some(engine_id)) = engine_id else {
+            warn!("Dropping pending commit for unknown session {}", session_id);
             return;
         };
-        self.pending_commit.store(session_id, claim_token, text);
+        self.send_bus_signal(BusSignal::CommitReady {
+            engine_id,
+            session_id,
+        });
+    }
+
+    /// Queues a signal for the emitter thread; never blocks the caller.
+    fn send_bus_signal(&self, signal: BusSignal) {
+        if let Ok(tx) = self.bus_signal_tx.lock() {
+            if let Some(tx) = tx.as_ref() {
+                let _ = tx.send(signal);
+            }
+        }
     }
 
     fn take_pending_commit_for_session(
@@ -430,35 +267,74 @@ impl DiktState {
         session_id: u64,
         claim_token: &str,
     ) -> (bool, String) {
-        let result = self
-            .pending_commit
-            .take_for_session(session_id, claim_token);
-        if result.0 {
-            self.set_session_status(session_id, "committed", "Final commit delivered");
-        }
-        result
+        let text = self
+            .with_sessions(|sessions| sessions.take_pending_commit(session_id, claim_token))
+            .flatten();
+        let Some(text) = text else {
+            return (false, String::new());
+        };
+        self.latency.mark(session_id, Stage::Claimed);
+        self.set_session_status(session_id, "committed", "Final commit delivered");
+        (true, text)
     }
 
     fn pending_commit_stats_json(&self) -> String {
-        self.pending_commit.stats_json()
+        self.with_sessions(|sessions| sessions.pending_commit_stats_json(now_millis()))
+            .unwrap_or_else(|| {
+                json!({
+                    "queue_len": 0,
+                    "oldest_age_ms": 0,
+                    "dropped_count": 0,
+                    "targets": {},
+                    "error": "lock_poisoned",
+                })
+                .to_string()
+            })
     }
 
     fn next_live_preedit_revision(&self) -> u64 {
         self.live_preedit_revision.fetch_add(1, Ordering::SeqCst)
     }
 
-    fn set_live_preedit(&self, session_id: u64, revision: u64, text: String) {
+    fn update_live_preedit(&self, session_id: u64, revision: u64, text: Option<String>) {
         if session_id == 0 {
             return;
         }
-        self.live_preedit.set(session_id, revision, text);
+        let text_len = text.as_ref().map(String::len);
+        let engine_id = self
+            .with_sessions(|sessions| {
+                sessions
+                    .set_live_preedit(session_id, revision, text)
+                    .then(|| sessions.engine_id(session_id))
+                    .flatten()
+            })
+            .flatten();
+        let Some(engine_id) = engine_id else {
+            return;
+        };
+        match text_len {
+            Some(text_len) => info!(
+                "set_live_preedit: session={}, rev={}, text_len={}",
+                session_id, revision, text_len
+            ),
+            None => info!(
+                "clear_live_preedit: session={}, rev={}",
+                session_id, revision
+            ),
+        }
+        self.send_bus_signal(BusSignal::LivePreeditChanged {
+            engine_id,
+            session_id,
+            revision,
+        });
+    }
+
+    fn set_live_preedit(&self, session_id: u64, revision: u64, text: String) {
+        self.update_live_preedit(session_id, revision, Some(text));
     }
 
     fn clear_live_preedit(&self, session_id: u64, revision: u64) {
-        if session_id == 0 {
-            return;
-        }
-        self.live_preedit.clear(session_id, revision);
+        self.update_live_preedit(session_id, revision, None);
     }
 
     fn get_live_preedit_for_session(
@@ -466,10 +342,8 @@ impl DiktState {
         session_id: u64,
         claim_token: &str,
     ) -> (u64, bool, String) {
-        if !self.validate_session_claim(session_id, claim_token) {
-            return (0, false, String::new());
-        }
-        self.live_preedit.get_for_session(session_id)
+        self.with_sessions(|sessions| sessions.live_preedit(session_id, claim_token))
+            .unwrap_or((0, false, String::new()))
     }
 
     fn set_focused_engine(&self, engine_id: u64, focused: bool) {
@@ -486,6 +360,9 @@ impl DiktState {
             self.focused_engine_last_change_ms
                 .store(now_millis(), Ordering::SeqCst);
         }
+        if focused && engine_id != 0 {
+            self.transcription_manager.preload_on_focus();
+        }
     }
 
     fn focused_engine_status(&self) -> (u64, u64) {
@@ -496,93 +373,19 @@ impl DiktState {
     }
 
     fn mark_session_stopping(&self, session_id: u64) {
-        if session_id == 0 {
-            return;
-        }
-        if let Ok(mut sessions) = self.stopping_sessions.lock() {
-            sessions.insert(session_id);
-        }
+        self.with_sessions(|sessions| sessions.set_stopping(session_id, true));
     }
 
     fn clear_session_stopping(&self, session_id: u64) {
-        if session_id == 0 {
-            return;
-        }
-        if let Ok(mut sessions) = self.stopping_sessions.lock() {
-            sessions.remove(&session_id);
-        }
+        self.with_sessions(|sessions| sessions.set_stopping(session_id, false));
     }
 
     fn session_is_stopping(&self, session_id: u64) -> bool {
-        if session_id == 0 {
-            return false;
-        }
-        self.stopping_sessions
-            .lock()
-            .map(|sessions| sessions.contains(&session_id))
+        self.with_sessions(|sessions| sessions.is_stopping(session_id))
             .unwrap_or(false)
     }
 }
 
-fn select_active_session_for_engine<F>(
-    engine_id: u64,
-    bindings: &HashMap<u64, u64>,
-    claims: &HashMap<u64, String>,
-    statuses: &HashMap<u64, SessionStatusEntry>,
-    has_pending: F,
-) -> (u64, String, bool)
-where
-    F: Fn(u64, &str) -> bool,
-{
-    let mut best: Option<(u8, u64, u64, String, bool)> = None;
-
-    for (session_id, bound_engine_id) in bindings {
-        if *bound_engine_id != engine_id {
-            continue;
-        }
-        let Some(status) = statuses.get(session_id) else {
-            continue;
-        };
-        let Some(claim_token) = claims.get(session_id) else {
-            continue;
-        };
-
-        let (priority, allow_preedit) = match status.state.as_str() {
-            "recording" => (3, true),
-            "finalizing" => (2, false),
-            "ready" if has_pending(*session_id, claim_token.as_str()) => (1, false),
-            _ => (0, false),
-        };
-        if priority == 0 {
-            continue;
-        }
-
-        let candidate = (
-            priority,
-            status.updated_ms,
-            *session_id,
-            claim_token.clone(),
-            allow_preedit,
-        );
-        if let Some(current) = &best {
-            if candidate.0 > current.0
-                || (candidate.0 == current.0 && candidate.1 > current.1)
-                || (candidate.0 == current.0 && candidate.1 == current.1 && candidate.2 > current.2)
-            {
-                best = Some(candidate);
-            }
-        } else {
-            best = Some(candidate);
-        }
-    }
-
-    if let Some((_, _, session_id, claim_token, allow_preedit)) = best {
-        (session_id, claim_token, allow_preedit)
-    } else {
-        (0, String::new(), false)
-    }
-}
-
 /// D-Bus state for connection management
 pub struct DiktDbusState {
     running: AtomicBool,
@@ -648,7 +451,7 @@ impl DiktTranscription {
     /// Cancel one recording session and clear live preview for that session.
     async fn cancel_recording_session(&self, session_id: u64) -> fdo::Result<bool> {
         self.state.cleanup_expired_sessions();
-        if self.state.session_claim_token(session_id).is_none() {
+        if self.state.session_binding(session_id).is_none() {
             return Ok(false);
         }
 
@@ -657,6 +460,7 @@ impl DiktTranscription {
         let revision = self.state.next_live_preedit_revision();
         self.state.clear_live_preedit(session_id, revision);
         self.state.clear_session_stopping(session_id);
+        self.state.cancel_segmented_transcription(session_id);
 
         if self.state.is_recording.swap(false, Ordering::SeqCst) {
             self.state.recording_manager.cancel_recording();
@@ -702,11 +506,34 @@ impl DiktTranscription {
             .take_pending_commit_for_session(session_id, claim_token.as_str()))
     }
 
+    /// Get model load state and page-cache residency of the model files as JSON.
+    async fn get_model_load_status(&self) -> fdo::Result<String> {
+        let status = self.state.transcription_manager.get_model_load_status();
+        Ok(json!({
+            "is_loading": status.is_loading,
+            "is_loaded": status.is_loaded,
+            "model_id": status.model_id,
+            "mapped_bytes": status.mapped_bytes,
+            "resident_bytes": status.resident_bytes,
+        })
+        .to_string())
+    }
+
     /// Get aggregate pending commit queue stats as JSON.
     async fn get_pending_commit_stats(&self) -> fdo::Result<String> {
         Ok(self.state.pending_commit_stats_json())
     }
 
+    /// Get per-stage latency histograms over finished sessions as JSON.
+    async fn get_latency_stats(&self) -> fdo::Result<String> {
+        Ok(self.state.latency.stats_json())
+    }
+
+    /// Get stage timelines of recent sessions as Chrome trace-event JSON.
+    async fn get_latency_trace(&self) -> fdo::Result<String> {
+        Ok(self.state.latency.trace_json())
+    }
+
     /// Read latest live preedit payload for a specific session claim.
     async fn get_live_preedit_for_session(
         &self,
@@ -747,6 +574,26 @@ impl DiktTranscription {
         Ok(self.state.focused_engine_status())
     }
 
+    /// Start `AudioLevels` signals at up to `rate_hz` updates per second.
+    /// The lease lapses unless renewed within 5 seconds.
+    async fn subscribe_audio_levels(&self, rate_hz: u32) -> fdo::Result<u64> {
+        Ok(self
+            .state
+            .recording_manager
+            .level_meter()
+            .subscribe(rate_hz))
+    }
+
+    /// Keep a level lease alive; false if it already lapsed.
+    async fn renew_audio_levels(&self, lease_id: u64) -> fdo::Result<bool> {
+        Ok(self.state.recording_manager.level_meter().renew(lease_id))
+    }
+
+    /// Stop the `AudioLevels` signals requested by a lease.
+    async fn release_audio_levels(&self, lease_id: u64) -> fdo::Result<bool> {
+        Ok(self.state.recording_manager.level_meter().release(lease_id))
+    }
+
     /// Get recent daemon log lines
     async fn get_recent_logs(&self) -> fdo::Result<Vec<String>> {
         Ok(self.state.recent_logs(400))
@@ -778,11 +625,12 @@ impl DiktTranscription {
                 ));
             }
         }
-        let settings = Settings::new();
-        settings.set_selected_language(&language);
-        self.state
-            .transcription_manager
-            .refresh_config_from_settings(&settings);
+        Settings::new().set_selected_language(&language);
+        // The change signal refreshes the shared snapshot too; apply now so
+        // the next decode already uses the new language.
+        let mut snapshot = (*settings_snapshot()).clone();
+        snapshot.selected_language = language;
+        self.state.transcription_manager.apply_settings(&snapshot);
         Ok(())
     }
 
@@ -807,71 +655,146 @@ struct PostProcessRequest {
     api_key: String,
     model: String,
     prompt_text: String,
+    streaming: bool,
+    /// Deadline after which the raw transcript is used instead.
+    latency_budget: Option<Duration>,
 }
 
 fn build_post_process_request(text: &str) -> Option<PostProcessRequest> {
-    let settings = Settings::new();
-    if !settings.post_process_enabled() {
+    let settings = settings_snapshot();
+    if !settings.post_process_enabled {
         return None;
     }
 
-    let provider_id = settings.post_process_provider_id();
-    let api_key = settings.post_process_api_keys().get(&provider_id)?.clone();
+    let provider_id = &settings.post_process_provider_id;
+    let api_key = settings.post_process_api_keys.get(provider_id)?.clone();
     if api_key.is_empty() {
         return None;
     }
-    let model = settings.post_process_models().get(&provider_id)?.clone();
+    let model = settings.post_process_models.get(provider_id)?.clone();
     if model.is_empty() {
         return None;
     }
 
-    let prompts = settings.post_process_prompts();
-    let selected_id = settings.post_process_selected_prompt_id();
-    let prompt = if let Some(selected) = selected_id {
-        prompts.iter().find(|p| p.id == selected)
+    let prompts = &settings.post_process_prompts;
+    let prompt = if let Some(selected) = &settings.post_process_selected_prompt_id {
+        prompts.iter().find(|p| &p.id == selected)
     } else {
         prompts.first()
     }?;
 
-    let base_url = settings
-        .post_process_base_urls()
-        .get(&provider_id)
-        .cloned()
-        .unwrap_or_else(|| match provider_id.as_str() {
-            "openai" => "https://api.openai.com/v1".to_string(),
-            "anthropic" => "https://api.anthropic.com/v1".to_string(),
-            "openrouter" => "https://openrouter.ai/api/v1".to_string(),
-            "groq" => "https://api.groq.com/openai/v1".to_string(),
-            "cerebras" => "https://api.cerebras.ai/v1".to_string(),
-            _ => "http://localhost:11434/v1".to_string(),
-        });
-    let provider = PostProcessProvider {
-        id: provider_id.clone(),
-        label: provider_id.clone(),
-        base_url,
-        allow_base_url_edit: provider_id == "custom",
-    };
+    let provider = provider_for(provider_id, &settings.post_process_base_urls);
 
     let prompt_text = prompt.prompt.replace("${output}", text);
+    let latency_budget = match settings.post_process_latency_budget_ms {
+        0 => None,
+        ms => Some(Duration::from_millis(u64::from(ms))),
+    };
     Some(PostProcessRequest {
         provider,
         api_key,
         model,
         prompt_text,
+        streaming: settings.post_process_streaming,
+        latency_budget,
     })
 }
 
-async fn post_process_transcription_if_enabled(text: &str) -> Option<String> {
+/// Runs the request on the shared LLM runtime so pooled connections outlive
+/// this stop. Streaming mode mirrors the partial result into the session's
+/// preedit. Returns `None`, meaning use the raw transcript, on failure or
+/// when the latency budget runs out.
+async fn post_process_transcription_if_enabled(
+    state: &Arc<DiktState>,
+    session_id: u64,
+    text: &str,
+) -> Option<String> {
     let request = build_post_process_request(text)?;
-    let processed = crate::llm_client::send_chat_completion(
-        &request.provider,
-        request.api_key,
-        &request.model,
-        request.prompt_text,
-    )
-    .await
-    .ok()
-    .flatten()?;
+    let latency_budget = request.latency_budget;
+    let started = Instant::now();
+
+    // Cleared before the preedit is hidden, so a delta that lands after the
+    // deadline cannot bring it back.
+    let preedit_open = Arc::new(Mutex::new(request.streaming));
+    if request.streaming {
+        state.set_session_status(session_id, "post-processing", "Post-processing transcript");
+    }
+    let on_partial: crate::llm_client::PartialTextSink = {
+        let state = state.clone();
+        let preedit_open = preedit_open.clone();
+        Box::new(move |partial| {
+            if let Ok(open) = preedit_open.lock() {
+                if *open {
+                    let revision = state.next_live_preedit_revision();
+                    state.set_live_preedit(session_id, revision, partial.to_string());
+                }
+            }
+        })
+    };
+
+    let task = crate::llm_client::llm_runtime().spawn(async move {
+        if request.streaming {
+            crate::llm_client::send_chat_completion_streaming(
+                &request.provider,
+                request.api_key,
+                &request.model,
+                request.prompt_text,
+                on_partial,
+            )
+            .await
+        } else {
+            crate::llm_client::send_chat_completion(
+                &request.provider,
+                request.api_key,
+                &request.model,
+                request.prompt_text,
+            )
+            .await
+        }
+    });
+    let abort = task.abort_handle();
+    let joined = match latency_budget {
+        Some(budget) => tokio::time::timeout(budget, task).await.ok(),
+        None => Some(task.await),
+    };
+
+    state.latency.mark(session_id, Stage::PostProcessed);
+
+    if let Ok(mut open) = preedit_open.lock() {
+        if std::mem::replace(&mut *open, false) {
+            let revision = state.next_live_preedit_revision();
+            state.clear_live_preedit(session_id, revision);
+        }
+    }
+
+    let processed = match joined {
+        Some(Ok(Ok(processed))) => processed?,
+        Some(Ok(Err(e))) => {
+            warn!("Post-processing failed for session {}: {}", session_id, e);
+            return None;
+        }
+        Some(Err(e)) => {
+            warn!(
+                "Post-processing task ended for session {}: {}",
+                session_id, e
+            );
+            return None;
+        }
+        None => {
+            abort.abort();
+            warn!(
+                "Post-processing exceeded its {:?} budget for session {}; using raw transcript",
+                latency_budget.unwrap_or_default(),
+                session_id
+            );
+            return None;
+        }
+    };
+    debug!(
+        "Post-processing completed for session {} in {:?}",
+        session_id,
+        started.elapsed()
+    );
     let trimmed = processed.trim();
     if trimmed.is_empty() {
         None
@@ -908,21 +831,46 @@ impl DiktTranscription {
             return Err(fdo::Error::Failed("No model selected".to_string()));
         }
 
-        self.state.transcription_manager.initiate_model_load();
+        self.state
+            .transcription_manager
+            .hold_for_session(session_id);
 
         match self.state.recording_manager.try_start_recording(binding_id) {
             Ok(()) => {
+                self.state.latency.mark(session_id, Stage::RecorderOpen);
                 // Set is_recording BEFORE spawning worker to prevent race condition
                 // where worker checks is_recording before it's set and exits immediately
                 self.state.is_recording.store(true, Ordering::SeqCst);
 
-                let rm = self.state.recording_manager.clone();
-                std::thread::spawn(move || {
+                let state = self.state.clone();
+                let mute = move || {
                     std::thread::sleep(Duration::from_millis(100));
-                    rm.apply_mute();
-                });
+                    state
+                        .recording_manager
+                        .apply_mute(|| state.is_recording.load(Ordering::SeqCst));
+                };
+                // Never drop the mute when the queue is full.
+                if let Err(e) = background_pool().submit(mute.clone()) {
+                    warn!("Mute job not queued ({}); applying it on a new thread", e);
+                    std::thread::spawn(mute);
+                }
+
+                let settings = settings_snapshot();
+                crate::llm_client::prewarm_post_process_connection(&settings);
+                if settings.segmented_transcription {
+                    let pipeline = SegmentedTranscription::spawn(
+                        self.state.recording_manager.clone(),
+                        self.state.transcription_manager.clone(),
+                        binding_id.to_string(),
+                    );
+                    if let Ok(mut sessions) = self.state.segmented_sessions.lock() {
+                        if let Some(stale) = sessions.insert(session_id, pipeline) {
+                            stale.cancel();
+                        }
+                    }
+                }
 
-                if Settings::new().experimental_enabled() {
+                if settings.experimental_enabled {
                     let revision = self.state.next_live_preedit_revision();
                     self.state.clear_live_preedit(session_id, revision);
                     if let Some(target_engine_id) = self.state.session_binding(session_id) {
@@ -938,7 +886,7 @@ impl DiktTranscription {
                 }
 
                 self.emit_recording_state_changed(true).await?;
-                play_feedback_sound(&Settings::new(), SoundType::Start);
+                play_feedback_sound(&settings, SoundType::Start);
                 info!("D-Bus: Recording started in {:?}", start_time.elapsed());
                 Ok(())
             }
@@ -963,7 +911,10 @@ impl DiktTranscription {
             return Ok(false);
         };
 
-        if matches!(status.state.as_str(), "finalizing" | "ready" | "committed") {
+        if matches!(
+            status.state.as_str(),
+            "finalizing" | "post-processing" | "ready" | "committed"
+        ) {
             return Ok(true);
         }
         if matches!(status.state.as_str(), "failed" | "cancelled") {
@@ -986,6 +937,7 @@ impl DiktTranscription {
         );
 
         self.state.mark_session_stopping(session_id);
+        self.state.latency.mark(session_id, Stage::Stop);
         self.state
             .set_session_status(session_id, "finalizing", "Stopping recorder");
 
@@ -993,13 +945,17 @@ impl DiktTranscription {
             self.emit_recording_state_changed(false).await?;
         }
 
-        play_feedback_sound(&Settings::new(), SoundType::Stop);
+        play_feedback_sound(&settings_snapshot(), SoundType::Stop);
         self.state.recording_manager.remove_mute();
 
         let revision = self.state.next_live_preedit_revision();
         self.state.clear_live_preedit(session_id, revision);
 
+        let segmented = self.state.take_segmented_transcription(session_id);
         let Some(samples) = self.state.recording_manager.stop_recording(&binding_id) else {
+            if let Some(pipeline) = segmented {
+                pipeline.cancel();
+            }
             self.state.clear_session_stopping(session_id);
             self.state.set_session_status(
                 session_id,
@@ -1008,54 +964,67 @@ impl DiktTranscription {
             );
             return Ok(false);
         };
+        self.state.latency.mark(session_id, Stage::Captured);
+        if let Some(onset) = self.state.recording_manager.speech_onset() {
+            self.state
+                .latency
+                .mark_at(session_id, Stage::FirstSpeech, onset);
+        }
 
         let worker = DiktTranscription::new(self.state.clone(), self.dbus_state.clone());
-        std::thread::spawn(move || {
-            let runtime = tokio::runtime::Builder::new_current_thread()
-                .enable_all()
-                .build();
-            match runtime {
-                Ok(rt) => {
-                    let finalize_result =
-                        std::panic::catch_unwind(std::panic::AssertUnwindSafe(|| {
-                            rt.block_on(worker.finalize_stop_recording(session_id, samples))
-                        }));
-                    if finalize_result.is_err() {
-                        error!(
-                            "finalize_stop_recording(session={}) panicked; marking session failed",
-                            session_id
-                        );
-                        worker.state.set_session_status(
-                            session_id,
-                            "failed",
-                            "Internal transcription panic",
-                        );
-                        worker.state.clear_session_stopping(session_id);
-                    }
-                }
-                Err(e) => {
+        let submitted = finalize_pool().submit(move || {
+            let finalize_result = std::panic::catch_unwind(std::panic::AssertUnwindSafe(|| {
+                executor::block_on(worker.finalize_stop_recording(session_id, samples, segmented))
+            }));
+            let failure = match finalize_result {
+                Ok(Ok(())) => return,
+                Ok(Err(e)) => {
                     error!(
                         "Failed to create runtime for finalize_stop_recording(session={}): {}",
                         session_id, e
                     );
-                    worker.state.set_session_status(
-                        session_id,
-                        "failed",
-                        "Internal runtime initialization failed",
+                    "Internal runtime initialization failed"
+                }
+                Err(_) => {
+                    error!(
+                        "finalize_stop_recording(session={}) panicked; marking session failed",
+                        session_id
                     );
-                    worker.state.clear_session_stopping(session_id);
+                    "Internal transcription panic"
                 }
-            }
+            };
+            worker
+                .state
+                .set_session_status(session_id, "failed", failure);
+            worker.state.clear_session_stopping(session_id);
         });
+        if let Err(e) = submitted {
+            let message = format!("Cannot finalize recording: {}", e);
+            error!("D-Bus: {} (session={})", message, session_id);
+            self.state
+                .set_session_status(session_id, "failed", &message);
+            self.state.clear_session_stopping(session_id);
+            self.emit_error(&message).await?;
+            return Ok(false);
+        }
         Ok(true)
     }
 
-    async fn finalize_stop_recording(&self, session_id: u64, samples: Vec<f32>) {
+    async fn finalize_stop_recording(
+        &self,
+        session_id: u64,
+        samples: SampleView,
+        segmented: Option<SegmentedTranscription>,
+    ) {
         let stop_time = Instant::now();
         if samples.is_empty() {
+            if let Some(pipeline) = segmented {
+                pipeline.cancel();
+            }
             self.state
                 .set_session_status(session_id, "ready", "No speech detected");
             self.state.clear_session_stopping(session_id);
+            self.state.latency.finish(session_id);
             let _ = self.emit_transcription_ready("").await;
             return;
         }
@@ -1067,9 +1036,17 @@ impl DiktTranscription {
             stop_time.elapsed()
         );
 
+        self.state.transcription_manager.wait_for_selected_model();
+        self.state.latency.mark(session_id, Stage::ModelReady);
+
         let transcription_time = Instant::now();
-        match self.state.transcription_manager.transcribe(samples) {
+        let result = match segmented {
+            Some(pipeline) => pipeline.finish(samples),
+            None => self.state.transcription_manager.transcribe(samples),
+        };
+        match result {
             Ok(transcription) => {
+                self.state.latency.mark(session_id, Stage::Decoded);
                 debug!(
                     "D-Bus: Transcription completed for session {} in {:?}",
                     session_id,
@@ -1082,23 +1059,33 @@ impl DiktTranscription {
                             "selected_language lock poisoned while finalizing session {}: {}",
                             session_id, e
                         );
-                        Settings::new().selected_language()
+                        settings_snapshot().selected_language.clone()
                     }
                 };
                 let converted_text = convert_chinese_variant(&transcription, &lang);
-                let output_text = match post_process_transcription_if_enabled(&converted_text).await
+                let output_text = match post_process_transcription_if_enabled(
+                    &self.state,
+                    session_id,
+                    &converted_text,
+                )
+                .await
                 {
                     Some(text) => text,
                     None => converted_text,
                 };
 
-                if !output_text.trim().is_empty() {
+                let has_commit = !output_text.trim().is_empty();
+                self.state.latency.mark(session_id, Stage::Ready);
+                if has_commit {
                     self.state
                         .store_pending_commit(session_id, output_text.clone());
                 }
                 self.state
                     .set_session_status(session_id, "ready", "Transcription ready");
                 self.state.clear_session_stopping(session_id);
+                if !has_commit {
+                    self.state.latency.finish(session_id);
+                }
 
                 if let Err(e) = self.emit_transcription_ready(&output_text).await {
                     error!(
@@ -1189,6 +1176,36 @@ impl DiktTranscription {
     }
 }
 
+/// Which live preview polls are worth a decode.
+#[derive(Debug, Default)]
+struct LivePreviewGate {
+    /// Recording length at the last decode.
+    decoded_len: usize,
+    /// Speech sequence covered by the last decode.
+    decoded_speech: Option<u64>,
+}
+
+impl LivePreviewGate {
+    /// False when no speech arrived since the last decode: audio that only
+    /// grew by silence cannot change the preview.
+    fn has_new_speech(&self, speech_seq: u64) -> bool {
+        self.decoded_speech != Some(speech_seq)
+    }
+
+    /// Whether the recording is long enough, and grew enough since the last
+    /// decode, for another preview.
+    fn has_enough_audio(&self, total_samples: usize) -> bool {
+        total_samples >= LIVE_PREEDIT_MIN_TOTAL_SAMPLES
+            && (self.decoded_len == 0
+                || total_samples.saturating_sub(self.decoded_len) >= LIVE_PREEDIT_MIN_NEW_SAMPLES)
+    }
+
+    fn mark_decoded(&mut self, total_samples: usize, speech_seq: u64) {
+        self.decoded_len = total_samples;
+        self.decoded_speech = Some(speech_seq);
+    }
+}
+
 fn spawn_live_preedit_worker(
     state: Arc<DiktState>,
     binding_id: String,
@@ -1196,14 +1213,15 @@ fn spawn_live_preedit_worker(
     target_engine_id: u64,
 ) {
     std::thread::spawn(move || {
-        let mut last_snapshot_len: usize = 0;
+        let mut gate = LivePreviewGate::default();
         let mut snapshot_failure_streak: u64 = 0;
         let mut published_text = String::new();
-        let mut last_window_text = String::new();
-        let mut accumulated_text = String::new();
+        let speech_activity = state.recording_manager.speech_activity();
+        let mut last_poll = Instant::now();
+        state.transcription_manager.begin_live_stream(session_id);
 
         loop {
-            if !Settings::new().experimental_enabled() {
+            if !settings_snapshot().experimental_enabled {
                 if !published_text.is_empty() {
                     let revision = state.next_live_preedit_revision();
                     state.clear_live_preedit(session_id, revision);
@@ -1239,11 +1257,27 @@ fn spawn_live_preedit_worker(
                 break;
             }
 
-            std::thread::sleep(Duration::from_millis(LIVE_PREEDIT_POLL_MS));
+            let poll = Duration::from_millis(LIVE_PREEDIT_POLL_MS);
+            if let Some(seen) = gate.decoded_speech {
+                speech_activity.wait_for_change(seen, poll);
+            }
+            if let Some(rest) = poll.checked_sub(last_poll.elapsed()) {
+                std::thread::sleep(rest);
+            }
+            last_poll = Instant::now();
+            let speech_seq = speech_activity.sequence();
+            if !gate.has_new_speech(speech_seq) {
+                continue;
+            }
 
-            let Some(samples) = state
+            // Only audio past the committed prefix (plus a short overlap) is
+            // decoded; earlier text is kept by the transcription manager.
+            let window_start = state
+                .transcription_manager
+                .live_stream_window_start(session_id);
+            let Some((total_samples, samples)) = state
                 .recording_manager
-                .snapshot_recording_window(&binding_id, LIVE_PREEDIT_MAX_WINDOW_SAMPLES)
+                .snapshot_recording_since(&binding_id, window_start)
             else {
                 // Snapshot failures can be transient under load; keep the last preview visible
                 // and continue retrying while this session is still active.
@@ -1279,19 +1313,23 @@ fn spawn_live_preedit_worker(
                 snapshot_failure_streak = 0;
             }
 
-            if samples.len() < LIVE_PREEDIT_MIN_TOTAL_SAMPLES {
+            if !gate.has_enough_audio(total_samples) {
                 continue;
             }
 
-            if last_snapshot_len > 0
-                && samples.len().saturating_sub(last_snapshot_len) < LIVE_PREEDIT_MIN_NEW_SAMPLES
-            {
-                continue;
-            }
-            last_snapshot_len = samples.len();
-
-            let transcription = match state.transcription_manager.transcribe_for_live(samples) {
-                Ok(text) => text,
+            // Only a decode that produced text covers the speech so far; after
+            // a superseded or failed one the next poll tries again.
+            let transcription = match state.transcription_manager.transcribe_live_window(
+                session_id,
+                window_start,
+                samples,
+            ) {
+                Ok(Some(text)) => {
+                    gate.mark_decoded(total_samples, speech_seq);
+                    text
+                }
+                // Superseded while queued behind a final decode.
+                Ok(None) => continue,
                 Err(err) => {
                     debug!(
                         "Live preedit transcription failed for session {}: {}",
@@ -1308,7 +1346,7 @@ fn spawn_live_preedit_worker(
                         "selected_language lock poisoned in live preedit worker (session={}): {}",
                         session_id, e
                     );
-                    Settings::new().selected_language()
+                    settings_snapshot().selected_language.clone()
                 }
             };
             let live_text = convert_chinese_variant(&transcription, &lang)
@@ -1331,21 +1369,15 @@ fn spawn_live_preedit_worker(
                 continue;
             }
 
-            if accumulated_text.is_empty() {
-                accumulated_text = live_text.clone();
-            } else {
-                accumulated_text =
-                    merge_live_transcript(&accumulated_text, &last_window_text, &live_text);
-            }
-            last_window_text = live_text;
-
-            if accumulated_text != published_text {
+            if live_text != published_text {
                 let revision = state.next_live_preedit_revision();
-                state.set_live_preedit(session_id, revision, accumulated_text.clone());
-                published_text = accumulated_text.clone();
+                state.set_live_preedit(session_id, revision, live_text.clone());
+                published_text = live_text;
             }
         }
 
+        state.transcription_manager.end_live_stream(session_id);
+
         // Only clear preview if NOT in graceful stop mode (i.e. cancelled).
         if !published_text.is_empty() && !state.session_is_stopping(session_id) {
             let revision = state.next_live_preedit_revision();
@@ -1354,76 +1386,6 @@ fn spawn_live_preedit_worker(
     });
 }
 
-fn merge_live_transcript(accumulated: &str, prev_window: &str, next_window: &str) -> String {
-    if accumulated.is_empty() || prev_window.is_empty() {
-        return next_window.to_string();
-    }
-    if next_window.is_empty() || next_window == prev_window {
-        return accumulated.to_string();
-    }
-    if let Some(base) = accumulated.strip_suffix(prev_window) {
-        if next_window.starts_with(prev_window) {
-            return format!("{}{}", base, next_window);
-        }
-
-        let lcp = common_prefix_chars(prev_window, next_window);
-        let prev_len = prev_window.chars().count();
-        let next_len = next_window.chars().count();
-        if lcp >= 8 || (lcp * 2 >= prev_len.min(next_len) && lcp >= 3) {
-            return format!("{}{}", base, next_window);
-        }
-
-        let overlap = longest_suffix_prefix_chars(prev_window, next_window);
-        if overlap > 0 {
-            let overlap_bytes = byte_index_at_char(next_window, overlap);
-            return format!("{}{}", accumulated, &next_window[overlap_bytes..]);
-        }
-    }
-
-    if accumulated.ends_with(next_window) {
-        return accumulated.to_string();
-    }
-
-    format!("{}{}", accumulated, next_window)
-}
-
-fn common_prefix_chars(left: &str, right: &str) -> usize {
-    left.chars()
-        .zip(right.chars())
-        .take_while(|(a, b)| a == b)
-        .count()
-}
-
-fn longest_suffix_prefix_chars(left: &str, right: &str) -> usize {
-    let left_bounds = char_boundaries(left);
-    let right_bounds = char_boundaries(right);
-    let max = left_bounds
-        .len()
-        .saturating_sub(1)
-        .min(right_bounds.len().saturating_sub(1));
-    for overlap_chars in (1..=max).rev() {
-        let left_start = left_bounds[left_bounds.len() - 1 - overlap_chars];
-        let right_end = right_bounds[overlap_chars];
-        if left[left_start..] == right[..right_end] {
-            return overlap_chars;
-        }
-    }
-    0
-}
-
-fn byte_index_at_char(text: &str, char_idx: usize) -> usize {
-    char_boundaries(text)
-        .get(char_idx)
-        .copied()
-        .unwrap_or(text.len())
-}
-
-fn char_boundaries(text: &str) -> Vec<usize> {
-    let mut bounds = text.char_indices().map(|(idx, _)| idx).collect::<Vec<_>>();
-    bounds.push(text.len());
-    bounds
-}
-
 fn binding_id_for_session(session_id: u64) -> String {
     format!("session-{}", session_id)
 }
@@ -1435,6 +1397,60 @@ fn now_millis() -> u64 {
         .unwrap_or(0)
 }
 
+/// Emits queued [`BusSignal`]s from a dedicated thread so callers on the
+/// live preedit worker and the D-Bus executor never wait on the bus.
+fn spawn_bus_signal_emitter(state: &DiktState, connection: &Connection) {
+    let (tx, rx) = mpsc::channel::<BusSignal>();
+    let connection = zbus::blocking::Connection::from(connection.clone());
+    std::thread::spawn(move || {
+        for signal in rx {
+            let result = match signal {
+                BusSignal::CommitReady {
+                    engine_id,
+                    session_id,
+                } => connection.emit_signal(
+                    None::<zbus::names::BusName<'_>>,
+                    DIKT_OBJECT_PATH,
+                    DIKT_INTERFACE,
+                    "CommitReady",
+                    &(engine_id, session_id),
+                ),
+                BusSignal::LivePreeditChanged {
+                    engine_id,
+                    session_id,
+                    revision,
+                } => connection.emit_signal(
+                    None::<zbus::names::BusName<'_>>,
+                    DIKT_OBJECT_PATH,
+                    DIKT_INTERFACE,
+                    "LivePreeditChanged",
+                    &(engine_id, session_id, revision),
+                ),
+                BusSignal::AudioLevels(ref levels) => connection.emit_signal(
+                    None::<zbus::names::BusName<'_>>,
+                    DIKT_OBJECT_PATH,
+                    DIKT_INTERFACE,
+                    "AudioLevels",
+                    &(levels,),
+                ),
+            };
+            if let Err(e) = result {
+                warn!("Failed to emit {:?}: {}", signal, e);
+            }
+        }
+    });
+    state.recording_manager.level_meter().set_sink(Box::new({
+        let tx = tx.clone();
+        move |levels| {
+            let levels = levels.iter().map(|&level| f64::from(level)).collect();
+            let _ = tx.send(BusSignal::AudioLevels(levels));
+        }
+    }));
+    if let Ok(mut guard) = state.bus_signal_tx.lock() {
+        *guard = Some(tx);
+    }
+}
+
 /// Start the D-Bus server
 pub async fn start_dbus_server(state: Arc<DiktState>) -> Result<Arc<DiktDbusState>, String> {
     info!("Starting D-Bus server for IBus integration...");
@@ -1450,6 +1466,7 @@ pub async fn start_dbus_server(state: Arc<DiktState>) -> Result<Arc<DiktDbusStat
         .await
         .map_err(|e| format!("Failed to request bus name: {}", e))?;
 
+    spawn_bus_signal_emitter(&state, &connection);
     let transcription = DiktTranscription::new(state, dbus_state.clone());
 
     connection
@@ -1496,210 +1513,27 @@ pub async fn stop_dbus_server(dbus_state: &DiktDbusState) -> Result<(), String>
 
 #[cfg(test)]
 mod tests {
-    use super::{
-        select_active_session_for_engine, LivePreeditStore, PendingCommitStore, SessionStatusEntry,
-    };
-    use std::collections::HashMap;
-    use std::time::Duration;
-
-    #[test]
-    fn pending_commit_store_take_for_session_claim_consumes_exact_match() {
-        let store = PendingCommitStore::default();
-        store.store(42, "claim-a".to_string(), "hello".to_string());
-        store.store(43, "claim-b".to_string(), "world".to_string());
-
-        let (ok_first, text_first) = store.take_for_session(42, "claim-a");
-        assert!(ok_first);
-        assert_eq!(text_first, "hello");
-
-        let (ok_second, text_second) = store.take_for_session(43, "claim-b");
-        assert!(ok_second);
-        assert_eq!(text_second, "world");
-    }
-
-    #[test]
-    fn pending_commit_store_rejects_wrong_claim() {
-        let store = PendingCommitStore::default();
-        store.store(61, "claim-ok".to_string(), "payload".to_string());
-
-        let (ok, text) = store.take_for_session(61, "claim-wrong");
-        assert!(!ok);
-        assert!(text.is_empty());
-        let (ok_again, text_again) = store.take_for_session(61, "claim-ok");
-        assert!(ok_again);
-        assert_eq!(text_again, "payload");
-    }
-
-    #[test]
-    fn pending_commit_store_stats_reports_oldest_age() {
-        let store = PendingCommitStore::default();
-        store.store(99, "claim-99".to_string(), "payload".to_string());
-        std::thread::sleep(Duration::from_millis(2));
-        let parsed: serde_json::Value =
-            serde_json::from_str(&store.stats_json()).expect("valid stats json");
-        let queue_len = parsed
-            .get("queue_len")
-            .and_then(|v| v.as_u64())
-            .unwrap_or(0);
-        let oldest_age_ms = parsed
-            .get("oldest_age_ms")
-            .and_then(|v| v.as_u64())
-            .unwrap_or(0);
-        assert_eq!(queue_len, 1);
-        assert!(oldest_age_ms > 0);
-    }
-
-    #[test]
-    fn pending_commit_store_keeps_independent_queue_order() {
-        let store = PendingCommitStore::default();
-        store.store(10, "claim-10".to_string(), "first".to_string());
-        store.store(11, "claim-11".to_string(), "second".to_string());
-        store.store(12, "claim-12".to_string(), "third".to_string());
-
-        let first = store.take_for_session(10, "claim-10");
-        let second = store.take_for_session(11, "claim-11");
-        let third = store.take_for_session(12, "claim-12");
-
-        assert_eq!(first, (true, "first".to_string()));
-        assert_eq!(second, (true, "second".to_string()));
-        assert_eq!(third, (true, "third".to_string()));
-    }
-
-    #[test]
-    fn pending_commit_store_has_for_session_claim_matches_exact_claim() {
-        let store = PendingCommitStore::default();
-        store.store(10, "claim-10".to_string(), "first".to_string());
-
-        assert!(store.has_for_session_claim(10, "claim-10"));
-        assert!(!store.has_for_session_claim(10, "claim-other"));
-        assert!(!store.has_for_session_claim(11, "claim-10"));
-    }
-
-    #[test]
-    fn select_active_session_prefers_ready_with_pending_over_newer_ready_without_pending() {
-        let mut bindings = HashMap::new();
-        bindings.insert(1, 99);
-        bindings.insert(2, 99);
-
-        let mut claims = HashMap::new();
-        claims.insert(1, "claim-1".to_string());
-        claims.insert(2, "claim-2".to_string());
-
-        let mut statuses = HashMap::new();
-        statuses.insert(1, SessionStatusEntry::new("ready", "with pending"));
-        statuses.insert(2, SessionStatusEntry::new("ready", "without pending"));
-        if let Some(entry) = statuses.get_mut(&1) {
-            entry.updated_ms = 100;
-        }
-        if let Some(entry) = statuses.get_mut(&2) {
-            entry.updated_ms = 200;
-        }
-
-        let selected = select_active_session_for_engine(
-            99,
-            &bindings,
-            &claims,
-            &statuses,
-            |session, claim| session == 1 && claim == "claim-1",
-        );
-        assert_eq!(selected, (1, "claim-1".to_string(), false));
-    }
-
-    #[test]
-    fn select_active_session_prefers_recording_over_ready_with_pending() {
-        let mut bindings = HashMap::new();
-        bindings.insert(1, 99);
-        bindings.insert(2, 99);
-
-        let mut claims = HashMap::new();
-        claims.insert(1, "claim-ready".to_string());
-        claims.insert(2, "claim-recording".to_string());
-
-        let mut statuses = HashMap::new();
-        statuses.insert(1, SessionStatusEntry::new("ready", "ready"));
-        statuses.insert(2, SessionStatusEntry::new("recording", "recording"));
-
-        let selected = select_active_session_for_engine(
-            99,
-            &bindings,
-            &claims,
-            &statuses,
-            |session, claim| session == 1 && claim == "claim-ready",
-        );
-        assert_eq!(selected, (2, "claim-recording".to_string(), true));
-    }
-
-    #[test]
-    fn select_active_session_skips_ready_without_pending() {
-        let mut bindings = HashMap::new();
-        bindings.insert(1, 99);
-
-        let mut claims = HashMap::new();
-        claims.insert(1, "claim-1".to_string());
-
-        let mut statuses = HashMap::new();
-        statuses.insert(1, SessionStatusEntry::new("ready", "no pending"));
-
-        let selected =
-            select_active_session_for_engine(99, &bindings, &claims, &statuses, |_, _| false);
-        assert_eq!(selected, (0, String::new(), false));
-    }
-
-    #[test]
-    fn live_preedit_store_tracks_latest_per_session() {
-        let store = LivePreeditStore::default();
-        store.set(42, 1, "alpha".to_string());
-        store.set(42, 2, "bravo".to_string());
-
-        let (revision, visible, text) = store.get_for_session(42);
-        assert_eq!(revision, 2);
-        assert!(visible);
-        assert_eq!(text, "bravo");
-    }
-
-    #[test]
-    fn live_preedit_store_keeps_session_isolation() {
-        let store = LivePreeditStore::default();
-        store.set(21, 7, "left".to_string());
-        store.set(22, 9, "right".to_string());
-
-        let left = store.get_for_session(21);
-        let right = store.get_for_session(22);
-        assert_eq!(left.0, 7);
-        assert!(left.1);
-        assert_eq!(left.2, "left");
-        assert_eq!(right.0, 9);
-        assert!(right.1);
-        assert_eq!(right.2, "right");
-    }
-
-    #[test]
-    fn live_preedit_store_clear_hides_entry() {
-        let store = LivePreeditStore::default();
-        store.set(101, 3, "hello".to_string());
-        store.clear(101, 4);
-
-        let (revision, visible, text) = store.get_for_session(101);
-        assert_eq!(revision, 4);
-        assert!(!visible);
-        assert!(text.is_empty());
-    }
-
-    #[test]
-    fn merge_live_transcript_appends_shifted_tail_without_losing_prefix() {
-        let accumulated = "hello world";
-        let prev = "hello world";
-        let next = "world again";
-        let merged = super::merge_live_transcript(accumulated, prev, next);
-        assert_eq!(merged, "hello world again");
-    }
+    use super::*;
 
     #[test]
-    fn merge_live_transcript_replaces_tail_on_correction() {
-        let accumulated = "hello wurld";
-        let prev = "hello wurld";
-        let next = "hello world";
-        let merged = super::merge_live_transcript(accumulated, prev, next);
-        assert_eq!(merged, "hello world");
+    fn live_preview_skips_decodes_when_only_silence_grew() {
+        let mut gate = LivePreviewGate::default();
+        assert!(gate.has_new_speech(0));
+        assert!(!gate.has_enough_audio(LIVE_PREEDIT_MIN_TOTAL_SAMPLES - 1));
+        assert!(gate.has_enough_audio(LIVE_PREEDIT_MIN_TOTAL_SAMPLES));
+        gate.mark_decoded(LIVE_PREEDIT_MIN_TOTAL_SAMPLES, 5);
+
+        // The recording kept growing, but no frame since was speech.
+        let grown = LIVE_PREEDIT_MIN_TOTAL_SAMPLES + 10 * LIVE_PREEDIT_MIN_NEW_SAMPLES;
+        assert!(gate.has_enough_audio(grown));
+        assert!(!gate.has_new_speech(5));
+
+        // New speech, but too little audio to be worth a decode yet.
+        assert!(gate.has_new_speech(6));
+        assert!(!gate
+            .has_enough_audio(LIVE_PREEDIT_MIN_TOTAL_SAMPLES + LIVE_PREEDIT_MIN_NEW_SAMPLES - 1));
+
+        gate.mark_decoded(grown, 6);
+        assert!(!gate.has_new_speech(6));
     }
 }
@@ -0,0 +1,578 @@
+//! Session bookkeeping for the D-Bus server.
+//!
+//! Everything known about a session (engine binding, claim token, status,
+//! stop flag, pending commit and live preedit) lives in one record, so a
+//! handler takes one lock. Sessions are also indexed by engine for the
+//! lookups every IBus engine polls, and terminal sessions expire through a
+//! timer wheel instead of a scan of the whole table.
+
+use serde_json::json;
+use std::collections::{HashMap, VecDeque};
+
+/// Pending commits kept across all sessions; the oldest is dropped beyond this.
+const MAX_PENDING_COMMITS: usize = 32;
+const WHEEL_TICK_MS: u64 = 1000;
+/// Covers the session TTL, so a timer normally fires on its first visit.
+const WHEEL_SLOTS: usize = 512;
+
+#[derive(Clone, Debug)]
+pub struct SessionStatusEntry {
+    pub state: String,
+    pub message: String,
+    pub updated_ms: u64,
+}
+
+impl SessionStatusEntry {
+    fn new(state: &str, message: &str, now_ms: u64) -> Self {
+        Self {
+            state: state.to_string(),
+            message: message.to_string(),
+            updated_ms: now_ms,
+        }
+    }
+
+    pub fn is_terminal(&self) -> bool {
+        matches!(
+            self.state.as_str(),
+            "ready" | "failed" | "cancelled" | "committed"
+        )
+    }
+}
+
+#[derive(Clone, Debug, Default)]
+struct LivePreeditEntry {
+    revision: u64,
+    visible: bool,
+    text: String,
+}
+
+#[derive(Clone, Debug)]
+struct PendingCommit {
+    text: String,
+    created_ms: u64,
+}
+
+struct SessionRecord {
+    engine_id: u64,
+    claim_token: String,
+    status: SessionStatusEntry,
+    stopping: bool,
+    pending_commit: Option<PendingCommit>,
+    live_preedit: LivePreeditEntry,
+    /// Deadline of the live expiry timer; older timers for the session are
+    /// stale and ignored when they fire.
+    expires_at_ms: Option<u64>,
+}
+
+/// Single-level hashed timer wheel with one-second slots. A timer further
+/// out than the wheel spans waits in the last slot and is re-filed when it
+/// is visited early.
+struct TimerWheel {
+    slots: Vec<Vec<(u64, u64)>>,
+    /// Last tick whose slot has been visited.
+    cursor: u64,
+}
+
+impl TimerWheel {
+    fn new(now_ms: u64) -> Self {
+        Self {
+            slots: vec![Vec::new(); WHEEL_SLOTS],
+            cursor: now_ms / WHEEL_TICK_MS,
+        }
+    }
+
+    fn schedule(&mut self, id: u64, deadline_ms: u64) {
+        let tick = (deadline_ms / WHEEL_TICK_MS)
+            .max(self.cursor + 1)
+            .min(self.cursor + WHEEL_SLOTS as u64);
+        self.slots[tick as usize % WHEEL_SLOTS].push((id, deadline_ms));
+    }
+
+    /// Visits the slots up to `now_ms` and hands over every timer that is due.
+    fn advance(&mut self, now_ms: u64, mut fire: impl FnMut(u64, u64)) {
+        let now_tick = now_ms / WHEEL_TICK_MS;
+        let ticks = now_tick.saturating_sub(self.cursor).min(WHEEL_SLOTS as u64);
+        let mut not_due = Vec::new();
+        for tick in self.cursor + 1..=self.cursor + ticks {
+            for (id, deadline_ms) in self.slots[tick as usize % WHEEL_SLOTS].drain(..) {
+                if deadline_ms <= now_ms {
+                    fire(id, deadline_ms);
+                } else {
+                    not_due.push((id, deadline_ms));
+                }
+            }
+        }
+        self.cursor = self.cursor.max(now_tick);
+        for (id, deadline_ms) in not_due {
+            self.schedule(id, deadline_ms);
+        }
+    }
+}
+
+pub struct SessionTable {
+    sessions: HashMap<u64, SessionRecord>,
+    by_engine: HashMap<u64, Vec<u64>>,
+    /// Sessions holding a pending commit, oldest first.
+    pending_order: VecDeque<u64>,
+    dropped_commits: u64,
+    ttl_ms: u64,
+    expiry: TimerWheel,
+}
+
+impl SessionTable {
+    /// Terminal sessions are dropped `ttl_ms` after their last status change.
+    pub fn new(ttl_ms: u64, now_ms: u64) -> Self {
+        Self {
+            sessions: HashMap::new(),
+            by_engine: HashMap::new(),
+            pending_order: VecDeque::new(),
+            dropped_commits: 0,
+            ttl_ms,
+            expiry: TimerWheel::new(now_ms),
+        }
+    }
+
+    pub fn insert(&mut self, session_id: u64, engine_id: u64, claim_token: String, now_ms: u64) {
+        self.remove(session_id);
+        self.sessions.insert(
+            session_id,
+            SessionRecord {
+                engine_id,
+                claim_token,
+                status: SessionStatusEntry::new("created", "Session created", now_ms),
+                stopping: false,
+                pending_commit: None,
+                live_preedit: LivePreeditEntry::default(),
+                expires_at_ms: None,
+            },
+        );
+        self.by_engine
+            .entry(engine_id)
+            .or_default()
+            .push(session_id);
+    }
+
+    /// Returns whether the session existed.
+    pub fn remove(&mut self, session_id: u64) -> bool {
+        let Some(record) = self.sessions.remove(&session_id) else {
+            return false;
+        };
+        if let Some(sessions) = self.by_engine.get_mut(&record.engine_id) {
+            sessions.retain(|id| *id != session_id);
+            if sessions.is_empty() {
+                self.by_engine.remove(&record.engine_id);
+            }
+        }
+        if record.pending_commit.is_some() {
+            self.pending_order.retain(|id| *id != session_id);
+        }
+        true
+    }
+
+    /// Removes terminal sessions whose TTL ran out and returns their ids.
+    pub fn expire(&mut self, now_ms: u64) -> Vec<u64> {
+        let mut due = Vec::new();
+        self.expiry.advance(now_ms, |session_id, deadline_ms| {
+            due.push((session_id, deadline_ms))
+        });
+        let mut expired = Vec::new();
+        for (session_id, deadline_ms) in due {
+            let live = self
+                .sessions
+                .get(&session_id)
+                .is_some_and(|record| record.expires_at_ms == Some(deadline_ms));
+            if live {
+                self.remove(session_id);
+                expired.push(session_id);
+            }
+        }
+        expired
+    }
+
+    pub fn engine_id(&self, session_id: u64) -> Option<u64> {
+        self.sessions
+            .get(&session_id)
+            .map(|record| record.engine_id)
+    }
+
+    fn claimed(&self, session_id: u64, claim_token: &str) -> Option<&SessionRecord> {
+        self.sessions
+            .get(&session_id)
+            .filter(|record| record.claim_token == claim_token)
+    }
+
+    pub fn status(&self, session_id: u64) -> Option<&SessionStatusEntry> {
+        self.sessions.get(&session_id).map(|record| &record.status)
+    }
+
+    /// Returns false for unknown sessions. Entering a terminal state starts
+    /// the expiry timer; leaving one cancels it.
+    pub fn set_status(&mut self, session_id: u64, state: &str, message: &str, now_ms: u64) -> bool {
+        let Some(record) = self.sessions.get_mut(&session_id) else {
+            return false;
+        };
+        record.status = SessionStatusEntry::new(state, message, now_ms);
+        record.expires_at_ms = None;
+        if record.status.is_terminal() {
+            let deadline_ms = now_ms.saturating_add(self.ttl_ms);
+            record.expires_at_ms = Some(deadline_ms);
+            self.expiry.schedule(session_id, deadline_ms);
+        }
+        true
+    }
+
+    pub fn set_stopping(&mut self, session_id: u64, stopping: bool) {
+        if let Some(record) = self.sessions.get_mut(&session_id) {
+            record.stopping = stopping;
+        }
+    }
+
+    pub fn is_stopping(&self, session_id: u64) -> bool {
+        self.sessions
+            .get(&session_id)
+            .is_some_and(|record| record.stopping)
+    }
+
+    /// Stores the final text and returns the engine to notify, or `None`
+    /// for unknown sessions.
+    pub fn store_pending_commit(
+        &mut self,
+        session_id: u64,
+        text: String,
+        now_ms: u64,
+    ) -> Option<u64> {
+        let record = self.sessions.get_mut(&session_id)?;
+        let had_pending = record
+            .pending_commit
+            .replace(PendingCommit {
+                text,
+                created_ms: now_ms,
+            })
+            .is_some();
+        let engine_id = record.engine_id;
+        if had_pending {
+            self.pending_order.retain(|id| *id != session_id);
+        }
+        if self.pending_order.len() >= MAX_PENDING_COMMITS {
+            if let Some(oldest) = self.pending_order.pop_front() {
+                if let Some(record) = self.sessions.get_mut(&oldest) {
+                    record.pending_commit = None;
+                }
+                self.dropped_commits += 1;
+            }
+        }
+        self.pending_order.push_back(session_id);
+        Some(engine_id)
+    }
+
+    /// Consumes the pending text when `claim_token` matches.
+    pub fn take_pending_commit(&mut self, session_id: u64, claim_token: &str) -> Option<String> {
+        self.claimed(session_id, claim_token)?;
+        let pending = self.sessions.get_mut(&session_id)?.pending_commit.take()?;
+        self.pending_order.retain(|id| *id != session_id);
+        Some(pending.text)
+    }
+
+    pub fn has_pending_commit(&self, session_id: u64, claim_token: &str) -> bool {
+        self.claimed(session_id, claim_token)
+            .is_some_and(|record| record.pending_commit.is_some())
+    }
+
+    pub fn pending_commit_stats_json(&self, now_ms: u64) -> String {
+        let oldest_age_ms = self
+            .pending_order
+            .front()
+            .and_then(|id| self.sessions.get(id))
+            .and_then(|record| record.pending_commit.as_ref())
+            .map(|pending| now_ms.saturating_sub(pending.created_ms))
+            .unwrap_or(0);
+        let targets: HashMap<u64, u64> = self.pending_order.iter().map(|id| (*id, 1)).collect();
+        json!({
+            "queue_len": self.pending_order.len(),
+            "oldest_age_ms": oldest_age_ms,
+            "dropped_count": self.dropped_commits,
+            "targets": targets,
+        })
+        .to_string()
+    }
+
+    /// Applies the update unless a newer revision is already stored.
+    /// Returns whether it was applied.
+    pub fn set_live_preedit(
+        &mut self,
+        session_id: u64,
+        revision: u64,
+        text: Option<String>,
+    ) -> bool {
+        let Some(record) = self.sessions.get_mut(&session_id) else {
+            return false;
+        };
+        if record.live_preedit.revision >= revision {
+            return false;
+        }
+        record.live_preedit = LivePreeditEntry {
+            revision,
+            visible: text.is_some(),
+            text: text.unwrap_or_default(),
+        };
+        true
+    }
+
+    pub fn live_preedit(&self, session_id: u64, claim_token: &str) -> (u64, bool, String) {
+        self.claimed(session_id, claim_token)
+            .map(|record| {
+                let entry = &record.live_preedit;
+                (entry.revision, entry.visible, entry.text.clone())
+            })
+            .unwrap_or((0, false, String::new()))
+    }
+
+    /// The session an engine should follow: recording first, then one being
+    /// finalized, then a ready one whose commit is still waiting; newest
+    /// first within a class.
+    pub fn active_session_for_engine(&self, engine_id: u64) -> (u64, String, bool) {
+        let mut best: Option<(u8, u64, u64, &SessionRecord, bool)> = None;
+        for session_id in self.by_engine.get(&engine_id).into_iter().flatten() {
+            let Some(record) = self.sessions.get(session_id) else {
+                continue;
+            };
+            let (priority, allow_preedit) = match record.status.state.as_str() {
+                "recording" => (3, true),
+                "finalizing" => (2, false),
+                // Streamed post-processing output is shown as it arrives.
+                "post-processing" => (2, true),
+                "ready" if record.pending_commit.is_some() => (1, false),
+                _ => (0, false),
+            };
+            if priority == 0 {
+                continue;
+            }
+            let rank = (priority, record.status.updated_ms, *session_id);
+            if best
+                .as_ref()
+                .is_none_or(|current| rank > (current.0, current.1, current.2))
+            {
+                best = Some((rank.0, rank.1, rank.2, record, allow_preedit));
+            }
+        }
+        best.map(|(_, _, session_id, record, allow_preedit)| {
+            (session_id, record.claim_token.clone(), allow_preedit)
+        })
+        .unwrap_or((0, String::new(), false))
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    const TTL_MS: u64 = 5 * 60 * 1000;
+    const T0: u64 = 1_700_000_000_000;
+
+    fn table_with(sessions: &[(u64, u64)]) -> SessionTable {
+        let mut table = SessionTable::new(TTL_MS, T0);
+        for (session_id, engine_id) in sessions {
+            table.insert(*session_id, *engine_id, format!("claim-{}", session_id), T0);
+        }
+        table
+    }
+
+    #[test]
+    fn pending_commit_take_for_session_claim_consumes_exact_match() {
+        let mut table = table_with(&[(42, 1), (43, 1)]);
+        table.store_pending_commit(42, "hello".to_string(), T0);
+        table.store_pending_commit(43, "world".to_string(), T0);
+
+        assert_eq!(
+            table.take_pending_commit(42, "claim-42").as_deref(),
+            Some("hello")
+        );
+        assert_eq!(
+            table.take_pending_commit(43, "claim-43").as_deref(),
+            Some("world")
+        );
+        assert_eq!(table.take_pending_commit(42, "claim-42"), None);
+    }
+
+    #[test]
+    fn pending_commit_rejects_wrong_claim() {
+        let mut table = table_with(&[(61, 1)]);
+        table.store_pending_commit(61, "payload".to_string(), T0);
+
+        assert_eq!(table.take_pending_commit(61, "claim-wrong"), None);
+        assert_eq!(
+            table.take_pending_commit(61, "claim-61").as_deref(),
+            Some("payload")
+        );
+    }
+
+    #[test]
+    fn pending_commit_keeps_independent_queue_order() {
+        let mut table = table_with(&[(10, 1), (11, 1), (12, 1)]);
+        table.store_pending_commit(10, "first".to_string(), T0);
+        table.store_pending_commit(11, "second".to_string(), T0);
+        table.store_pending_commit(12, "third".to_string(), T0);
+
+        assert_eq!(
+            table.take_pending_commit(11, "claim-11").as_deref(),
+            Some("second")
+        );
+        assert_eq!(
+            table.take_pending_commit(10, "claim-10").as_deref(),
+            Some("first")
+        );
+        assert_eq!(
+            table.take_pending_commit(12, "claim-12").as_deref(),
+            Some("third")
+        );
+    }
+
+    #[test]
+    fn pending_commit_has_for_session_claim_matches_exact_claim() {
+        let mut table = table_with(&[(10, 1), (11, 1)]);
+        table.store_pending_commit(10, "first".to_string(), T0);
+
+        assert!(table.has_pending_commit(10, "claim-10"));
+        assert!(!table.has_pending_commit(10, "claim-other"));
+        assert!(!table.has_pending_commit(11, "claim-10"));
+    }
+
+    #[test]
+    fn pending_commit_stats_report_oldest_age_and_drops() {
+        let sessions: Vec<(u64, u64)> =
+            (0..=MAX_PENDING_COMMITS as u64).map(|id| (id, 1)).collect();
+        let mut table = table_with(&sessions);
+        for (session_id, _) in &sessions {
+            table.store_pending_commit(*session_id, "payload".to_string(), T0 + session_id);
+        }
+
+        let parsed: serde_json::Value =
+            serde_json::from_str(&table.pending_commit_stats_json(T0 + 100)).unwrap();
+        assert_eq!(parsed["queue_len"], MAX_PENDING_COMMITS);
+        assert_eq!(parsed["dropped_count"], 1);
+        // Session 0 was dropped, so session 1 is the oldest.
+        assert_eq!(parsed["oldest_age_ms"], 99);
+        assert!(!table.has_pending_commit(0, "claim-0"));
+    }
+
+    #[test]
+    fn select_active_session_prefers_ready_with_pending_over_newer_ready_without_pending() {
+        let mut table = table_with(&[(1, 99), (2, 99)]);
+        table.set_status(1, "ready", "with pending", 100);
+        table.set_status(2, "ready", "without pending", 200);
+        table.store_pending_commit(1, "text".to_string(), 100);
+
+        assert_eq!(
+            table.active_session_for_engine(99),
+            (1, "claim-1".to_string(), false)
+        );
+    }
+
+    #[test]
+    fn select_active_session_prefers_recording_over_ready_with_pending() {
+        let mut table = table_with(&[(1, 99), (2, 99)]);
+        table.set_status(1, "ready", "ready", T0);
+        table.store_pending_commit(1, "text".to_string(), T0);
+        table.set_status(2, "recording", "recording", T0);
+
+        assert_eq!(
+            table.active_session_for_engine(99),
+            (2, "claim-2".to_string(), true)
+        );
+    }
+
+    #[test]
+    fn select_active_session_skips_ready_without_pending_and_other_engines() {
+        let mut table = table_with(&[(1, 99), (2, 7)]);
+        table.set_status(1, "ready", "no pending", T0);
+        table.set_status(2, "recording", "other engine", T0);
+
+        assert_eq!(
+            table.active_session_for_engine(99),
+            (0, String::new(), false)
+        );
+    }
+
+    #[test]
+    fn select_active_session_allows_preedit_while_post_processing() {
+        let mut table = table_with(&[(1, 99)]);
+        table.set_status(1, "finalizing", "stopping", T0);
+        assert_eq!(
+            table.active_session_for_engine(99),
+            (1, "claim-1".to_string(), false)
+        );
+
+        table.set_status(1, "post-processing", "streaming", T0);
+        assert_eq!(
+            table.active_session_for_engine(99),
+            (1, "claim-1".to_string(), true)
+        );
+    }
+
+    #[test]
+    fn live_preedit_tracks_latest_revision_per_session() {
+        let mut table = table_with(&[(21, 1), (22, 1)]);
+        assert!(table.set_live_preedit(21, 1, Some("alpha".to_string())));
+        assert!(table.set_live_preedit(21, 3, Some("bravo".to_string())));
+        assert!(!table.set_live_preedit(21, 2, Some("stale".to_string())));
+        assert!(table.set_live_preedit(22, 9, Some("right".to_string())));
+
+        assert_eq!(
+            table.live_preedit(21, "claim-21"),
+            (3, true, "bravo".to_string())
+        );
+        assert_eq!(
+            table.live_preedit(22, "claim-22"),
+            (9, true, "right".to_string())
+        );
+        assert_eq!(
+            table.live_preedit(22, "claim-21"),
+            (0, false, String::new())
+        );
+    }
+
+    #[test]
+    fn live_preedit_clear_hides_entry() {
+        let mut table = table_with(&[(101, 1)]);
+        table.set_live_preedit(101, 3, Some("hello".to_string()));
+        table.set_live_preedit(101, 4, None);
+
+        assert_eq!(
+            table.live_preedit(101, "claim-101"),
+            (4, false, String::new())
+        );
+    }
+
+    #[test]
+    fn terminal_sessions_expire_after_ttl_from_last_change() {
+        let mut table = table_with(&[(1, 5), (2, 5), (3, 5)]);
+        table.set_status(1, "ready", "done", T0);
+        table.set_status(2, "committed", "done", T0);
+        table.set_status(3, "recording", "still going", T0);
+        // Reopened sessions cancel their timer; a later terminal change restarts it.
+        table.set_status(2, "recording", "again", T0 + 1_000);
+        table.set_status(2, "failed", "late failure", T0 + 60_000);
+
+        assert!(table.expire(T0 + TTL_MS - 1).is_empty());
+        assert_eq!(table.expire(T0 + TTL_MS + WHEEL_TICK_MS), vec![1]);
+        assert!(table.status(1).is_none());
+        assert_eq!(table.expire(T0 + 60_000 + TTL_MS + WHEEL_TICK_MS), vec![2]);
+        assert!(table.status(3).is_some());
+        assert_eq!(table.active_session_for_engine(5).0, 3);
+    }
+
+    #[test]
+    fn timer_wheel_refiles_timers_beyond_its_span() {
+        let mut wheel = TimerWheel::new(T0);
+        let far = T0 + (WHEEL_SLOTS as u64 * 3) * WHEEL_TICK_MS;
+        wheel.schedule(9, far);
+        let mut fired = Vec::new();
+        let mut now = T0;
+        while now <= far + WHEEL_TICK_MS {
+            now += 100 * WHEEL_TICK_MS;
+            wheel.advance(now, |id, _| fired.push((id, now)));
+        }
+        assert_eq!(fired.len(), 1);
+        assert!(fired[0].1 >= far);
+    }
+}
@@ -1,23 +1,25 @@
 use std::collections::{HashSet, VecDeque};
-use std::path::PathBuf;
 use std::sync::atomic::{AtomicBool, AtomicU64, Ordering};
 use std::sync::mpsc::RecvTimeoutError;
 use std::sync::{Mutex, OnceLock};
 use std::time::{Duration, Instant};
 
 use anyhow::{anyhow, Result};
-use evdev::{Device, EventType, InputEventKind};
 use log::{debug, error, info, warn};
 use notify_rust::Notification;
 use serde_json::json;
+use tokio::io::unix::AsyncFd;
 use tokio::sync::mpsc;
 
+use crate::dbus::note_shortcut_press;
 use crate::ibus_control::{get_current_engine, is_dikt_engine, switch_to_dikt_engine_verified};
 use crate::key_mapping::{
-    gdk_keyval_to_evdev, is_modifier_key, modifiers_from_held_keys, EvdevKeybinding, MOD_ALT,
-    MOD_CTRL, MOD_SHIFT, MOD_SUPER,
+    gdk_keyval_to_evdev, is_modifier_key, modifiers_from_held_keys, EvdevKeybinding,
+    EV_KEY_LEFTALT, EV_KEY_LEFTCTRL, EV_KEY_LEFTMETA, EV_KEY_LEFTSHIFT, EV_KEY_RIGHTALT,
+    EV_KEY_RIGHTCTRL, EV_KEY_RIGHTMETA, EV_KEY_RIGHTSHIFT, MOD_ALT, MOD_CTRL, MOD_SHIFT, MOD_SUPER,
 };
 use crate::settings::Settings;
+use crate::utils::input_devices::{find_keyboard_devices, KeyEvent, KeyboardWatcher};
 use crate::utils::launch::open_dikt_ui;
 
 const DIKT_BUS_NAME: &str = "io.dikt.Transcription";
@@ -523,7 +525,7 @@ async fn run_evdev_listener_loop(mut active_config: ShortcutConfig) {
             }
         };
 
-        match run_evdev_session(&active_config, &keybinding).await {
+        match run_evdev_session(active_config, keybinding).await {
             Ok(()) => {
                 // Session ended normally (settings changed, rebind requested)
                 info!("evdev session ended normally, restarting");
@@ -551,98 +553,111 @@ async fn run_evdev_listener_loop(mut active_config: ShortcutConfig) {
 }
 
 async fn run_evdev_session(
-    active_config: &ShortcutConfig,
-    keybinding: &EvdevKeybinding,
+    mut active_config: ShortcutConfig,
+    mut keybinding: EvdevKeybinding,
 ) -> Result<()> {
-    let devices = find_keyboard_devices()?;
-    if devices.is_empty() {
+    let watcher = KeyboardWatcher::open(&watched_keys(&keybinding))?;
+    if watcher.keyboard_count() == 0 {
         return Err(anyhow!(
             "No keyboard devices found. Check /dev/input/ permissions."
         ));
     }
+    let mut watcher =
+        AsyncFd::new(watcher).map_err(|e| anyhow!("Cannot poll keyboard devices: {}", e))?;
 
-    let description = active_config.human_description();
-    let n_devices = devices.len();
-    mark_shortcut_description(&description);
-    mark_health_success(&format!(
-        "Listening on {} keyboard(s) for {}",
-        n_devices, description
-    ));
+    let mut keyboard_count = watcher.get_ref().keyboard_count();
+    mark_listening(&active_config, keyboard_count);
     mark_toggle_state("idle");
-    info!(
-        "evdev: listening on {} keyboard device(s) for TOGGLE shortcut {}",
-        n_devices, description
-    );
 
     let (internal_tx, mut internal_rx) = mpsc::unbounded_channel::<InternalEvent>();
-    let (key_tx, mut key_rx) = mpsc::unbounded_channel::<KeyEvent>();
-
-    // Spawn a reader task for each keyboard device
-    let mut reader_handles = Vec::new();
-    for device_path in &devices {
-        let path = device_path.clone();
-        let tx = key_tx.clone();
-        let handle = tokio::spawn(async move {
-            if let Err(e) = read_device_events(path.clone(), tx).await {
-                warn!("evdev reader for {:?} ended: {}", path, e);
-            }
-        });
-        reader_handles.push(handle);
-    }
-    // Drop the original sender so the channel closes when all reader tasks end
-    drop(key_tx);
 
     let mut toggle_state = ToggleState::Idle;
     let mut config_poll = tokio::time::interval(Duration::from_millis(SETTINGS_POLL_INTERVAL_MS));
     let mut held_modifiers: HashSet<u16> = HashSet::new();
     let mut last_shortcut_press_ms = 0_u64;
+    let mut key_events = Vec::new();
 
     let loop_result = loop {
         tokio::select! {
             _ = config_poll.tick() => {
                 let new_config = ShortcutConfig::from_settings(&Settings::new());
-                if new_config != *active_config {
-                    info!("Toggle dictation settings changed, restarting evdev session");
-                    break Ok(());
+                if new_config != active_config {
+                    // Re-filter the open devices in place; only an unusable
+                    // shortcut needs the outer loop.
+                    let Some(new_keybinding) = new_config.resolve() else {
+                        info!("Toggle dictation settings changed, restarting evdev session");
+                        break Ok(());
+                    };
+                    info!(
+                        "Toggle dictation shortcut changed to {}",
+                        new_config.human_description()
+                    );
+                    watcher.get_mut().set_watched_keys(&watched_keys(&new_keybinding));
+                    active_config = new_config;
+                    keybinding = new_keybinding;
+                    mark_listening(&active_config, watcher.get_ref().keyboard_count());
                 }
                 if FORCE_REBIND_REQUESTED.swap(false, Ordering::SeqCst) {
-                    info!("Force rebind requested, restarting evdev session");
-                    break Ok(());
+                    match watcher.get_mut().rescan() {
+                        Ok(added) => info!("Force rebind requested, added {} keyboard(s)", added),
+                        Err(e) => warn!("Force rebind rescan failed: {}", e),
+                    }
                 }
             }
-            maybe_key = key_rx.recv() => {
-                let Some(event) = maybe_key else {
-                    // All reader tasks exited — keyboard disconnected?
-                    break Err(anyhow!(
-                        "All keyboard device readers disconnected"
-                    ));
+            ready = watcher.readable_mut() => {
+                let mut guard = match ready {
+                    Ok(guard) => guard,
+                    Err(e) => break Err(anyhow!("Keyboard poll failed: {}", e)),
                 };
+                key_events.clear();
+                match guard.get_inner_mut().drain(&mut key_events) {
+                    Ok(true) => {}
+                    Ok(false) => guard.clear_ready(),
+                    Err(e) => break Err(anyhow!("Keyboard poll failed: {}", e)),
+                }
+                drop(guard);
+
+                let count = watcher.get_ref().keyboard_count();
+                if count != keyboard_count {
+                    keyboard_count = count;
+                    if count == 0 {
+                        // Keep listening; a keyboard plugged in later is picked up.
+                        mark_health_error(
+                            "evdev_no_keyboards",
+                            "No keyboard devices connected",
+                        );
+                    } else {
+                        mark_listening(&active_config, count);
+                    }
+                }
 
-                match event {
-                    KeyEvent::Press(code) => {
-                        if is_modifier_key(code) {
-                            held_modifiers.insert(code);
-                        } else if code == keybinding.key_code {
-                            let current_mods = modifiers_from_held_keys(&held_modifiers);
-                            if current_mods == keybinding.modifiers {
-                                let now_ms = now_millis();
-                                if now_ms.saturating_sub(last_shortcut_press_ms)
-                                    < TOGGLE_PRESS_DEBOUNCE_MS
-                                {
-                                    push_toggle_event(format!(
-                                        "toggle:shortcut press ignored by debounce ({} ms)",
-                                        TOGGLE_PRESS_DEBOUNCE_MS
-                                    ));
-                                    continue;
+                for event in key_events.drain(..) {
+                    match event {
+                        KeyEvent::Press(code) => {
+                            if is_modifier_key(code) {
+                                held_modifiers.insert(code);
+                            } else if code == keybinding.key_code {
+                                let current_mods = modifiers_from_held_keys(&held_modifiers);
+                                if current_mods == keybinding.modifiers {
+                                    let now_ms = now_millis();
+                                    if now_ms.saturating_sub(last_shortcut_press_ms)
+                                        < TOGGLE_PRESS_DEBOUNCE_MS
+                                    {
+                                        push_toggle_event(format!(
+                                            "toggle:shortcut press ignored by debounce ({} ms)",
+                                            TOGGLE_PRESS_DEBOUNCE_MS
+                                        ));
+                                        continue;
+                                    }
+                                    last_shortcut_press_ms = now_ms;
+                                    on_global_pressed(&mut toggle_state, &internal_tx);
                                 }
-                                last_shortcut_press_ms = now_ms;
-                                on_global_pressed(&mut toggle_state, &internal_tx);
                             }
                         }
-                    }
-                    KeyEvent::Release(code) => {
-                        if is_modifier_key(code) {
-                            held_modifiers.remove(&code);
+                        KeyEvent::Release(code) => {
+                            if is_modifier_key(code) {
+                                held_modifiers.remove(&code);
+                            }
                         }
                     }
                 }
@@ -658,108 +673,36 @@ async fn run_evdev_session(
 
     cleanup_state(&mut toggle_state);
 
-    // Cancel all reader tasks
-    for handle in reader_handles {
-        handle.abort();
-    }
-
     loop_result
 }
 
-// ── evdev device management ────────────────────────────────────────────
-
-#[derive(Debug)]
-enum KeyEvent {
-    Press(u16),
-    Release(u16),
-}
-
-fn find_keyboard_devices() -> Result<Vec<PathBuf>> {
-    let mut keyboards = Vec::new();
-
-    let input_dir = std::fs::read_dir("/dev/input").map_err(|e| {
-        anyhow!(
-            "Cannot read /dev/input: {}. You may need to add your user to the 'input' group.",
-            e
-        )
-    })?;
-
-    for entry in input_dir.flatten() {
-        let path = entry.path();
-        let name = path
-            .file_name()
-            .and_then(|n| n.to_str())
-            .unwrap_or_default();
-        if !name.starts_with("event") {
-            continue;
-        }
-
-        match Device::open(&path) {
-            Ok(device) => {
-                // Check if this device has keyboard capabilities (EV_KEY with key codes)
-                if device.supported_events().contains(EventType::KEY) {
-                    let supported_keys = device.supported_keys();
-                    let has_keyboard_keys = supported_keys
-                        .map(|keys| {
-                            // A real keyboard has letter keys
-                            keys.contains(evdev::Key::KEY_A)
-                                && keys.contains(evdev::Key::KEY_Z)
-                                && keys.contains(evdev::Key::KEY_SPACE)
-                        })
-                        .unwrap_or(false);
-
-                    if has_keyboard_keys {
-                        let dev_name = device.name().unwrap_or("unknown");
-                        info!("evdev: found keyboard device {:?} ({})", path, dev_name);
-                        keyboards.push(path);
-                    }
-                }
-            }
-            Err(e) => {
-                debug!("evdev: cannot open {:?}: {}", path, e);
-            }
-        }
-    }
-
-    Ok(keyboards)
+fn mark_listening(config: &ShortcutConfig, keyboard_count: usize) {
+    let description = config.human_description();
+    mark_shortcut_description(&description);
+    mark_health_success(&format!(
+        "Listening on {} keyboard(s) for {}",
+        keyboard_count, description
+    ));
+    info!(
+        "evdev: listening on {} keyboard device(s) for TOGGLE shortcut {}",
+        keyboard_count, description
+    );
 }
 
-async fn read_device_events(path: PathBuf, tx: mpsc::UnboundedSender<KeyEvent>) -> Result<()> {
-    let device = Device::open(&path).map_err(|e| anyhow!("Failed to open {:?}: {}", path, e))?;
-    let mut stream = device
-        .into_event_stream()
-        .map_err(|e| anyhow!("Failed to create event stream for {:?}: {}", path, e))?;
-
-    loop {
-        let event = stream
-            .next_event()
-            .await
-            .map_err(|e| anyhow!("Event read error on {:?}: {}", path, e))?;
-
-        if let InputEventKind::Key(key) = event.kind() {
-            let code = key.code();
-            match event.value() {
-                1 => {
-                    // Key press
-                    if tx.send(KeyEvent::Press(code)).is_err() {
-                        break;
-                    }
-                }
-                0 => {
-                    // Key release
-                    if tx.send(KeyEvent::Release(code)).is_err() {
-                        break;
-                    }
-                }
-                2 => {
-                    // Key repeat — ignore for TOGGLE
-                }
-                _ => {}
-            }
-        }
-    }
-
-    Ok(())
+/// The shortcut key plus every modifier, since an extra held modifier must
+/// stop the shortcut from matching.
+fn watched_keys(keybinding: &EvdevKeybinding) -> Vec<u16> {
+    vec![
+        keybinding.key_code,
+        EV_KEY_LEFTCTRL,
+        EV_KEY_RIGHTCTRL,
+        EV_KEY_LEFTALT,
+        EV_KEY_RIGHTALT,
+        EV_KEY_LEFTSHIFT,
+        EV_KEY_RIGHTSHIFT,
+        EV_KEY_LEFTMETA,
+        EV_KEY_RIGHTMETA,
+    ]
 }
 
 // ── TOGGLE toggle handlers ─────────────────────────────────────────────────
@@ -828,6 +771,7 @@ fn start_toggle_recording(
     internal_tx: &mpsc::UnboundedSender<InternalEvent>,
 ) {
     debug_assert!(matches!(toggle_state, ToggleState::Idle));
+    note_shortcut_press();
 
     let current_engine = match get_current_engine() {
         Ok(engine) => Some(engine),
@@ -1,21 +1,19 @@
 use std::env;
-use std::ffi::{CStr, CString};
+use std::ffi::{c_int, CStr, CString};
 use std::fs;
 use std::path::{Path, PathBuf};
 use std::sync::atomic::{AtomicBool, Ordering};
-use std::thread;
 use std::time::{Duration, Instant, UNIX_EPOCH};
 
 use anyhow::{anyhow, Result};
 use ibus_sys::{
     gboolean, gchar, ibus_dikt_daemon_get_global_engine_name, ibus_dikt_daemon_reset_bus_cache,
-    ibus_dikt_daemon_set_global_engine,
+    ibus_dikt_daemon_set_global_engine, ibus_dikt_daemon_wait_global_engine_change,
 };
 use log::{info, warn};
 
 pub const DIKT_ENGINE_NAME: &str = "dikt";
 const DIKT_ENGINE_FALLBACK_NAME: &str = "other:dikt";
-const ENGINE_SWITCH_POLL_MS: u64 = 20;
 const IBUS_ADDRESS_PREFIX: &str = "IBUS_ADDRESS=";
 
 static IBUS_BOOTSTRAP_WARNING_EMITTED: AtomicBool = AtomicBool::new(false);
@@ -166,6 +164,28 @@ fn engine_matches_target(current: &str, target: &str) -> bool {
     }
 }
 
+/// Takes ownership of a name returned by the wrapper.
+fn take_engine_name(engine_ptr: *mut gchar) -> Option<String> {
+    if engine_ptr.is_null() {
+        return None;
+    }
+    let engine = unsafe { CStr::from_ptr(engine_ptr as *const i8) }
+        .to_string_lossy()
+        .trim()
+        .to_string();
+    unsafe {
+        glib::ffi::g_free(engine_ptr as *mut _);
+    }
+    Some(engine).filter(|engine| !engine.is_empty())
+}
+
+/// Blocks until IBus reports a global engine change after `generation`, or
+/// until `timeout` passes. Returns the cached engine name, if known.
+fn wait_for_engine_change(generation: &mut u64, timeout: Duration) -> Option<String> {
+    let timeout_ms = timeout.as_millis().min(c_int::MAX as u128) as c_int;
+    take_engine_name(unsafe { ibus_dikt_daemon_wait_global_engine_change(generation, timeout_ms) })
+}
+
 pub fn get_current_engine() -> Result<String> {
     ensure_ibus_address_for_daemon();
 
@@ -178,19 +198,7 @@ pub fn get_current_engine() -> Result<String> {
         return Err(anyhow!("IBus returned empty global engine"));
     }
 
-    let engine = unsafe { CStr::from_ptr(engine_ptr as *const i8) }
-        .to_string_lossy()
-        .trim()
-        .to_string();
-    unsafe {
-        glib::ffi::g_free(engine_ptr as *mut _);
-    }
-
-    if engine.is_empty() {
-        Err(anyhow!("IBus returned blank global engine"))
-    } else {
-        Ok(engine)
-    }
+    take_engine_name(engine_ptr).ok_or_else(|| anyhow!("IBus returned blank global engine"))
 }
 
 pub fn set_global_engine(engine_name: &str) -> Result<()> {
@@ -266,6 +274,10 @@ pub fn switch_engine_verified(target_engine: &str, timeout_ms: u64) -> Result<St
     let mut last_set_error = String::new();
     let mut last_engine = String::new();
     let mut last_error = String::new();
+    // Note the current cache generation so only changes after our first
+    // switch request wake the wait below.
+    let mut generation = 0_u64;
+    let _ = wait_for_engine_change(&mut generation, Duration::ZERO);
 
     loop {
         if last_set_attempt.elapsed() >= set_retry_interval {
@@ -296,7 +308,16 @@ pub fn switch_engine_verified(target_engine: &str, timeout_ms: u64) -> Result<St
         if start.elapsed() >= timeout {
             break;
         }
-        thread::sleep(Duration::from_millis(ENGINE_SWITCH_POLL_MS));
+        // Woken by IBus's global-engine-changed signal; the bound keeps the
+        // set retries going, and covers a daemon whose signals are not being
+        // dispatched.
+        let until_retry = set_retry_interval.saturating_sub(last_set_attempt.elapsed());
+        let remaining = timeout.saturating_sub(start.elapsed());
+        if let Some(engine) = wait_for_engine_change(&mut generation, until_retry.min(remaining)) {
+            if engine_matches_target(&engine, target_engine) {
+                return Ok(engine);
+            }
+        }
     }
 
     Err(anyhow!(
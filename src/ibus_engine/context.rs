@@ -1,5 +1,6 @@
 use std::ffi::{c_void, CString};
 use std::sync::atomic::{AtomicBool, Ordering};
+use std::sync::mpsc::{self, RecvTimeoutError};
 use std::sync::{Arc, Mutex, OnceLock};
 use std::time::Duration;
 
@@ -10,7 +11,7 @@ use zbus::blocking::Connection;
 
 use crate::utils::launch::open_dikt_ui;
 
-/// Owned reference to IBusEngine used by the command timer.
+/// Owned reference to IBusEngine used by the command dispatch callback.
 /// We hold an explicit GObject ref while the engine is active to prevent
 /// use-after-free if callbacks race with engine teardown.
 #[derive(Debug)]
@@ -52,11 +53,19 @@ struct SessionClaim {
 const DIKT_BUS_NAME: &str = "io.dikt.Transcription";
 const DIKT_OBJECT_PATH: &str = "/io/dikt/Transcription";
 const DIKT_INTERFACE: &str = "io.dikt.Transcription";
+/// Poll interval used only when the daemon's signals cannot be subscribed to.
 const PENDING_COMMIT_POLL_MS: u64 = 60;
+/// With signals, the listener still re-syncs this often in case one was missed
+/// (e.g. across a daemon restart): quickly while a session is active, rarely
+/// while idle.
+const SIGNAL_RESYNC_ACTIVE_MS: u64 = 1000;
+const SIGNAL_RESYNC_IDLE_MS: u64 = 10_000;
+/// While polling, how many poll ticks pass between attempts to subscribe
+/// again, e.g. until the daemon is back after a restart.
+const SIGNAL_RESUBSCRIBE_POLL_TICKS: u64 = 16;
 const PENDING_COMMIT_FAILURE_RECONNECT_THRESHOLD: u64 = 5;
 const LIVE_PREEDIT_POLL_TICKS: u64 = 4;
 const LIVE_PREEDIT_REFRESH_TICKS: u64 = 5;
-const COMMAND_POLL_INTERVAL_MS: u32 = 60;
 const DISABLE_PENDING_COMMIT_TIMEOUT_MS: u64 = 80;
 
 /// Commands that can be sent from background threads to be processed on the main thread.
@@ -67,6 +76,8 @@ enum EngineCommand {
         engine_id: u64,
         text: String,
         cursor_pos: u32,
+        /// Re-send even if the engine already shows this text.
+        refresh: bool,
     },
     HidePreedit {
         engine_id: u64,
@@ -78,7 +89,7 @@ enum EngineCommand {
 }
 
 /// Shared command queue accessible from both threads.
-/// Background thread pushes commands, timer callback on main thread processes them.
+/// Background thread pushes commands, dispatch callback on main thread processes them.
 struct CommandQueue {
     commands: Vec<EngineCommand>,
 }
@@ -93,29 +104,37 @@ fn get_command_queue() -> &'static Mutex<CommandQueue> {
     })
 }
 
-/// Current engine pointer and ID, only accessed from main thread via timer callback.
+/// Current engine pointer and ID, only accessed from main thread via dispatch callback.
 /// Set in enable(), cleared in disable().
 static CURRENT_ENGINE: Mutex<Option<EngineRef>> = Mutex::new(None);
 
-/// Ensures timer is only started once.
-static TIMER_STARTED: AtomicBool = AtomicBool::new(false);
+/// Set while a dispatch idle source is queued on the main context, so a burst
+/// of commands schedules a single callback.
+static DISPATCH_SCHEDULED: AtomicBool = AtomicBool::new(false);
 
-/// Timer callback that processes pending commands on the main thread.
+/// One-shot idle callback that processes pending commands on the main thread.
 /// This is a simple extern "C" function - no Rust closure trampoline that could crash.
 unsafe extern "C" fn process_commands_callback(_data: gpointer) -> gboolean {
+    // Clear before draining: a command pushed after the take below must
+    // schedule its own dispatch.
+    DISPATCH_SCHEDULED.store(false, Ordering::SeqCst);
+
     // Get commands from queue
     let commands: Vec<EngineCommand> = {
         let mut queue = match get_command_queue().lock() {
             Ok(q) => q,
-            Err(_) => return 1, // G_SOURCE_CONTINUE
+            Err(_) => return 0, // G_SOURCE_REMOVE
         };
         std::mem::take(&mut queue.commands)
     };
+    if commands.is_empty() {
+        return 0; // G_SOURCE_REMOVE
+    }
 
     // Get current engine
     let engine_guard = match CURRENT_ENGINE.lock() {
         Ok(g) => g,
-        Err(_) => return 1, // G_SOURCE_CONTINUE
+        Err(_) => return 0, // G_SOURCE_REMOVE
     };
 
     if let Some(engine_ref) = engine_guard.as_ref() {
@@ -127,30 +146,33 @@ unsafe extern "C" fn process_commands_callback(_data: gpointer) -> gboolean {
                     engine_id,
                     text,
                     cursor_pos,
+                    refresh,
                 } => {
                     if engine_id == current_engine_id && !engine_ptr.is_null() {
                         debug!(
-                            "Timer: UpdatePreedit engine_id={}, text_len={}",
+                            "Dispatch: UpdatePreedit engine_id={}, text_len={}",
                             engine_id,
                             text.len()
                         );
+                        if refresh {
+                            unsafe { ibus_sys::ibus_dikt_engine_invalidate_preedit(engine_ptr) };
+                        }
                         update_preedit_text(engine_ptr, &text, cursor_pos);
                     }
                 }
                 EngineCommand::HidePreedit { engine_id } => {
                     if engine_id == current_engine_id && !engine_ptr.is_null() {
-                        debug!("Timer: HidePreedit engine_id={}", engine_id);
+                        debug!("Dispatch: HidePreedit engine_id={}", engine_id);
                         hide_preedit_text(engine_ptr);
                     }
                 }
                 EngineCommand::CommitText { engine_id, text } => {
                     if engine_id == current_engine_id && !engine_ptr.is_null() {
                         debug!(
-                            "Timer: CommitText engine_id={}, text_len={}",
+                            "Dispatch: CommitText engine_id={}, text_len={}",
                             engine_id,
                             text.len()
                         );
-                        hide_preedit_text(engine_ptr);
                         commit_text_to_engine(engine_ptr, &text);
                     }
                 }
@@ -158,31 +180,51 @@ unsafe extern "C" fn process_commands_callback(_data: gpointer) -> gboolean {
         }
     }
 
-    1 // G_SOURCE_CONTINUE - keep timer running
+    0 // G_SOURCE_REMOVE - the next send_command schedules a new dispatch
 }
 
-/// Start the command processing timer. Only starts once per process lifetime.
-fn ensure_timer_started() {
-    if !TIMER_STARTED.swap(true, Ordering::SeqCst) {
+/// Queues a dispatch of pending commands on the main context unless one is
+/// already queued. `g_idle_add_full` is thread-safe and wakes the main loop,
+/// so nothing runs on the main thread while the queue stays empty.
+fn schedule_dispatch() {
+    if !DISPATCH_SCHEDULED.swap(true, Ordering::SeqCst) {
         unsafe {
-            glib::ffi::g_timeout_add(
-                COMMAND_POLL_INTERVAL_MS,
+            glib::ffi::g_idle_add_full(
+                glib::ffi::G_PRIORITY_DEFAULT,
                 Some(process_commands_callback),
                 std::ptr::null_mut(),
+                None,
             );
         }
-        info!(
-            "Command processing timer started ({}ms interval)",
-            COMMAND_POLL_INTERVAL_MS
-        );
     }
 }
 
 /// Helper to send a command from background thread
 fn send_command(cmd: EngineCommand) {
     if let Ok(mut queue) = get_command_queue().lock() {
+        coalesce_preedit_commands(&mut queue.commands, &cmd);
         queue.commands.push(cmd);
     }
+    schedule_dispatch();
+}
+
+/// A preedit update or hide replaces preedit commands for the same engine that
+/// are still queued behind the last commit; only the newest preview matters.
+fn coalesce_preedit_commands(commands: &mut Vec<EngineCommand>, next: &EngineCommand) {
+    let next_engine_id = match next {
+        EngineCommand::UpdatePreedit { engine_id, .. }
+        | EngineCommand::HidePreedit { engine_id } => *engine_id,
+        EngineCommand::CommitText { .. } => return,
+    };
+    while let Some(
+        EngineCommand::UpdatePreedit { engine_id, .. } | EngineCommand::HidePreedit { engine_id },
+    ) = commands.last()
+    {
+        if *engine_id != next_engine_id {
+            break;
+        }
+        commands.pop();
+    }
 }
 
 fn drain_engine_commands_for_disable(engine: *mut IBusEngine, engine_id: u64) -> usize {
@@ -243,6 +285,139 @@ fn drain_engine_commands_for_disable(engine: *mut IBusEngine, engine_id: u64) ->
     commits.len()
 }
 
+/// What the pending commit listener should fetch on this iteration.
+#[derive(Clone, Copy, Debug, Default)]
+struct ListenerWake {
+    commit: bool,
+    preedit: bool,
+}
+
+impl ListenerWake {
+    const RESYNC: Self = Self {
+        commit: true,
+        preedit: true,
+    };
+
+    fn merge(self, other: Self) -> Self {
+        Self {
+            commit: self.commit || other.commit,
+            preedit: self.preedit || other.preedit,
+        }
+    }
+}
+
+/// The daemon's `CommitReady` and `LivePreeditChanged` signals for one
+/// engine, read on a bus connection of their own.
+struct EngineSignals {
+    conn: Connection,
+    rx: mpsc::Receiver<ListenerWake>,
+    reader: std::thread::JoinHandle<()>,
+}
+
+impl EngineSignals {
+    /// Subscribes to the signals sent by the current owner of the daemon's
+    /// bus name. Fails when the daemon is not running, in which case the
+    /// listener polls and tries again later.
+    ///
+    /// The reader thread exits, disconnecting the channel, when that owner
+    /// loses the name (the daemon quit or restarted) or when the
+    /// subscription is closed.
+    fn subscribe(engine_id: u64) -> zbus::Result<Self> {
+        let conn = Connection::session()?;
+        let bus = zbus::blocking::fdo::DBusProxy::new(&conn)?;
+        let owner = bus.get_name_owner(zbus::names::BusName::try_from(DIKT_BUS_NAME)?)?;
+        // Created before the rules are added so no matching signal is missed.
+        let messages = zbus::blocking::MessageIterator::from(&conn);
+        // One rule per member, so other daemon signals (such as the level
+        // stream) are never delivered to this connection.
+        for member in ["CommitReady", "LivePreeditChanged"] {
+            bus.add_match_rule(
+                zbus::MatchRule::builder()
+                    .msg_type(zbus::message::Type::Signal)
+                    .sender(owner.as_str())?
+                    .path(DIKT_OBJECT_PATH)?
+                    .interface(DIKT_INTERFACE)?
+                    .member(member)?
+                    .build(),
+            )?;
+        }
+        bus.add_match_rule(
+            zbus::MatchRule::builder()
+                .msg_type(zbus::message::Type::Signal)
+                .sender("org.freedesktop.DBus")?
+                .interface("org.freedesktop.DBus")?
+                .member("NameOwnerChanged")?
+                .arg(0, DIKT_BUS_NAME)?
+                .build(),
+        )?;
+
+        let (tx, rx) = mpsc::channel();
+        let reader = std::thread::spawn(move || {
+            for message in messages {
+                // Errors only come from the connection itself, e.g. once the
+                // subscription is closed.
+                let Ok(message) = message else {
+                    break;
+                };
+                let header = message.header();
+                if header.message_type() != zbus::message::Type::Signal {
+                    continue;
+                }
+                let sender = header.sender().map(|sender| sender.as_str());
+                let member = header.member().map(|member| member.as_str());
+                if sender == Some("org.freedesktop.DBus") && member == Some("NameOwnerChanged") {
+                    info!("Dikt daemon left the bus; ending its signal subscription");
+                    break;
+                }
+                if sender != Some(owner.as_str()) {
+                    continue;
+                }
+                // Both signals lead with the target engine id.
+                let (wake, target) = match member {
+                    Some("CommitReady") => (
+                        ListenerWake {
+                            commit: true,
+                            preedit: false,
+                        },
+                        message
+                            .body()
+                            .deserialize::<(u64, u64)>()
+                            .map(|(target, _)| target),
+                    ),
+                    Some("LivePreeditChanged") => (
+                        ListenerWake {
+                            commit: false,
+                            preedit: true,
+                        },
+                        message
+                            .body()
+                            .deserialize::<(u64, u64, u64)>()
+                            .map(|(target, _, _)| target),
+                    ),
+                    _ => continue,
+                };
+                if target.ok() != Some(engine_id) {
+                    continue;
+                }
+                if tx.send(wake).is_err() {
+                    break;
+                }
+            }
+        });
+        Ok(Self { conn, rx, reader })
+    }
+
+    /// Closes the subscription's connection, which ends the reader's message
+    /// stream, and waits for the reader to exit.
+    fn close(self) {
+        drop(self.rx);
+        if let Err(e) = self.conn.close() {
+            debug!("Failed to close Dikt signal connection: {}", e);
+        }
+        let _ = self.reader.join();
+    }
+}
+
 pub struct DiktContext {
     connection: Option<Connection>,
     is_focused: bool,
@@ -287,6 +462,8 @@ impl DiktContext {
     pub fn focus_in(&mut self, _engine: *mut IBusEngine) {
         info!("IBus focus_in: engine={:?}", _engine);
         self.is_focused = true;
+        // The daemon also treats this as a hint to warm the model
+        // (see `model-preload-on-focus`), so no separate call is made here.
         self.set_focused_engine_state(_engine, true);
     }
 
@@ -308,15 +485,15 @@ impl DiktContext {
         let engine_id = engine as u64;
         self.current_engine_id = Some(engine_id);
 
-        // Store current engine in static for timer callback access
+        // Store current engine in static for dispatch callback access
         if let Ok(mut current) = CURRENT_ENGINE.lock() {
             *current = EngineRef::new(engine, engine_id);
         } else {
             warn!("Failed to store active engine reference: lock poisoned");
         }
 
-        // Ensure command processing timer is running
-        ensure_timer_started();
+        // Flush anything queued while no engine was enabled
+        schedule_dispatch();
 
         if self.connection.is_none() && !self.try_connect() {
             return;
@@ -375,7 +552,7 @@ impl DiktContext {
 
         // Note: Engine pointer NEVER crosses thread boundaries.
         // We only pass the engine_id, and commands are sent via the command queue.
-        // The main thread processes commands via the timer callback and safely
+        // The main thread processes commands via the dispatch callback and safely
         // accesses the engine pointer there.
 
         std::thread::spawn(move || {
@@ -395,15 +572,53 @@ impl DiktContext {
             let mut live_refresh_tick: u64 = 0;
             let mut active_session_id: u64 = 0;
             let mut active_claim_token = String::new();
+            let mut signals = EngineSignals::subscribe(engine_id)
+                .map_err(|e| {
+                    warn!(
+                        "Failed to subscribe to Dikt signals; falling back to polling: {}",
+                        e
+                    )
+                })
+                .ok();
 
             while !cancel.load(Ordering::SeqCst) {
-                std::thread::sleep(Duration::from_millis(PENDING_COMMIT_POLL_MS));
+                poll_tick = poll_tick.wrapping_add(1);
+                let wake = match signals.as_ref() {
+                    Some(subscription) => {
+                        let resync_ms = if active_session_id != 0 {
+                            SIGNAL_RESYNC_ACTIVE_MS
+                        } else {
+                            SIGNAL_RESYNC_IDLE_MS
+                        };
+                        let rx = &subscription.rx;
+                        match rx.recv_timeout(Duration::from_millis(resync_ms)) {
+                            Ok(first) => rx.try_iter().fold(first, ListenerWake::merge),
+                            Err(RecvTimeoutError::Timeout) => ListenerWake::RESYNC,
+                            Err(RecvTimeoutError::Disconnected) => {
+                                warn!("Dikt signal subscription ended; resubscribing");
+                                if let Some(ended) = signals.take() {
+                                    ended.close();
+                                }
+                                signals = EngineSignals::subscribe(engine_id).ok();
+                                ListenerWake::RESYNC
+                            }
+                        }
+                    }
+                    None => {
+                        std::thread::sleep(Duration::from_millis(PENDING_COMMIT_POLL_MS));
+                        if poll_tick.is_multiple_of(SIGNAL_RESUBSCRIBE_POLL_TICKS) {
+                            signals = EngineSignals::subscribe(engine_id).ok();
+                        }
+                        ListenerWake {
+                            commit: true,
+                            preedit: poll_tick.is_multiple_of(LIVE_PREEDIT_POLL_TICKS),
+                        }
+                    }
+                };
                 if cancel.load(Ordering::SeqCst) {
                     break;
                 }
 
-                poll_tick = poll_tick.wrapping_add(1);
-
                 let active_reply = conn.call_method(
                     Some(DIKT_BUS_NAME),
                     DIKT_OBJECT_PATH,
@@ -486,10 +701,7 @@ impl DiktContext {
                     continue;
                 }
 
-                if live_preedit_supported
-                    && next_allow_preedit
-                    && poll_tick.is_multiple_of(LIVE_PREEDIT_POLL_TICKS)
-                {
+                if live_preedit_supported && next_allow_preedit && wake.preedit {
                     match conn.call_method(
                         Some(DIKT_BUS_NAME),
                         DIKT_OBJECT_PATH,
@@ -520,6 +732,8 @@ impl DiktContext {
                                             engine_id,
                                             text: preedit_text.clone(),
                                             cursor_pos: text_len,
+                                            refresh: live_refresh_tick
+                                                >= LIVE_PREEDIT_REFRESH_TICKS,
                                         });
                                         live_refresh_tick = 0;
                                     } else if should_hide {
@@ -561,6 +775,10 @@ impl DiktContext {
                     live_refresh_tick = 0;
                 }
 
+                if !wake.commit {
+                    continue;
+                }
+
                 let reply = conn.call_method(
                     Some(DIKT_BUS_NAME),
                     DIKT_OBJECT_PATH,
@@ -636,6 +854,10 @@ impl DiktContext {
                     text: final_text,
                 });
             }
+
+            if let Some(signals) = signals {
+                signals.close();
+            }
         });
     }
 
@@ -838,7 +1060,6 @@ impl DiktContext {
             session_claim.session_id,
             trimmed.chars().count()
         );
-        hide_preedit_text(engine);
         commit_text_to_engine(engine, trimmed);
     }
 }
@@ -856,17 +1077,15 @@ fn update_preedit_text(engine: *mut IBusEngine, text: &str, cursor_pos: u32) {
         }
     };
 
+    // The shim skips the update when the client already shows this text.
     unsafe {
-        let ibus_text = ibus_sys::ibus_text_new_from_string(c_text.as_ptr());
-        if !ibus_text.is_null() {
-            ibus_sys::ibus_engine_update_preedit_text(
-                engine,
-                ibus_text,
-                cursor_pos as guint,
-                1 as gboolean,
-            );
-            ibus_sys::ibus_engine_show_preedit_text(engine);
-        }
+        ibus_sys::ibus_dikt_engine_apply_updates(
+            engine,
+            c_text.as_ptr(),
+            cursor_pos as guint,
+            1 as gboolean,
+            std::ptr::null(),
+        );
     }
 }
 
@@ -875,7 +1094,13 @@ fn hide_preedit_text(engine: *mut IBusEngine) {
         return;
     }
     unsafe {
-        ibus_sys::ibus_engine_hide_preedit_text(engine);
+        ibus_sys::ibus_dikt_engine_apply_updates(
+            engine,
+            std::ptr::null(),
+            0,
+            0 as gboolean,
+            std::ptr::null(),
+        );
     }
 }
 
@@ -891,11 +1116,15 @@ fn commit_text_to_engine(engine: *mut IBusEngine, text: &str) {
         }
     };
 
+    // Hides a visible preedit and commits in one call.
     unsafe {
-        let ibus_text = ibus_sys::ibus_text_new_from_string(c_text.as_ptr());
-        if !ibus_text.is_null() {
-            ibus_sys::ibus_engine_commit_text(engine, ibus_text);
-        }
+        ibus_sys::ibus_dikt_engine_apply_updates(
+            engine,
+            std::ptr::null(),
+            0,
+            0 as gboolean,
+            c_text.as_ptr(),
+        );
     }
 }
 
@@ -1,7 +1,46 @@
-use crate::settings::{PostProcessProvider, Settings};
-use log::debug;
+use crate::settings::{PostProcessProvider, Settings, SettingsSnapshot};
+use futures_util::StreamExt;
+use log::{debug, warn};
 use reqwest::header::{HeaderMap, HeaderValue, AUTHORIZATION, CONTENT_TYPE, REFERER, USER_AGENT};
 use serde::{Deserialize, Serialize};
+use std::collections::HashMap;
+use std::sync::{Mutex, OnceLock};
+use std::time::Duration;
+use tokio::runtime::Runtime;
+
+/// Idle pooled connections are kept this long so the next dictation reuses
+/// the TLS session instead of handshaking again.
+const POOL_IDLE_TIMEOUT: Duration = Duration::from_secs(90);
+/// Ping interval for HTTP/2 connections (negotiated over ALPN) and the TCP
+/// keep-alive interval for providers that only speak HTTP/1.1.
+const HTTP2_KEEP_ALIVE_INTERVAL: Duration = Duration::from_secs(30);
+const CONNECT_TIMEOUT: Duration = Duration::from_secs(10);
+
+/// Receives the text streamed so far each time a completion delta arrives.
+pub type PartialTextSink = Box<dyn FnMut(&str) + Send>;
+
+struct CachedClient {
+    base_url: String,
+    api_key: String,
+    client: reqwest::Client,
+}
+
+static CLIENTS: OnceLock<Mutex<HashMap<String, CachedClient>>> = OnceLock::new();
+static LLM_RUNTIME: OnceLock<Runtime> = OnceLock::new();
+
+/// Runtime that owns pooled LLM connections. Hyper drives each connection
+/// from a task on the runtime that opened it, so requests that should reuse
+/// the pool run here rather than on a short-lived caller runtime.
+pub fn llm_runtime() -> &'static Runtime {
+    LLM_RUNTIME.get_or_init(|| {
+        tokio::runtime::Builder::new_multi_thread()
+            .worker_threads(1)
+            .thread_name("dikt-llm")
+            .enable_all()
+            .build()
+            .expect("failed to build LLM runtime")
+    })
+}
 
 #[derive(Debug, Serialize)]
 struct ChatMessage {
@@ -13,6 +52,8 @@ struct ChatMessage {
 struct ChatCompletionRequest {
     model: String,
     messages: Vec<ChatMessage>,
+    #[serde(skip_serializing_if = "std::ops::Not::not")]
+    stream: bool,
 }
 
 #[derive(Debug, Deserialize)]
@@ -68,33 +109,69 @@ fn create_client(provider: &PostProcessProvider, api_key: &str) -> Result<reqwes
     let headers = build_headers(provider, api_key)?;
     reqwest::Client::builder()
         .default_headers(headers)
+        .connect_timeout(CONNECT_TIMEOUT)
+        .pool_idle_timeout(POOL_IDLE_TIMEOUT)
+        .pool_max_idle_per_host(2)
+        .tcp_keepalive(HTTP2_KEEP_ALIVE_INTERVAL)
+        .http2_keep_alive_interval(HTTP2_KEEP_ALIVE_INTERVAL)
+        .http2_keep_alive_while_idle(true)
         .build()
         .map_err(|e| format!("Failed to build HTTP client: {}", e))
 }
 
+/// Returns the provider's long-lived client, rebuilding it only when the base
+/// URL or key changed. `reqwest::Client` is a handle onto a shared pool, so
+/// clones reuse its open connections.
+fn cached_client(provider: &PostProcessProvider, api_key: &str) -> Result<reqwest::Client, String> {
+    let clients = CLIENTS.get_or_init(|| Mutex::new(HashMap::new()));
+    let mut clients = clients
+        .lock()
+        .map_err(|_| "LLM client cache lock poisoned".to_string())?;
+    if let Some(cached) = clients.get(&provider.id) {
+        if cached.base_url == provider.base_url && cached.api_key == api_key {
+            return Ok(cached.client.clone());
+        }
+    }
+    let client = create_client(provider, api_key)?;
+    clients.insert(
+        provider.id.clone(),
+        CachedClient {
+            base_url: provider.base_url.clone(),
+            api_key: api_key.to_string(),
+            client: client.clone(),
+        },
+    );
+    Ok(client)
+}
+
 fn get_provider(settings: &Settings) -> Option<PostProcessProvider> {
-    let provider_id = settings.post_process_provider_id();
-    let base_urls = settings.post_process_base_urls();
-
-    let base_url =
-        base_urls
-            .get(&provider_id)
-            .cloned()
-            .unwrap_or_else(|| match provider_id.as_str() {
-                "openai" => "https://api.openai.com/v1".to_string(),
-                "anthropic" => "https://api.anthropic.com/v1".to_string(),
-                "openrouter" => "https://openrouter.ai/api/v1".to_string(),
-                "groq" => "https://api.groq.com/openai/v1".to_string(),
-                "cerebras" => "https://api.cerebras.ai/v1".to_string(),
-                _ => "http://localhost:11434/v1".to_string(),
-            });
-
-    Some(PostProcessProvider {
-        id: provider_id.clone(),
-        label: provider_id.clone(),
+    Some(provider_for(
+        &settings.post_process_provider_id(),
+        &settings.post_process_base_urls(),
+    ))
+}
+
+/// Provider `provider_id` with its configured base URL, or the provider's
+/// public endpoint when none is set.
+pub fn provider_for(provider_id: &str, base_urls: &HashMap<String, String>) -> PostProcessProvider {
+    let base_url = base_urls
+        .get(provider_id)
+        .cloned()
+        .unwrap_or_else(|| match provider_id {
+            "openai" => "https://api.openai.com/v1".to_string(),
+            "anthropic" => "https://api.anthropic.com/v1".to_string(),
+            "openrouter" => "https://openrouter.ai/api/v1".to_string(),
+            "groq" => "https://api.groq.com/openai/v1".to_string(),
+            "cerebras" => "https://api.cerebras.ai/v1".to_string(),
+            _ => "http://localhost:11434/v1".to_string(),
+        });
+
+    PostProcessProvider {
+        id: provider_id.to_string(),
+        label: provider_id.to_string(),
         base_url,
         allow_base_url_edit: provider_id == "custom",
-    })
+    }
 }
 
 pub async fn call_llm(settings: &Settings, prompt: &str) -> Option<String> {
@@ -121,15 +198,14 @@ pub async fn call_llm(settings: &Settings, prompt: &str) -> Option<String> {
         .flatten()
 }
 
-pub async fn send_chat_completion(
+fn chat_request(
+    client: &reqwest::Client,
     provider: &PostProcessProvider,
-    api_key: String,
     model: &str,
     prompt: String,
-) -> Result<Option<String>, String> {
+    stream: bool,
+) -> reqwest::RequestBuilder {
     let base_url = provider.base_url.trim_end_matches('/');
-    let client = create_client(provider, &api_key)?;
-
     if provider.id == "anthropic" {
         // Anthropic uses /v1/messages with a different request/response format
         let url = format!("{}/messages", base_url);
@@ -138,31 +214,60 @@ pub async fn send_chat_completion(
         let request_body = serde_json::json!({
             "model": model,
             "max_tokens": 4096,
+            "stream": stream,
             "messages": [{
                 "role": "user",
                 "content": prompt
             }]
         });
+        client.post(&url).json(&request_body)
+    } else {
+        // OpenAI-compatible endpoint
+        let url = format!("{}/chat/completions", base_url);
+        debug!("Sending chat completion request to: {}", url);
 
-        let response = client
-            .post(&url)
-            .json(&request_body)
-            .send()
+        let request_body = ChatCompletionRequest {
+            model: model.to_string(),
+            messages: vec![ChatMessage {
+                role: "user".to_string(),
+                content: prompt,
+            }],
+            stream,
+        };
+        client.post(&url).json(&request_body)
+    }
+}
+
+async fn send_checked(request: reqwest::RequestBuilder) -> Result<reqwest::Response, String> {
+    let response = request
+        .send()
+        .await
+        .map_err(|e| format!("HTTP request failed: {}", e))?;
+
+    let status = response.status();
+    if !status.is_success() {
+        let error_text = response
+            .text()
             .await
-            .map_err(|e| format!("HTTP request failed: {}", e))?;
-
-        let status = response.status();
-        if !status.is_success() {
-            let error_text = response
-                .text()
-                .await
-                .unwrap_or_else(|_| "Failed to read error response".to_string());
-            return Err(format!(
-                "API request failed with status {}: {}",
-                status, error_text
-            ));
-        }
+            .unwrap_or_else(|_| "Failed to read error response".to_string());
+        return Err(format!(
+            "API request failed with status {}: {}",
+            status, error_text
+        ));
+    }
+    Ok(response)
+}
 
+pub async fn send_chat_completion(
+    provider: &PostProcessProvider,
+    api_key: String,
+    model: &str,
+    prompt: String,
+) -> Result<Option<String>, String> {
+    let client = cached_client(provider, &api_key)?;
+    let response = send_checked(chat_request(&client, provider, model, prompt, false)).await?;
+
+    if provider.id == "anthropic" {
         let body: serde_json::Value = response
             .json()
             .await
@@ -177,37 +282,6 @@ pub async fn send_chat_completion(
 
         Ok(text)
     } else {
-        // OpenAI-compatible endpoint
-        let url = format!("{}/chat/completions", base_url);
-        debug!("Sending chat completion request to: {}", url);
-
-        let request_body = ChatCompletionRequest {
-            model: model.to_string(),
-            messages: vec![ChatMessage {
-                role: "user".to_string(),
-                content: prompt,
-            }],
-        };
-
-        let response = client
-            .post(&url)
-            .json(&request_body)
-            .send()
-            .await
-            .map_err(|e| format!("HTTP request failed: {}", e))?;
-
-        let status = response.status();
-        if !status.is_success() {
-            let error_text = response
-                .text()
-                .await
-                .unwrap_or_else(|_| "Failed to read error response".to_string());
-            return Err(format!(
-                "API request failed with status {}: {}",
-                status, error_text
-            ));
-        }
-
         let completion: ChatCompletionResponse = response
             .json()
             .await
@@ -220,6 +294,120 @@ pub async fn send_chat_completion(
     }
 }
 
+/// Like `send_chat_completion`, but asks for a server-sent event stream and
+/// reports the accumulated text to `on_partial` as deltas arrive.
+pub async fn send_chat_completion_streaming(
+    provider: &PostProcessProvider,
+    api_key: String,
+    model: &str,
+    prompt: String,
+    mut on_partial: PartialTextSink,
+) -> Result<Option<String>, String> {
+    let client = cached_client(provider, &api_key)?;
+    let response = send_checked(chat_request(&client, provider, model, prompt, true)).await?;
+
+    let anthropic = provider.id == "anthropic";
+    let mut lines = SseLines::default();
+    let mut text = String::new();
+    let mut done = false;
+    let mut body = response.bytes_stream();
+    while let Some(chunk) = body.next().await {
+        let chunk = chunk.map_err(|e| format!("Failed to read API stream: {}", e))?;
+        let before = text.len();
+        lines.push(&chunk, |data| {
+            if data == "[DONE]" {
+                done = true;
+            } else if let Some(delta) = stream_delta(data, anthropic) {
+                text.push_str(&delta);
+            }
+        });
+        if text.len() != before {
+            on_partial(&text);
+        }
+        if done {
+            break;
+        }
+    }
+
+    Ok(if text.is_empty() { None } else { Some(text) })
+}
+
+/// Text carried by one streamed event. OpenAI-compatible servers send
+/// `choices[0].delta.content`; Anthropic sends `content_block_delta` events.
+fn stream_delta(data: &str, anthropic: bool) -> Option<String> {
+    let event: serde_json::Value = serde_json::from_str(data).ok()?;
+    let delta = if anthropic {
+        if event["type"] != "content_block_delta" {
+            return None;
+        }
+        &event["delta"]["text"]
+    } else {
+        &event["choices"][0]["delta"]["content"]
+    };
+    delta.as_str().map(str::to_string)
+}
+
+/// Splits a server-sent event byte stream into `data:` payloads. Network
+/// chunks can end mid-line or mid-character, so partial lines are buffered
+/// as bytes until their newline arrives.
+#[derive(Default)]
+struct SseLines {
+    partial: Vec<u8>,
+}
+
+impl SseLines {
+    fn push(&mut self, chunk: &[u8], mut on_data: impl FnMut(&str)) {
+        self.partial.extend_from_slice(chunk);
+        let mut start = 0;
+        while let Some(offset) = self.partial[start..].iter().position(|&b| b == b'\n') {
+            let line = &self.partial[start..start + offset];
+            start += offset + 1;
+            let line = line.strip_suffix(b"\r").unwrap_or(line);
+            if let Some(data) = line.strip_prefix(b"data:") {
+                if let Ok(data) = std::str::from_utf8(data) {
+                    on_data(data.trim_start());
+                }
+            }
+        }
+        self.partial.drain(..start);
+    }
+}
+
+/// Opens a connection to the configured provider ahead of the request, so
+/// the TCP and TLS handshakes overlap with recording. Only the handshake
+/// matters; the response is ignored.
+pub fn prewarm_post_process_connection(settings: &SettingsSnapshot) {
+    if !settings.post_process_enabled {
+        return;
+    }
+    let provider = provider_for(
+        &settings.post_process_provider_id,
+        &settings.post_process_base_urls,
+    );
+    let api_key = settings
+        .post_process_api_keys
+        .get(&provider.id)
+        .cloned()
+        .unwrap_or_default();
+    if api_key.is_empty() {
+        return;
+    }
+    let client = match cached_client(&provider, &api_key) {
+        Ok(client) => client,
+        Err(e) => {
+            warn!("Failed to prepare LLM client: {}", e);
+            return;
+        }
+    };
+    llm_runtime().spawn(async move {
+        let url = provider.base_url.trim_end_matches('/').to_string();
+        match client.head(&url).send().await {
+            Ok(_) => debug!("Pre-warmed LLM connection to {}", url),
+            Err(e) => debug!("LLM connection pre-warm to {} failed: {}", url, e),
+        }
+    });
+}
+
 pub async fn fetch_models(settings: &Settings) -> Result<Vec<String>, String> {
     let provider = get_provider(settings).ok_or("No provider configured")?;
     let api_keys = settings.post_process_api_keys();
@@ -230,7 +418,7 @@ pub async fn fetch_models(settings: &Settings) -> Result<Vec<String>, String> {
 
     debug!("Fetching models from: {}", url);
 
-    let client = create_client(&provider, &api_key)?;
+    let client = cached_client(&provider, &api_key)?;
 
     let response = client
         .get(&url)
@@ -275,3 +463,38 @@ pub async fn fetch_models(settings: &Settings) -> Result<Vec<String>, String> {
 
     Ok(models)
 }
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn sse_lines_survive_arbitrary_chunk_boundaries() {
+        let stream = "data: {\"choices\":[{\"delta\":{\"content\":\"Caf\u{e9}\"}}]}\r\n\n\
+                      : keep-alive\n\
+                      data: {\"choices\":[{\"delta\":{\"content\":\" ok\"}}]}\n\n\
+                      data: [DONE]\n\n";
+        for split in 1..stream.len() {
+            let mut sse = SseLines::default();
+            let mut events = Vec::new();
+            for chunk in stream.as_bytes().chunks(split) {
+                sse.push(chunk, |data| events.push(data.to_string()));
+            }
+            let text: String = events
+                .iter()
+                .filter_map(|data| stream_delta(data, false))
+                .collect();
+            assert_eq!(text, "Caf\u{e9} ok");
+            assert_eq!(events.last().map(String::as_str), Some("[DONE]"));
+        }
+    }
+
+    #[test]
+    fn anthropic_stream_only_reads_text_deltas() {
+        let start = r#"{"type":"message_start","message":{"content":[]}}"#;
+        let delta = r#"{"type":"content_block_delta","delta":{"type":"text_delta","text":"Hi"}}"#;
+        assert_eq!(stream_delta(start, true), None);
+        assert_eq!(stream_delta(delta, true).as_deref(), Some("Hi"));
+        assert_eq!(stream_delta(delta, false), None);
+    }
+}
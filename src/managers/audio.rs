@@ -1,5 +1,9 @@
-use crate::audio_toolkit::{list_input_devices, vad::SmoothedVad, AudioRecorder, SileroVad};
-use log::{debug, error, info};
+use crate::audio_toolkit::{
+    default_spill_dir, list_input_devices, recover_spilled_recordings, vad::SmoothedVad,
+    AudioRecorder, ResamplerMode, SampleView, SileroVad, SpeechActivity,
+};
+use crate::managers::level_meter::LevelMeter;
+use log::{debug, error, info, warn};
 use std::path::PathBuf;
 use std::sync::{Arc, Mutex};
 use std::time::Instant;
@@ -60,6 +64,10 @@ pub struct AudioRecordingManager {
     mode: Arc<Mutex<MicrophoneMode>>,
     selected_microphone: Arc<Mutex<Option<String>>>,
     mute_while_recording: Arc<Mutex<bool>>,
+    low_latency_resampler: Arc<Mutex<bool>>,
+    spill_long_recordings: Arc<Mutex<bool>>,
+    level_meter: Arc<LevelMeter>,
+    speech_activity: Arc<SpeechActivity>,
     recorder: Arc<Mutex<Option<AudioRecorder>>>,
     is_open: Arc<Mutex<bool>>,
     did_mute: Arc<Mutex<bool>>,
@@ -108,6 +116,10 @@ impl AudioRecordingManager {
             mode: Arc::new(Mutex::new(mode.clone())),
             selected_microphone: Arc::new(Mutex::new(settings.selected_microphone())),
             mute_while_recording: Arc::new(Mutex::new(settings.mute_while_recording())),
+            low_latency_resampler: Arc::new(Mutex::new(settings.low_latency_resampler())),
+            spill_long_recordings: Arc::new(Mutex::new(settings.spill_long_recordings())),
+            level_meter: Arc::new(LevelMeter::new()),
+            speech_activity: Arc::new(SpeechActivity::new()),
             recorder: Arc::new(Mutex::new(None)),
             is_open: Arc::new(Mutex::new(false)),
             did_mute: Arc::new(Mutex::new(false)),
@@ -142,10 +154,16 @@ Falling back to on-demand mode.",
         }
     }
 
-    pub fn apply_mute(&self) {
+    /// Mutes output if `still_recording` holds. It is checked under the same
+    /// lock as [`Self::remove_mute`], so a mute that runs late, after the stop
+    /// already unmuted, is skipped instead of left in place.
+    pub fn apply_mute(&self, still_recording: impl FnOnce() -> bool) {
         let mut did_mute_guard = self.did_mute.lock().unwrap();
 
-        if *self.mute_while_recording.lock().unwrap() && *self.is_open.lock().unwrap() {
+        if *self.mute_while_recording.lock().unwrap()
+            && *self.is_open.lock().unwrap()
+            && still_recording()
+        {
             set_mute(true);
             *did_mute_guard = true;
             debug!("Mute applied");
@@ -175,12 +193,18 @@ or resources/models/silero_vad_v4.onnx"
                 .ok_or_else(|| anyhow::anyhow!("Silero VAD model path contains invalid UTF-8"))?,
             0.3,
         )
-        .map_err(|e| anyhow::anyhow!("Failed to create SileroVad: {}", e))?;
+        .map_err(|e| anyhow::anyhow!("Failed to create SileroVad: {}", e))?
+        .with_frames_per_call(crate::settings::settings_snapshot().vad_frames_per_call as usize);
         let smoothed_vad = SmoothedVad::new(Box::new(silero), 15, 15, 2);
 
+        let level_meter = self.level_meter.clone();
         let recorder = AudioRecorder::new()
             .map_err(|e| anyhow::anyhow!("Failed to create AudioRecorder: {}", e))?
-            .with_vad(Box::new(smoothed_vad));
+            .with_vad(Box::new(smoothed_vad))
+            .with_speech_activity(self.speech_activity.clone())
+            .with_level_callback(self.level_meter.rate_handle(), move |levels| {
+                level_meter.publish(levels)
+            });
 
         Ok(recorder)
     }
@@ -206,6 +230,11 @@ or resources/models/silero_vad_v4.onnx"
         let selected_device = self.get_effective_microphone_device();
 
         if let Some(rec) = recorder_opt.as_mut() {
+            rec.set_resampler_mode(if *self.low_latency_resampler.lock().unwrap() {
+                ResamplerMode::LowLatency
+            } else {
+                ResamplerMode::Quality
+            });
             rec.open(selected_device)
                 .map_err(|e| anyhow::anyhow!("Failed to open recorder: {}", e))?;
         }
@@ -277,6 +306,43 @@ or resources/models/silero_vad_v4.onnx"
         *self.mute_while_recording.lock().unwrap() = value;
     }
 
+    /// Microphone level leases; levels are only computed while one is held.
+    pub fn level_meter(&self) -> &LevelMeter {
+        &self.level_meter
+    }
+
+    /// Applies the next time the microphone stream is opened.
+    pub fn set_low_latency_resampler(&self, value: bool) {
+        *self.low_latency_resampler.lock().unwrap() = value;
+    }
+
+    /// Applies from the next recording.
+    pub fn set_spill_long_recordings(&self, value: bool) {
+        *self.spill_long_recordings.lock().unwrap() = value;
+    }
+
+    /// Saves recordings a crashed daemon left in the spill directory as WAV
+    /// files under the data directory, so the audio is not lost.
+    pub fn recover_interrupted_recordings() {
+        let recovered_dir = std::env::var("XDG_DATA_HOME")
+            .map(|p| PathBuf::from(p).join("dikt").join("recovered"))
+            .unwrap_or_else(|_| {
+                dirs::data_dir()
+                    .unwrap_or_else(|| PathBuf::from("."))
+                    .join("dikt")
+                    .join("recovered")
+            });
+        match recover_spilled_recordings(&default_spill_dir(), &recovered_dir) {
+            Ok(recovered) if !recovered.is_empty() => warn!(
+                "Recovered {} interrupted recording(s) to {:?}",
+                recovered.len(),
+                recovered_dir
+            ),
+            Ok(_) => {}
+            Err(e) => error!("Failed to look for interrupted recordings: {}", e),
+        }
+    }
+
     pub fn set_selected_microphone(&self, value: Option<String>) -> Result<(), anyhow::Error> {
         *self.selected_microphone.lock().unwrap() = value;
         self.update_selected_device()
@@ -304,7 +370,9 @@ or resources/models/silero_vad_v4.onnx"
                 }
             }
 
-            if let Some(rec) = self.recorder.lock().unwrap().as_ref() {
+            if let Some(rec) = self.recorder.lock().unwrap().as_mut() {
+                let spill = *self.spill_long_recordings.lock().unwrap();
+                rec.set_spill_dir(spill.then(default_spill_dir));
                 match rec.start() {
                     Ok(()) => {
                         *state = RecordingState::Recording {
@@ -339,7 +407,7 @@ or resources/models/silero_vad_v4.onnx"
         Ok(())
     }
 
-    pub fn stop_recording(&self, binding_id: &str) -> Option<Vec<f32>> {
+    pub fn stop_recording(&self, binding_id: &str) -> Option<SampleView> {
         let mut state = self.state.lock().unwrap();
 
         match *state {
@@ -354,12 +422,12 @@ or resources/models/silero_vad_v4.onnx"
                         Ok(buf) => buf,
                         Err(e) => {
                             error!("stop() failed: {e}");
-                            Vec::new()
+                            SampleView::default()
                         }
                     }
                 } else {
                     error!("Recorder not available");
-                    Vec::new()
+                    SampleView::default()
                 };
 
                 if matches!(*self.mode.lock().unwrap(), MicrophoneMode::OnDemand) {
@@ -368,9 +436,9 @@ or resources/models/silero_vad_v4.onnx"
 
                 let s_len = samples.len();
                 if s_len < WHISPER_SAMPLE_RATE && s_len > 0 {
-                    let mut padded = samples;
+                    let mut padded = samples.into_vec();
                     padded.resize(WHISPER_SAMPLE_RATE * 5 / 4, 0.0);
-                    Some(padded)
+                    Some(padded.into())
                 } else {
                     Some(samples)
                 }
@@ -379,6 +447,15 @@ or resources/models/silero_vad_v4.onnx"
         }
     }
 
+    /// When the current or last recording first kept speech.
+    pub fn speech_onset(&self) -> Option<Instant> {
+        self.recorder
+            .lock()
+            .unwrap()
+            .as_ref()
+            .and_then(AudioRecorder::speech_onset)
+    }
+
     pub fn is_recording(&self) -> bool {
         matches!(
             *self.state.lock().unwrap(),
@@ -386,7 +463,7 @@ or resources/models/silero_vad_v4.onnx"
         )
     }
 
-    pub fn snapshot_recording(&self, binding_id: &str) -> Option<Vec<f32>> {
+    pub fn snapshot_recording(&self, binding_id: &str) -> Option<SampleView> {
         let state = self.state.lock().unwrap();
         let is_active_binding = matches!(
             *state,
@@ -415,7 +492,7 @@ or resources/models/silero_vad_v4.onnx"
         &self,
         binding_id: &str,
         max_samples: usize,
-    ) -> Option<Vec<f32>> {
+    ) -> Option<SampleView> {
         let state = self.state.lock().unwrap();
         let is_active_binding = matches!(
             *state,
@@ -440,6 +517,72 @@ or resources/models/silero_vad_v4.onnx"
         }
     }
 
+    /// Speech activity shared by every recorder this manager creates, so the
+    /// handle stays valid across recordings and recorder restarts.
+    pub fn speech_activity(&self) -> Arc<SpeechActivity> {
+        self.speech_activity.clone()
+    }
+
+    pub fn snapshot_recording_since(
+        &self,
+        binding_id: &str,
+        start: usize,
+    ) -> Option<(usize, SampleView)> {
+        let state = self.state.lock().unwrap();
+        let is_active_binding = matches!(
+            *state,
+            RecordingState::Recording {
+                binding_id: ref active,
+            } if active == binding_id
+        );
+        drop(state);
+
+        if !is_active_binding {
+            return None;
+        }
+
+        let recorder_guard = self.recorder.lock().unwrap();
+        let recorder = recorder_guard.as_ref()?;
+        match recorder.snapshot_since(start) {
+            Ok(snapshot) => Some(snapshot),
+            Err(e) => {
+                error!("snapshot_since() failed: {e}");
+                None
+            }
+        }
+    }
+
+    pub fn recording_segment_since(
+        &self,
+        binding_id: &str,
+        start: usize,
+        min_len: usize,
+        max_len: usize,
+    ) -> Option<(usize, SampleView)> {
+        let state = self.state.lock().unwrap();
+        let is_active_binding = matches!(
+            *state,
+            RecordingState::Recording {
+                binding_id: ref active,
+            } if active == binding_id
+        );
+        drop(state);
+
+        if !is_active_binding {
+            return None;
+        }
+
+        let recorder_guard = self.recorder.lock().unwrap();
+        let recorder = recorder_guard.as_ref()?;
+        match recorder.segment_since(start, min_len, max_len) {
+            Ok(segment) => segment,
+            Err(e) => {
+                error!("segment_since() failed: {e}");
+                None
+            }
+        }
+    }
+
     pub fn cancel_recording(&self) {
         let mut state = self.state.lock().unwrap();
 
@@ -460,7 +603,7 @@ or resources/models/silero_vad_v4.onnx"
     }
 }
 
-fn resolve_vad_model_path() -> Option<PathBuf> {
+pub fn resolve_vad_model_path() -> Option<PathBuf> {
     let candidates = [
         PathBuf::from("/usr/share/dikt/models/silero_vad_v4.onnx"),
         PathBuf::from("resources/models/silero_vad_v4.onnx"),
@@ -0,0 +1,647 @@
+//! Ranged, resumable model downloads.
+//!
+//! A file is fetched as fixed-size chunks over several connections into a
+//! preallocated `.partial` file. Finished chunks are recorded in a bitmap
+//! beside it, so an interrupted download resumes with only the missing
+//! chunks. Workers always take the lowest missing chunk, and [`InOrderReader`]
+//! hands out bytes as soon as the contiguous prefix covers them, which lets
+//! archive extraction run alongside the download instead of after it.
+
+use anyhow::Result;
+use futures_util::StreamExt;
+use log::{debug, info, warn};
+use serde::{Deserialize, Serialize};
+use std::fs::{self, File, OpenOptions};
+use std::io::{self, Read};
+use std::os::unix::fs::FileExt;
+use std::path::{Path, PathBuf};
+use std::sync::atomic::{AtomicBool, Ordering};
+use std::sync::{Arc, Condvar, Mutex};
+use std::time::Duration;
+
+pub const CHUNK_SIZE: u64 = 8 * 1024 * 1024;
+const CONNECTIONS: usize = 4;
+/// Attempts per chunk before the whole download is reported as failed.
+const CHUNK_ATTEMPTS: u32 = 4;
+const RETRY_BACKOFF: Duration = Duration::from_millis(500);
+
+/// Persisted record of which chunks of `url` are already on disk.
+#[derive(Debug, Serialize, Deserialize)]
+struct ChunkMap {
+    url: String,
+    total: u64,
+    chunk_size: u64,
+    /// One bit per chunk, least significant bit first.
+    done: Vec<u8>,
+}
+
+impl ChunkMap {
+    fn new(url: &str, total: u64, chunk_size: u64) -> Self {
+        let chunks = total.div_ceil(chunk_size) as usize;
+        Self {
+            url: url.to_string(),
+            total,
+            chunk_size,
+            done: vec![0; chunks.div_ceil(8)],
+        }
+    }
+
+    fn chunk_count(&self) -> usize {
+        self.total.div_ceil(self.chunk_size) as usize
+    }
+
+    fn is_done(&self, index: usize) -> bool {
+        self.done[index / 8] & (1 << (index % 8)) != 0
+    }
+
+    fn mark_done(&mut self, index: usize) {
+        self.done[index / 8] |= 1 << (index % 8);
+    }
+
+    /// Byte range `[start, end)` covered by chunk `index`.
+    fn chunk_range(&self, index: usize) -> (u64, u64) {
+        let start = index as u64 * self.chunk_size;
+        (start, (start + self.chunk_size).min(self.total))
+    }
+
+    fn done_bytes(&self) -> u64 {
+        (0..self.chunk_count())
+            .filter(|&i| self.is_done(i))
+            .map(|i| {
+                let (start, end) = self.chunk_range(i);
+                end - start
+            })
+            .sum()
+    }
+
+    fn load(path: &Path) -> Option<Self> {
+        let map: Self = serde_json::from_slice(&fs::read(path).ok()?).ok()?;
+        let valid = map.chunk_size > 0 && map.done.len() == map.chunk_count().div_ceil(8);
+        valid.then_some(map)
+    }
+
+    /// Written beside the target and renamed over it, so a crash leaves
+    /// either the old or the new bitmap and never a torn one.
+    fn save(&self, path: &Path) -> io::Result<()> {
+        let tmp = path.with_extension("chunks.tmp");
+        fs::write(&tmp, serde_json::to_vec(self)?)?;
+        fs::rename(&tmp, path)
+    }
+}
+
+/// Sidecar bitmap path for a `.partial` download file.
+pub fn chunk_map_path(partial_path: &Path) -> PathBuf {
+    let mut name = partial_path.as_os_str().to_owned();
+    name.push(".chunks");
+    PathBuf::from(name)
+}
+
+/// Bytes a resumed download would not fetch again, if `partial_path` has a
+/// chunk bitmap. The partial file itself is preallocated to full size, so
+/// its length says nothing about progress.
+pub fn resumable_bytes(partial_path: &Path) -> Option<u64> {
+    ChunkMap::load(&chunk_map_path(partial_path)).map(|map| map.done_bytes())
+}
+
+#[derive(Clone, Debug, PartialEq, Eq)]
+enum Outcome {
+    Finished,
+    Cancelled,
+    Failed(String),
+}
+
+pub enum DownloadOutcome {
+    Complete,
+    Cancelled,
+}
+
+struct Progress {
+    map: ChunkMap,
+    /// Bytes written so far into each chunk that is not yet done.
+    filled: Vec<u64>,
+    claimed: Vec<bool>,
+    outcome: Option<Outcome>,
+}
+
+impl Progress {
+    /// End of the prefix that is fully on disk.
+    fn frontier(&self) -> u64 {
+        for index in 0..self.map.chunk_count() {
+            if !self.map.is_done(index) {
+                return self.map.chunk_range(index).0 + self.filled[index];
+            }
+        }
+        self.map.total
+    }
+
+    fn downloaded(&self) -> u64 {
+        self.map.done_bytes()
+            + (0..self.map.chunk_count())
+                .filter(|&i| !self.map.is_done(i))
+                .map(|i| self.filled[i])
+                .sum::<u64>()
+    }
+
+    /// Lowest chunk that is neither done nor being fetched.
+    fn claim_next(&mut self) -> Option<usize> {
+        let index =
+            (0..self.map.chunk_count()).find(|&i| !self.map.is_done(i) && !self.claimed[i])?;
+        self.claimed[index] = true;
+        self.filled[index] = 0;
+        Some(index)
+    }
+}
+
+struct Shared {
+    progress: Mutex<Progress>,
+    changed: Condvar,
+}
+
+impl Shared {
+    fn finish(&self, outcome: Outcome) {
+        let mut progress = self.progress.lock().unwrap();
+        progress.outcome.get_or_insert(outcome);
+        self.changed.notify_all();
+    }
+}
+
+pub struct RangedDownload {
+    client: reqwest::Client,
+    url: String,
+    partial_path: PathBuf,
+    map_path: PathBuf,
+    file: Arc<File>,
+    shared: Arc<Shared>,
+    /// False when the server ignores `Range`; the body is then streamed over
+    /// one connection and cannot be resumed.
+    ranged: bool,
+}
+
+impl RangedDownload {
+    /// Probes `url` for its size and range support, then resumes from the
+    /// bitmap beside `partial_path` or starts a fresh preallocated file.
+    pub async fn open(client: &reqwest::Client, url: &str, partial_path: &Path) -> Result<Self> {
+        let probe = client
+            .get(url)
+            .header(reqwest::header::RANGE, "bytes=0-0")
+            .send()
+            .await
+            .map_err(|e| anyhow::anyhow!("Download request failed: {}", e))?;
+        if !probe.status().is_success() {
+            return Err(anyhow::anyhow!(
+                "Failed to download: HTTP {}",
+                probe.status()
+            ));
+        }
+        let ranged_total = if probe.status() == reqwest::StatusCode::PARTIAL_CONTENT {
+            probe
+                .headers()
+                .get(reqwest::header::CONTENT_RANGE)
+                .and_then(|value| value.to_str().ok())
+                .and_then(content_range_total)
+        } else {
+            None
+        };
+        let streamed_total = probe.content_length().unwrap_or(0);
+        drop(probe);
+
+        let map_path = chunk_map_path(partial_path);
+        let (map, file) = match ranged_total {
+            Some(total) => {
+                let map = Self::resume_map(url, total, partial_path, &map_path);
+                let file = OpenOptions::new()
+                    .create(true)
+                    .truncate(false)
+                    .read(true)
+                    .write(true)
+                    .open(partial_path)?;
+                file.set_len(total)?;
+                map.save(&map_path)?;
+                (map, file)
+            }
+            None => {
+                debug!("{} does not support ranged requests; using one stream", url);
+                let _ = fs::remove_file(&map_path);
+                // One chunk covering the whole body; its real length is
+                // taken from the stream if the server did not report it.
+                let total = streamed_total.max(1);
+                (
+                    ChunkMap::new(url, total, total),
+                    File::create(partial_path)?,
+                )
+            }
+        };
+
+        let chunks = map.chunk_count();
+        Ok(Self {
+            client: client.clone(),
+            url: url.to_string(),
+            partial_path: partial_path.to_path_buf(),
+            map_path,
+            file: Arc::new(file),
+            shared: Arc::new(Shared {
+                progress: Mutex::new(Progress {
+                    map,
+                    filled: vec![0; chunks],
+                    claimed: vec![false; chunks],
+                    outcome: None,
+                }),
+                changed: Condvar::new(),
+            }),
+            ranged: ranged_total.is_some(),
+        })
+    }
+
+    fn resume_map(url: &str, total: u64, partial_path: &Path, map_path: &Path) -> ChunkMap {
+        if let Some(map) = ChunkMap::load(map_path) {
+            let file_len = partial_path.metadata().map(|m| m.len()).unwrap_or(0);
+            if map.url == url
+                && map.total == total
+                && map.chunk_size == CHUNK_SIZE
+                && file_len == total
+            {
+                info!(
+                    "Resuming download of {} with {} bytes already on disk",
+                    url,
+                    map.done_bytes()
+                );
+                return map;
+            }
+            warn!("Discarding stale chunk map for {}", partial_path.display());
+            return ChunkMap::new(url, total, CHUNK_SIZE);
+        }
+
+        // A partial left by a plain sequential download: keep whole chunks.
+        let mut map = ChunkMap::new(url, total, CHUNK_SIZE);
+        let file_len = partial_path.metadata().map(|m| m.len()).unwrap_or(0);
+        for index in 0..map.chunk_count() {
+            if map.chunk_range(index).1 <= file_len.min(total) {
+                map.mark_done(index);
+            }
+        }
+        map
+    }
+
+    pub fn downloaded(&self) -> u64 {
+        self.shared.progress.lock().unwrap().downloaded()
+    }
+
+    pub fn total(&self) -> u64 {
+        self.shared.progress.lock().unwrap().map.total
+    }
+
+    /// Reads the file front to back, waiting for bytes that have not
+    /// arrived yet. Fails if the download is cancelled or fails.
+    pub fn reader(&self) -> Result<InOrderReader> {
+        Ok(InOrderReader {
+            file: File::open(&self.partial_path)?,
+            pos: 0,
+            shared: self.shared.clone(),
+        })
+    }
+
+    /// Fetches every missing chunk. `on_progress` receives total bytes on
+    /// disk after each write.
+    pub async fn run(
+        &self,
+        cancel: &AtomicBool,
+        on_progress: &(dyn Fn(u64) + Sync),
+    ) -> Result<DownloadOutcome> {
+        let remaining = {
+            let progress = self.shared.progress.lock().unwrap();
+            (0..progress.map.chunk_count())
+                .filter(|&i| !progress.map.is_done(i))
+                .count()
+        };
+        let connections = if self.ranged { CONNECTIONS } else { 1 };
+        let workers = (0..connections.min(remaining)).map(|_| self.worker(cancel, on_progress));
+        let results = futures_util::future::join_all(workers).await;
+
+        let outcome = if let Some(Err(e)) = results.iter().find(|result| result.is_err()) {
+            Outcome::Failed(e.to_string())
+        } else if cancel.load(Ordering::Acquire) {
+            Outcome::Cancelled
+        } else {
+            Outcome::Finished
+        };
+        self.shared.finish(outcome.clone());
+        match outcome {
+            Outcome::Finished => {
+                let _ = fs::remove_file(&self.map_path);
+                Ok(DownloadOutcome::Complete)
+            }
+            Outcome::Cancelled => Ok(DownloadOutcome::Cancelled),
+            Outcome::Failed(message) => Err(anyhow::anyhow!(message)),
+        }
+    }
+
+    async fn worker(&self, cancel: &AtomicBool, on_progress: &(dyn Fn(u64) + Sync)) -> Result<()> {
+        loop {
+            let claimed = {
+                let mut progress = self.shared.progress.lock().unwrap();
+                if progress.outcome.is_some() {
+                    return Ok(());
+                }
+                progress.claim_next()
+            };
+            let Some(index) = claimed else {
+                return Ok(());
+            };
+
+            let mut attempt = 1;
+            loop {
+                match self.fetch_chunk(index, cancel, on_progress).await {
+                    Ok(true) => break,
+                    Ok(false) => return Ok(()),
+                    Err(e) if attempt < CHUNK_ATTEMPTS => {
+                        warn!(
+                            "Chunk {} of {} failed (attempt {}/{}): {}",
+                            index, self.url, attempt, CHUNK_ATTEMPTS, e
+                        );
+                        self.shared.progress.lock().unwrap().filled[index] = 0;
+                        tokio::time::sleep(RETRY_BACKOFF * attempt).await;
+                        attempt += 1;
+                    }
+                    Err(e) => {
+                        // Stop the other workers; the bitmap keeps what they
+                        // finished for the next attempt.
+                        self.shared.finish(Outcome::Failed(e.to_string()));
+                        return Err(e);
+                    }
+                }
+            }
+        }
+    }
+
+    /// Returns `Ok(false)` if cancelled before the chunk completed.
+    async fn fetch_chunk(
+        &self,
+        index: usize,
+        cancel: &AtomicBool,
+        on_progress: &(dyn Fn(u64) + Sync),
+    ) -> Result<bool> {
+        let (start, end) = self.shared.progress.lock().unwrap().map.chunk_range(index);
+        let mut request = self.client.get(&self.url);
+        if self.ranged {
+            request = request.header(
+                reqwest::header::RANGE,
+                format!("bytes={}-{}", start, end - 1),
+            );
+        }
+        let response = request
+            .send()
+            .await
+            .map_err(|e| anyhow::anyhow!("Download request failed: {}", e))?;
+        let expected = if self.ranged {
+            reqwest::StatusCode::PARTIAL_CONTENT
+        } else {
+            reqwest::StatusCode::OK
+        };
+        if response.status() != expected {
+            return Err(anyhow::anyhow!(
+                "Failed to download: HTTP {}",
+                response.status()
+            ));
+        }
+
+        let mut offset = start;
+        let mut stream = response.bytes_stream();
+        while let Some(piece) = stream.next().await {
+            if cancel.load(Ordering::Acquire) {
+                return Ok(false);
+            }
+            let piece = piece.map_err(|e| anyhow::anyhow!("Download stream failed: {}", e))?;
+            if self.ranged && offset + piece.len() as u64 > end {
+                return Err(anyhow::anyhow!("Server sent more than the requested range"));
+            }
+            self.file
+                .write_all_at(&piece, offset)
+                .map_err(|e| anyhow::anyhow!("Failed to write model data: {}", e))?;
+            offset += piece.len() as u64;
+
+            let downloaded = {
+                let mut progress = self.shared.progress.lock().unwrap();
+                if progress.outcome.is_some() {
+                    // Another worker failed; stop rather than finish a chunk
+                    // nobody will read.
+                    return Ok(false);
+                }
+                progress.filled[index] = offset - start;
+                self.shared.changed.notify_all();
+                progress.downloaded()
+            };
+            on_progress(downloaded);
+        }
+
+        let mut progress = self.shared.progress.lock().unwrap();
+        if self.ranged {
+            if offset != end {
+                return Err(anyhow::anyhow!(
+                    "Chunk {} ended after {} of {} bytes",
+                    index,
+                    offset - start,
+                    end - start
+                ));
+            }
+        } else {
+            // Trust the stream over a missing or wrong Content-Length.
+            progress.map = ChunkMap::new(&self.url, offset.max(1), offset.max(1));
+            self.file.set_len(offset)?;
+        }
+        progress.map.mark_done(index);
+        if self.ranged {
+            progress.map.save(&self.map_path)?;
+        }
+        self.shared.changed.notify_all();
+        Ok(true)
+    }
+}
+
+impl Drop for RangedDownload {
+    fn drop(&mut self) {
+        // Never leave a reader waiting on a download nobody is driving.
+        self.shared.finish(Outcome::Cancelled);
+    }
+}
+
+#[cfg(test)]
+impl RangedDownload {
+    /// A download of `partial_path` whose first `done_chunks` chunks are
+    /// already on disk and that never fetches anything itself.
+    pub(crate) fn preloaded(partial_path: &Path, chunk_size: u64, done_chunks: usize) -> Self {
+        let total = partial_path.metadata().map(|m| m.len()).unwrap_or(0);
+        let mut map = ChunkMap::new("test://preloaded", total, chunk_size);
+        for index in 0..done_chunks {
+            map.mark_done(index);
+        }
+        let chunks = map.chunk_count();
+        Self {
+            client: reqwest::Client::new(),
+            url: map.url.clone(),
+            partial_path: partial_path.to_path_buf(),
+            map_path: chunk_map_path(partial_path),
+            file: Arc::new(File::open(partial_path).unwrap()),
+            shared: Arc::new(Shared {
+                progress: Mutex::new(Progress {
+                    map,
+                    filled: vec![0; chunks],
+                    claimed: vec![false; chunks],
+                    outcome: None,
+                }),
+                changed: Condvar::new(),
+            }),
+            ranged: true,
+        }
+    }
+}
+
+/// `Content-Range: bytes 0-0/12345` -> 12345.
+fn content_range_total(value: &str) -> Option<u64> {
+    value.rsplit_once('/')?.1.trim().parse().ok()
+}
+
+pub struct InOrderReader {
+    file: File,
+    pos: u64,
+    shared: Arc<Shared>,
+}
+
+impl Read for InOrderReader {
+    fn read(&mut self, buf: &mut [u8]) -> io::Result<usize> {
+        if buf.is_empty() {
+            return Ok(0);
+        }
+        let available = {
+            let mut progress = self.shared.progress.lock().unwrap();
+            loop {
+                let frontier = progress.frontier();
+                if frontier > self.pos {
+                    break frontier - self.pos;
+                }
+                match &progress.outcome {
+                    Some(Outcome::Finished) => return Ok(0),
+                    // Not `Interrupted`: `io::copy` and `read_exact` retry
+                    // that, and the reader would return it forever.
+                    Some(Outcome::Cancelled) => {
+                        return Err(io::Error::new(
+                            io::ErrorKind::ConnectionAborted,
+                            "download cancelled",
+                        ))
+                    }
+                    Some(Outcome::Failed(message)) => {
+                        return Err(io::Error::other(message.clone()))
+                    }
+                    None => progress = self.shared.changed.wait(progress).unwrap(),
+                }
+            }
+        };
+        let len = buf
+            .len()
+            .min(usize::try_from(available).unwrap_or(usize::MAX));
+        let read = self.file.read_at(&mut buf[..len], self.pos)?;
+        self.pos += read as u64;
+        Ok(read)
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn progress(map: ChunkMap) -> Progress {
+        let chunks = map.chunk_count();
+        Progress {
+            map,
+            filled: vec![0; chunks],
+            claimed: vec![false; chunks],
+            outcome: None,
+        }
+    }
+
+    #[test]
+    fn chunk_map_round_trips_and_counts_done_bytes() {
+        let dir = std::env::temp_dir().join(format!("dikt-chunks-{}", std::process::id()));
+        fs::create_dir_all(&dir).unwrap();
+        let path = chunk_map_path(&dir.join("model.bin.partial"));
+
+        let mut map = ChunkMap::new("https://example.invalid/model", 25, 10);
+        assert_eq!(map.chunk_count(), 3);
+        map.mark_done(0);
+        map.mark_done(2);
+        map.save(&path).unwrap();
+
+        let loaded = ChunkMap::load(&path).unwrap();
+        assert!(loaded.is_done(0) && !loaded.is_done(1) && loaded.is_done(2));
+        assert_eq!(loaded.done_bytes(), 15);
+        assert_eq!(resumable_bytes(&dir.join("model.bin.partial")), Some(15));
+        let _ = fs::remove_dir_all(dir);
+    }
+
+    #[test]
+    fn frontier_stops_at_first_missing_chunk() {
+        let mut state = progress(ChunkMap::new("u", 25, 10));
+        assert_eq!(state.claim_next(), Some(0));
+        assert_eq!(state.claim_next(), Some(1));
+        state.filled[1] = 10;
+        state.map.mark_done(1);
+        state.filled[0] = 4;
+        // Chunk 1 is on disk, but readers must still wait for chunk 0.
+        assert_eq!(state.frontier(), 4);
+        assert_eq!(state.downloaded(), 14);
+
+        state.map.mark_done(0);
+        assert_eq!(state.frontier(), 20);
+        assert_eq!(state.claim_next(), Some(2));
+        assert_eq!(state.claim_next(), None);
+    }
+
+    #[test]
+    fn reader_waits_for_frontier_then_reports_failure() {
+        let dir = std::env::temp_dir().join(format!("dikt-reader-{}", std::process::id()));
+        fs::create_dir_all(&dir).unwrap();
+        let path = dir.join("data.partial");
+        fs::write(&path, b"abcdefghij").unwrap();
+
+        let shared = Arc::new(Shared {
+            progress: Mutex::new(progress(ChunkMap::new("u", 10, 5))),
+            changed: Condvar::new(),
+        });
+        let mut reader = InOrderReader {
+            file: File::open(&path).unwrap(),
+            pos: 0,
+            shared: shared.clone(),
+        };
+
+        let writer = std::thread::spawn({
+            let shared = shared.clone();
+            move || {
+                std::thread::sleep(Duration::from_millis(20));
+                {
+                    let mut progress = shared.progress.lock().unwrap();
+                    progress.filled[0] = 5;
+                    progress.map.mark_done(0);
+                    shared.changed.notify_all();
+                }
+                std::thread::sleep(Duration::from_millis(20));
+                shared.finish(Outcome::Failed("connection reset".to_string()));
+            }
+        });
+
+        let mut head = [0u8; 8];
+        assert_eq!(reader.read(&mut head).unwrap(), 5);
+        assert_eq!(&head[..5], b"abcde");
+        let err = reader.read(&mut head).unwrap_err();
+        assert!(err.to_string().contains("connection reset"));
+        writer.join().unwrap();
+        let _ = fs::remove_dir_all(dir);
+    }
+
+    #[test]
+    fn parses_content_range_total() {
+        assert_eq!(
+            content_range_total("bytes 0-0/1677721600"),
+            Some(1677721600)
+        );
+        assert_eq!(content_range_total("bytes 0-0/*"), None);
+    }
+}
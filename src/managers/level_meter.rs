@@ -0,0 +1,170 @@
+//! Demand-driven microphone level metering.
+//!
+//! Spectrum analysis only runs while at least one client holds a lease. A
+//! lease asks for an update rate and lapses unless renewed, so a UI that
+//! disappears without releasing it does not keep the analysis running.
+
+use std::collections::HashMap;
+use std::sync::atomic::{AtomicU32, Ordering};
+use std::sync::{Arc, Mutex};
+use std::time::{Duration, Instant};
+
+/// Clients renew well within this; a lapsed lease stops its updates.
+pub const LEVEL_LEASE_TTL: Duration = Duration::from_secs(5);
+const MAX_RATE_HZ: u32 = 60;
+
+type LevelSink = Box<dyn Fn(&[f32]) + Send + Sync>;
+
+struct Lease {
+    rate_hz: u32,
+    expires_at: Instant,
+}
+
+#[derive(Default)]
+struct LeaseTable {
+    next_id: u64,
+    leases: HashMap<u64, Lease>,
+}
+
+pub struct LevelMeter {
+    /// Fastest rate any live lease asked for; 0 turns analysis off.
+    rate_hz: Arc<AtomicU32>,
+    leases: Mutex<LeaseTable>,
+    sink: Mutex<Option<LevelSink>>,
+}
+
+impl Default for LevelMeter {
+    fn default() -> Self {
+        Self::new()
+    }
+}
+
+impl LevelMeter {
+    pub fn new() -> Self {
+        Self {
+            rate_hz: Arc::new(AtomicU32::new(0)),
+            leases: Mutex::new(LeaseTable::default()),
+            sink: Mutex::new(None),
+        }
+    }
+
+    /// Shared with the capture consumer, which skips analysis while it is 0.
+    pub fn rate_handle(&self) -> Arc<AtomicU32> {
+        self.rate_hz.clone()
+    }
+
+    pub fn set_sink(&self, sink: LevelSink) {
+        *self.sink.lock().unwrap() = Some(sink);
+    }
+
+    pub fn subscribe(&self, rate_hz: u32) -> u64 {
+        let mut table = self.leases.lock().unwrap();
+        let now = Instant::now();
+        table.next_id += 1;
+        let lease_id = table.next_id;
+        table.leases.insert(
+            lease_id,
+            Lease {
+                rate_hz: rate_hz.clamp(1, MAX_RATE_HZ),
+                expires_at: now + LEVEL_LEASE_TTL,
+            },
+        );
+        self.refresh(&mut table, now);
+        lease_id
+    }
+
+    pub fn renew(&self, lease_id: u64) -> bool {
+        let mut table = self.leases.lock().unwrap();
+        let now = Instant::now();
+        self.refresh(&mut table, now);
+        match table.leases.get_mut(&lease_id) {
+            Some(lease) => {
+                lease.expires_at = now + LEVEL_LEASE_TTL;
+                true
+            }
+            None => false,
+        }
+    }
+
+    pub fn release(&self, lease_id: u64) -> bool {
+        let mut table = self.leases.lock().unwrap();
+        let released = table.leases.remove(&lease_id).is_some();
+        self.refresh(&mut table, Instant::now());
+        released
+    }
+
+    /// Called by the capture consumer with each new set of levels.
+    pub fn publish(&self, levels: &[f32]) {
+        {
+            let mut table = self.leases.lock().unwrap();
+            if self.refresh(&mut table, Instant::now()) == 0 {
+                return;
+            }
+        }
+        if let Some(sink) = self.sink.lock().unwrap().as_ref() {
+            sink(levels);
+        }
+    }
+
+    /// Drops lapsed leases and republishes the fastest remaining rate.
+    fn refresh(&self, table: &mut LeaseTable, now: Instant) -> u32 {
+        table.leases.retain(|_, lease| lease.expires_at > now);
+        let rate_hz = table
+            .leases
+            .values()
+            .map(|lease| lease.rate_hz)
+            .max()
+            .unwrap_or(0);
+        self.rate_hz.store(rate_hz, Ordering::Relaxed);
+        rate_hz
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn rate_follows_fastest_live_lease() {
+        let meter = LevelMeter::new();
+        let rate = meter.rate_handle();
+        assert_eq!(rate.load(Ordering::Relaxed), 0);
+
+        let slow = meter.subscribe(10);
+        let fast = meter.subscribe(500);
+        assert_eq!(rate.load(Ordering::Relaxed), MAX_RATE_HZ);
+
+        assert!(meter.release(fast));
+        assert!(!meter.release(fast));
+        assert_eq!(rate.load(Ordering::Relaxed), 10);
+
+        // Force the remaining lease to lapse.
+        meter
+            .leases
+            .lock()
+            .unwrap()
+            .leases
+            .get_mut(&slow)
+            .unwrap()
+            .expires_at = Instant::now();
+        assert!(!meter.renew(slow));
+        assert_eq!(rate.load(Ordering::Relaxed), 0);
+    }
+
+    #[test]
+    fn publish_reaches_sink_only_while_leased() {
+        let meter = LevelMeter::new();
+        let seen = Arc::new(Mutex::new(Vec::new()));
+        meter.set_sink({
+            let seen = seen.clone();
+            Box::new(move |levels| seen.lock().unwrap().push(levels.to_vec()))
+        });
+
+        meter.publish(&[0.1]);
+        let lease = meter.subscribe(30);
+        meter.publish(&[0.2]);
+        meter.release(lease);
+        meter.publish(&[0.3]);
+        assert_eq!(*seen.lock().unwrap(), vec![vec![0.2]]);
+    }
+}
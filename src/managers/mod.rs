@@ -1,3 +1,6 @@
 pub mod audio;
+mod download;
+pub mod level_meter;
 pub mod model;
+pub mod segmented;
 pub mod transcription;
@@ -1,14 +1,13 @@
+use crate::managers::download::{self, DownloadOutcome, RangedDownload};
 use anyhow::Result;
 use flate2::read::GzDecoder;
-use futures_util::StreamExt;
 use log::{info, warn};
 use serde::{Deserialize, Serialize};
 use std::collections::{HashMap, HashSet};
 use std::fs;
-use std::fs::File;
-use std::io::Write;
+use std::io::{self, Read};
 use std::path::{Path, PathBuf};
-use std::sync::atomic::{AtomicBool, Ordering};
+use std::sync::atomic::{AtomicBool, AtomicU64, Ordering};
 use std::sync::{Arc, Mutex};
 use tar::Archive;
 
@@ -37,10 +36,62 @@ pub struct ModelInfo {
     pub speed_score: f32,
     pub supports_translation: bool,
     pub is_recommended: bool,
+    /// Decode time over audio duration measured on this machine, if the
+    /// model has been used for long enough clips.
+    pub measured_rtf: Option<f32>,
     pub supported_languages: Vec<String>,
     pub is_custom: bool,
 }
 
+/// Decode speeds measured on this machine, kept in the models directory so the
+/// UI process sees what the daemon measured.
+const DECODE_SPEED_FILE: &str = "decode-speed.json";
+/// Clips shorter than this are dominated by fixed per-decode cost.
+const MIN_MEASURED_AUDIO_SECS: f32 = 2.0;
+/// Weight of a new measurement in the running average.
+const DECODE_SPEED_SMOOTHING: f32 = 0.2;
+/// Slowest real-time factor that still keeps up with live dictation.
+const RECOMMENDED_MAX_RTF: f32 = 0.5;
+/// Relative change in a measured speed worth rewriting the file for.
+const DECODE_SPEED_SAVE_TOLERANCE: f32 = 0.05;
+
+#[derive(Debug, Clone, Copy, Serialize, Deserialize)]
+struct DecodeSpeed {
+    rtf: f32,
+    decodes: u32,
+}
+
+impl DecodeSpeed {
+    fn record(previous: Option<Self>, rtf: f32) -> Self {
+        match previous {
+            Some(prev) => Self {
+                rtf: prev.rtf + (rtf - prev.rtf) * DECODE_SPEED_SMOOTHING,
+                decodes: prev.decodes.saturating_add(1),
+            },
+            None => Self { rtf, decodes: 1 },
+        }
+    }
+}
+
+/// The most accurate downloaded model measured fast enough for live
+/// dictation, or the catalog's pick until anything has been measured.
+fn recommended_model<'a>(
+    mut models: impl Iterator<Item = &'a ModelInfo> + Clone,
+) -> Option<&'a ModelInfo> {
+    let fast_enough = |m: &&ModelInfo| {
+        m.is_downloaded && m.measured_rtf.is_some_and(|rtf| rtf <= RECOMMENDED_MAX_RTF)
+    };
+    models
+        .clone()
+        .filter(fast_enough)
+        .max_by(|a, b| {
+            a.accuracy_score
+                .total_cmp(&b.accuracy_score)
+                .then_with(|| b.measured_rtf.unwrap().total_cmp(&a.measured_rtf.unwrap()))
+        })
+        .or_else(|| models.find(|m| m.is_recommended))
+}
+
 #[derive(Debug, Clone, Serialize, Deserialize)]
 pub struct DownloadProgress {
     pub model_id: String,
@@ -130,6 +181,9 @@ pub struct ModelManager {
     cancel_flags: Arc<Mutex<HashMap<String, Arc<AtomicBool>>>>,
     extracting_models: Arc<Mutex<HashSet<String>>>,
     state_observers: Arc<Mutex<Vec<std::sync::mpsc::Sender<ModelStateEvent>>>>,
+    decode_speeds: Mutex<HashMap<String, DecodeSpeed>>,
+    /// Real-time factors as last written to (or read from) disk.
+    saved_decode_speeds: Mutex<HashMap<String, f32>>,
 }
 
 struct DownloadInFlightGuard<'a> {
@@ -213,6 +267,7 @@ impl ModelManager {
                 speed_score: 0.85,
                 supports_translation: true,
                 is_recommended: false,
+                measured_rtf: None,
                 supported_languages: whisper_languages.clone(),
                 is_custom: false,
             },
@@ -236,6 +291,7 @@ impl ModelManager {
                 speed_score: 0.60,
                 supports_translation: true,
                 is_recommended: false,
+                measured_rtf: None,
                 supported_languages: whisper_languages.clone(),
                 is_custom: false,
             },
@@ -259,6 +315,7 @@ impl ModelManager {
                 speed_score: 0.40,
                 supports_translation: false,
                 is_recommended: false,
+                measured_rtf: None,
                 supported_languages: whisper_languages.clone(),
                 is_custom: false,
             },
@@ -290,6 +347,7 @@ impl ModelManager {
                 speed_score: 0.85,
                 supports_translation: false,
                 is_recommended: true,
+                measured_rtf: None,
                 supported_languages: parakeet_v3_languages,
                 is_custom: false,
             },
@@ -320,6 +378,7 @@ impl ModelManager {
                 speed_score: 0.95,
                 supports_translation: false,
                 is_recommended: false,
+                measured_rtf: None,
                 supported_languages: sense_voice_languages,
                 is_custom: false,
             },
@@ -337,8 +396,11 @@ impl ModelManager {
             cancel_flags: Arc::new(Mutex::new(HashMap::new())),
             extracting_models: Arc::new(Mutex::new(HashSet::new())),
             state_observers: Arc::new(Mutex::new(Vec::new())),
+            decode_speeds: Mutex::new(HashMap::new()),
+            saved_decode_speeds: Mutex::new(HashMap::new()),
         };
 
+        manager.load_decode_speeds();
         manager.update_download_status()?;
         manager.auto_select_model_if_needed()?;
 
@@ -362,6 +424,83 @@ impl ModelManager {
             .map(|m| self.models_dir.join(&m.filename))
     }
 
+    /// Id of the model to suggest; see [`recommended_model`].
+    pub fn recommended_model_id(&self) -> Option<String> {
+        let models = self.available_models.lock().unwrap();
+        recommended_model(models.values()).map(|m| m.id.clone())
+    }
+
+    /// Folds one decode of `audio_secs` of audio that took `decode_secs` into
+    /// the model's measured speed. Call [`Self::save_decode_speeds`] to
+    /// persist it.
+    pub fn record_decode_speed(&self, model_id: &str, audio_secs: f32, decode_secs: f32) {
+        if audio_secs < MIN_MEASURED_AUDIO_SECS || !decode_secs.is_finite() {
+            return;
+        }
+        let mut speeds = self.decode_speeds.lock().unwrap();
+        let speed = DecodeSpeed::record(speeds.get(model_id).copied(), decode_secs / audio_secs);
+        speeds.insert(model_id.to_string(), speed);
+        drop(speeds);
+        if let Some(model) = self.available_models.lock().unwrap().get_mut(model_id) {
+            model.measured_rtf = Some(speed.rtf);
+        }
+    }
+
+    /// Writes the measured speeds, unless none moved by more than
+    /// [`DECODE_SPEED_SAVE_TOLERANCE`] since the last write.
+    pub fn save_decode_speeds(&self) {
+        let speeds = self.decode_speeds.lock().unwrap();
+        let mut saved = self.saved_decode_speeds.lock().unwrap();
+        let changed = speeds.iter().any(|(id, speed)| {
+            saved.get(id).is_none_or(|&saved_rtf| {
+                (speed.rtf - saved_rtf).abs() > saved_rtf * DECODE_SPEED_SAVE_TOLERANCE
+            })
+        });
+        if !changed {
+            return;
+        }
+        let json = match serde_json::to_vec_pretty(&*speeds) {
+            Ok(json) => json,
+            Err(e) => {
+                warn!("Failed to serialize decode speeds: {}", e);
+                return;
+            }
+        };
+        let path = self.models_dir.join(DECODE_SPEED_FILE);
+        let tmp_path = self.models_dir.join(format!("{}.tmp", DECODE_SPEED_FILE));
+        if let Err(e) = fs::write(&tmp_path, json).and_then(|()| fs::rename(&tmp_path, &path)) {
+            warn!("Failed to save decode speeds to {}: {}", path.display(), e);
+            return;
+        }
+        *saved = speeds
+            .iter()
+            .map(|(id, speed)| (id.clone(), speed.rtf))
+            .collect();
+    }
+
+    fn load_decode_speeds(&self) {
+        let path = self.models_dir.join(DECODE_SPEED_FILE);
+        let speeds: HashMap<String, DecodeSpeed> = match fs::read(&path) {
+            Ok(json) => match serde_json::from_slice(&json) {
+                Ok(speeds) => speeds,
+                Err(e) => {
+                    warn!("Ignoring unreadable {}: {}", path.display(), e);
+                    return;
+                }
+            },
+            Err(_) => return,
+        };
+        let mut models = self.available_models.lock().unwrap();
+        for model in models.values_mut() {
+            model.measured_rtf = speeds.get(&model.id).map(|speed| speed.rtf);
+        }
+        *self.saved_decode_speeds.lock().unwrap() = speeds
+            .iter()
+            .map(|(id, speed)| (id.clone(), speed.rtf))
+            .collect();
+        *self.decode_speeds.lock().unwrap() = speeds;
+    }
+
     fn is_valid_directory_model_layout(model_info: &ModelInfo, model_path: &Path) -> bool {
         if !model_path.is_dir() {
             return false;
@@ -517,11 +656,7 @@ impl ModelManager {
                     };
                 model.is_downloading = false;
 
-                if partial_path.exists() {
-                    model.partial_size = partial_path.metadata().map(|m| m.len()).unwrap_or(0);
-                } else {
-                    model.partial_size = 0;
-                }
+                model.partial_size = Self::partial_download_size(&partial_path);
             } else {
                 let model_path = self.models_dir.join(&model.filename);
                 let partial_path = self.models_dir.join(format!("{}.partial", &model.filename));
@@ -529,20 +664,26 @@ impl ModelManager {
                 model.is_downloaded = model_path.exists();
                 model.is_downloading = false;
 
-                if partial_path.exists() {
-                    model.partial_size = partial_path.metadata().map(|m| m.len()).unwrap_or(0);
-                } else {
-                    model.partial_size = 0;
-                }
+                model.partial_size = Self::partial_download_size(&partial_path);
             }
         }
 
         Ok(())
     }
 
+    fn partial_download_size(partial_path: &Path) -> u64 {
+        if !partial_path.exists() {
+            return 0;
+        }
+        download::resumable_bytes(partial_path)
+            .unwrap_or_else(|| partial_path.metadata().map(|m| m.len()).unwrap_or(0))
+    }
+
     /// Public method to refresh download status from filesystem.
     /// This is useful when the daemon needs to detect models downloaded by other processes.
     pub fn refresh_download_status(&self) -> Result<()> {
+        // The daemon may have measured new speeds since this process started.
+        self.load_decode_speeds();
         self.update_download_status()
     }
 
@@ -577,9 +718,8 @@ impl ModelManager {
             );
         }
 
-        let fallback = models
-            .values()
-            .find(|m| m.is_downloaded && m.is_recommended)
+        let fallback = recommended_model(models.values())
+            .filter(|m| m.is_downloaded)
             .or_else(|| models.values().find(|m| m.is_downloaded))
             .map(|m| m.id.clone());
         drop(models);
@@ -673,6 +813,7 @@ impl ModelManager {
                     speed_score: 0.0,
                     supports_translation: false,
                     is_recommended: false,
+                    measured_rtf: None,
                     supported_languages: vec![],
                     is_custom: true,
                 },
@@ -708,6 +849,7 @@ impl ModelManager {
                         if partial_path.exists() {
                             let _ = fs::remove_file(&partial_path);
                         }
+                        let _ = fs::remove_file(download::chunk_map_path(&partial_path));
                         self.update_download_status()?;
                         return Ok(());
                     }
@@ -740,20 +882,17 @@ impl ModelManager {
                 if partial_path.exists() {
                     let _ = fs::remove_file(&partial_path);
                 }
+                let _ = fs::remove_file(download::chunk_map_path(&partial_path));
                 self.update_download_status()?;
                 return Ok(());
             }
         }
 
-        let mut resume_from = if partial_path.exists() {
-            partial_path.metadata()?.len()
-        } else {
-            0
-        };
+        let resume_from = download::resumable_bytes(&partial_path).unwrap_or(0);
 
         // Set downloading state and notify
         let cancel_flag = Arc::new(AtomicBool::new(false));
-        let total_bytes = model_info.size_mb * 1024 * 1024;
+        let mut total_bytes = model_info.size_mb * 1024 * 1024;
 
         {
             let mut models = self.available_models.lock().unwrap();
@@ -799,165 +938,91 @@ impl ModelManager {
         );
 
         let client = reqwest::Client::new();
-        let mut request = client.get(&url);
-
-        if resume_from > 0 {
-            request = request.header("Range", format!("bytes={}-", resume_from));
-        }
-
-        let mut response = request.send().await.map_err(|e| {
-            self.notify_state_change(
-                model_id,
-                ModelState::Error {
-                    message: format!("Download request failed: {}", e),
-                    retryable: true,
-                },
-            );
-            anyhow::anyhow!("Download request failed: {}", e)
-        })?;
-
-        if resume_from > 0 && response.status() == reqwest::StatusCode::OK {
-            drop(response);
-            let _ = fs::remove_file(&partial_path);
-            resume_from = 0;
-            response = client.get(&url).send().await.map_err(|e| {
+        let download = RangedDownload::open(&client, &url, &partial_path)
+            .await
+            .map_err(|e| {
                 self.notify_state_change(
                     model_id,
                     ModelState::Error {
-                        message: format!("Download request failed: {}", e),
+                        message: e.to_string(),
                         retryable: true,
                     },
                 );
-                anyhow::anyhow!("Download request failed: {}", e)
+                e
             })?;
+        if download.total() > 1 {
+            total_bytes = download.total();
         }
 
-        if !response.status().is_success()
-            && response.status() != reqwest::StatusCode::PARTIAL_CONTENT
-        {
-            self.notify_state_change(
-                model_id,
-                ModelState::Error {
-                    message: format!("HTTP {}", response.status()),
-                    retryable: true,
-                },
-            );
-
-            return Err(anyhow::anyhow!(
-                "Failed to download: HTTP {}",
-                response.status()
-            ));
-        }
-
-        let _total_size = if resume_from > 0 {
-            resume_from + response.content_length().unwrap_or(0)
-        } else {
-            response.content_length().unwrap_or(0)
-        };
-
-        let mut _downloaded = resume_from;
-        let mut stream = response.bytes_stream();
-        let mut last_notify_bytes = resume_from;
-
-        let mut file = if resume_from > 0 {
-            std::fs::OpenOptions::new()
-                .create(true)
-                .append(true)
-                .open(&partial_path)
-                .map_err(|e| {
-                    self.notify_state_change(
-                        model_id,
-                        ModelState::Error {
-                            message: format!("Failed to open partial file: {}", e),
-                            retryable: true,
-                        },
-                    );
-                    anyhow::anyhow!("Failed to open partial file: {}", e)
-                })?
+        // Archives are unpacked while they download, reading each byte once
+        // the contiguous prefix reaches it.
+        let extracting_dir = self
+            .models_dir
+            .join(format!("{}.tar.extracting", &model_info.filename));
+        let extraction = if model_info.is_directory {
+            let reader = download.reader()?;
+            let extracting_dir = extracting_dir.clone();
+            Some(tokio::task::spawn_blocking(move || {
+                Self::unpack_archive(reader, &extracting_dir)
+            }))
         } else {
-            std::fs::File::create(&partial_path).map_err(|e| {
-                self.notify_state_change(
-                    model_id,
-                    ModelState::Error {
-                        message: format!("Failed to create partial file: {}", e),
-                        retryable: true,
-                    },
-                );
-                anyhow::anyhow!("Failed to create partial file: {}", e)
-            })?
+            None
         };
 
-        while let Some(chunk) = stream.next().await {
-            if cancel_flag.load(Ordering::Acquire) {
-                drop(file);
-
-                // Notify cancellation
-                self.notify_state_change(model_id, ModelState::Available);
-
-                return Ok(());
-            }
-
-            let chunk = chunk.map_err(|e| {
-                self.notify_state_change(
-                    model_id,
-                    ModelState::Error {
-                        message: format!("Download stream failed: {}", e),
-                        retryable: true,
-                    },
-                );
-                anyhow::anyhow!("Download stream failed: {}", e)
-            })?;
-            file.write_all(&chunk).map_err(|e| {
-                self.notify_state_change(
-                    model_id,
-                    ModelState::Error {
-                        message: format!("Failed to write model data: {}", e),
-                        retryable: true,
-                    },
-                );
-                anyhow::anyhow!("Failed to write model data: {}", e)
-            })?;
-            _downloaded += chunk.len() as u64;
-
+        let last_notify_bytes = AtomicU64::new(download.downloaded());
+        let on_progress = |downloaded: u64| {
             // Update progress in model info
             if let Ok(mut models) = self.available_models.lock() {
                 if let Some(model) = models.get_mut(model_id) {
-                    model.partial_size = _downloaded;
+                    model.partial_size = downloaded;
                 }
             }
 
             // Notify progress every 1MB to avoid spamming
-            if _downloaded - last_notify_bytes >= 1024 * 1024 {
+            let last = last_notify_bytes.load(Ordering::Relaxed);
+            if downloaded.saturating_sub(last) >= 1024 * 1024 {
+                last_notify_bytes.store(downloaded, Ordering::Relaxed);
                 self.notify_state_change(
                     model_id,
                     ModelState::Downloading {
-                        bytes_downloaded: _downloaded,
+                        bytes_downloaded: downloaded,
                         bytes_total: total_bytes,
                         cancel_flag: cancel_flag.clone(),
                     },
                 );
-                last_notify_bytes = _downloaded;
             }
-        }
+        };
+
+        let outcome = download.run(&cancel_flag, &on_progress).await;
+        drop(download);
+        let extraction = match outcome {
+            Ok(DownloadOutcome::Complete) => extraction,
+            stopped => {
+                if let Some(extraction) = extraction {
+                    // The reader fails once the download stops; wait for it
+                    // so the half-unpacked tree can be removed.
+                    let _ = extraction.await;
+                    let _ = fs::remove_dir_all(&extracting_dir);
+                }
+                if let Err(e) = stopped {
+                    self.notify_state_change(
+                        model_id,
+                        ModelState::Error {
+                            message: e.to_string(),
+                            retryable: true,
+                        },
+                    );
+                    return Err(e);
+                }
 
-        drop(file);
+                // Notify cancellation
+                self.notify_state_change(model_id, ModelState::Available);
 
-        if model_info.is_directory {
-            // For directory-based models, rename to .tar.gz for extraction
-            let tar_path = self
-                .models_dir
-                .join(format!("{}.tar.gz", &model_info.filename));
-            fs::rename(&partial_path, &tar_path).map_err(|e| {
-                self.notify_state_change(
-                    model_id,
-                    ModelState::Error {
-                        message: format!("Failed to prepare archive for extraction: {}", e),
-                        retryable: true,
-                    },
-                );
-                anyhow::anyhow!("Failed to prepare archive for extraction: {}", e)
-            })?;
+                return Ok(());
+            }
+        };
 
+        if let Some(extraction) = extraction {
             // Notify extraction state
             self.notify_state_change(
                 model_id,
@@ -966,7 +1031,14 @@ impl ModelManager {
                 },
             );
 
-            if let Err(e) = self.extract_model(model_id, &tar_path, &model_path).await {
+            if let Err(e) = self
+                .extract_model(model_id, extraction, &extracting_dir, &model_path)
+                .await
+            {
+                // The archive on disk is complete but unusable, so a retry
+                // has to fetch it again rather than resume.
+                let _ = fs::remove_dir_all(&extracting_dir);
+                let _ = fs::remove_file(&partial_path);
                 self.notify_state_change(
                     model_id,
                     ModelState::Error {
@@ -977,6 +1049,7 @@ impl ModelManager {
 
                 return Err(e);
             }
+            fs::remove_file(&partial_path)?;
         } else {
             // For single-file models, just rename the partial file
             fs::rename(&partial_path, &model_path).map_err(|e| {
@@ -1015,13 +1088,23 @@ impl ModelManager {
         Ok(())
     }
 
-    async fn extract_model(&self, model_id: &str, tar_path: &Path, final_dir: &Path) -> Result<()> {
+    async fn extract_model(
+        &self,
+        model_id: &str,
+        extraction: tokio::task::JoinHandle<Result<()>>,
+        extracting_dir: &Path,
+        final_dir: &Path,
+    ) -> Result<()> {
         {
             let mut extracting = self.extracting_models.lock().unwrap();
             extracting.insert(model_id.to_string());
         }
 
-        let result = self.do_extract(tar_path, final_dir).await;
+        let result = match extraction.await {
+            Ok(Ok(())) => Self::install_extracted(extracting_dir, final_dir),
+            Ok(Err(e)) => Err(e),
+            Err(e) => Err(anyhow::anyhow!("Extraction task failed: {}", e)),
+        };
 
         {
             let mut extracting = self.extracting_models.lock().unwrap();
@@ -1031,19 +1114,21 @@ impl ModelManager {
         result
     }
 
-    async fn do_extract(&self, tar_path: &Path, final_dir: &Path) -> Result<()> {
-        let file = File::open(tar_path)?;
-        let decoder = GzDecoder::new(&file);
-        let mut archive = Archive::new(decoder);
-
-        let extracting_dir = tar_path.with_extension("extracting");
+    fn unpack_archive(reader: impl Read, extracting_dir: &Path) -> Result<()> {
         if extracting_dir.exists() {
-            fs::remove_dir_all(&extracting_dir)?;
+            fs::remove_dir_all(extracting_dir)?;
         }
-        fs::create_dir_all(&extracting_dir)?;
+        fs::create_dir_all(extracting_dir)?;
 
-        archive.unpack(&extracting_dir)?;
+        let mut archive = Archive::new(GzDecoder::new(reader));
+        archive.unpack(extracting_dir)?;
+        // Tar stops at its end-of-archive marker; reading on to the gzip
+        // trailer is what checks the CRC-32 of everything unpacked.
+        io::copy(&mut archive.into_inner(), &mut io::sink())?;
+        Ok(())
+    }
 
+    fn install_extracted(extracting_dir: &Path, final_dir: &Path) -> Result<()> {
         if final_dir.exists() {
             if final_dir.is_dir() {
                 fs::remove_dir_all(final_dir)?;
@@ -1052,16 +1137,15 @@ impl ModelManager {
             }
         }
 
-        let extracted_root = Self::extract_root_dir(&extracting_dir)?;
+        let extracted_root = Self::extract_root_dir(extracting_dir)?;
         if extracted_root == extracting_dir {
-            fs::rename(&extracting_dir, final_dir)?;
+            fs::rename(extracting_dir, final_dir)?;
         } else {
             fs::rename(&extracted_root, final_dir)?;
             if extracting_dir.exists() {
-                fs::remove_dir_all(&extracting_dir)?;
+                fs::remove_dir_all(extracting_dir)?;
             }
         }
-        fs::remove_file(tar_path)?;
 
         Ok(())
     }
@@ -1173,6 +1257,10 @@ impl ModelManager {
             if partial_path.exists() {
                 fs::remove_file(&partial_path)?;
             }
+            let chunk_map_path = download::chunk_map_path(&partial_path);
+            if chunk_map_path.exists() {
+                fs::remove_file(&chunk_map_path)?;
+            }
 
             self.update_download_status()?;
 
@@ -1216,7 +1304,7 @@ impl ModelManager {
         // by other processes (e.g., UI downloaded while daemon was running)
         self.update_download_status()?;
 
-        let selected = crate::settings::Settings::new().selected_model();
+        let selected = crate::settings::settings_snapshot().selected_model.clone();
         info!("Syncing model selection from settings: '{}'", selected);
 
         let models = self.available_models.lock().unwrap();
@@ -1266,7 +1354,7 @@ mod tests {
     use super::*;
     use std::fs::{self, File};
     use std::sync::atomic::{AtomicBool, Ordering};
-    use std::time::{SystemTime, UNIX_EPOCH};
+    use std::time::{Duration, SystemTime, UNIX_EPOCH};
 
     fn create_test_dir(prefix: &str) -> PathBuf {
         let ts = SystemTime::now()
@@ -1295,6 +1383,7 @@ mod tests {
             speed_score: 0.0,
             supports_translation: false,
             is_recommended: false,
+            measured_rtf: None,
             supported_languages: vec![],
             is_custom: false,
         }
@@ -1308,6 +1397,8 @@ mod tests {
             cancel_flags: Arc::new(Mutex::new(HashMap::new())),
             extracting_models: Arc::new(Mutex::new(HashSet::new())),
             state_observers: Arc::new(Mutex::new(Vec::new())),
+            decode_speeds: Mutex::new(HashMap::new()),
+            saved_decode_speeds: Mutex::new(HashMap::new()),
         }
     }
 
@@ -1471,6 +1562,75 @@ mod tests {
         let _ = fs::remove_dir_all(root);
     }
 
+    fn model_archive() -> Vec<u8> {
+        let mut builder = tar::Builder::new(flate2::write::GzEncoder::new(
+            Vec::new(),
+            flate2::Compression::fast(),
+        ));
+        let data = b"vocab";
+        let mut header = tar::Header::new_gnu();
+        header.set_size(data.len() as u64);
+        header.set_mode(0o644);
+        header.set_cksum();
+        builder
+            .append_data(&mut header, "model/vocab.txt", &data[..])
+            .unwrap();
+        builder.into_inner().unwrap().finish().unwrap()
+    }
+
+    #[test]
+    fn test_unpack_archive_verifies_gzip_trailer() {
+        let root = create_test_dir("unpack-archive");
+        let archive = model_archive();
+
+        let good = root.join("good");
+        ModelManager::unpack_archive(archive.as_slice(), &good).unwrap();
+        assert_eq!(
+            fs::read(good.join("model").join("vocab.txt")).unwrap(),
+            b"vocab"
+        );
+
+        // Flip a bit of the CRC-32 in the trailer.
+        let mut corrupt = archive.clone();
+        let crc_at = corrupt.len() - 8;
+        corrupt[crc_at] ^= 1;
+        assert!(ModelManager::unpack_archive(corrupt.as_slice(), &root.join("bad")).is_err());
+
+        let _ = fs::remove_dir_all(root);
+    }
+
+    #[test]
+    fn test_unpack_archive_stops_when_download_is_cancelled() {
+        let root = create_test_dir("unpack-cancelled");
+        let archive = model_archive();
+        let partial_path = root.join("model.tar.gz.partial");
+        fs::write(&partial_path, &archive).unwrap();
+        // All but the end of the gzip trailer has arrived, so the unpack
+        // blocks in the trailer drain, which retries `Interrupted` reads.
+        let download = RangedDownload::preloaded(&partial_path, archive.len() as u64 - 4, 1);
+        let reader = download.reader().unwrap();
+        let extracting_dir = root.join("extracting");
+
+        let runtime = tokio::runtime::Builder::new_current_thread()
+            .enable_time()
+            .build()
+            .unwrap();
+        let result = runtime.block_on(async {
+            let extraction = tokio::task::spawn_blocking(move || {
+                ModelManager::unpack_archive(reader, &extracting_dir)
+            });
+            tokio::time::sleep(Duration::from_millis(50)).await;
+            drop(download);
+            tokio::time::timeout(Duration::from_secs(5), extraction).await
+        });
+        // Do not wait on a blocking task that is still spinning.
+        runtime.shutdown_background();
+        let unpacked = result.expect("extraction did not finish after cancel");
+        assert!(unpacked.unwrap().is_err());
+
+        let _ = fs::remove_dir_all(root);
+    }
+
     #[test]
     fn test_partial_file_does_not_mark_model_as_downloaded() {
         let models_dir = create_test_dir("partial-not-downloaded");
@@ -1492,6 +1652,7 @@ mod tests {
             speed_score: 0.0,
             supports_translation: false,
             is_recommended: false,
+            measured_rtf: None,
             supported_languages: vec![],
             is_custom: false,
         };
@@ -1512,4 +1673,76 @@ mod tests {
 
         let _ = fs::remove_dir_all(models_dir);
     }
+
+    #[test]
+    fn test_recommendation_follows_measured_speed() {
+        let model = |id: &str, accuracy: f32, rtf: Option<f32>, catalog: bool| ModelInfo {
+            is_downloaded: true,
+            accuracy_score: accuracy,
+            measured_rtf: rtf,
+            is_recommended: catalog,
+            ..directory_model_info(id, id, EngineType::Whisper)
+        };
+        let mut models = vec![
+            model("catalog", 0.8, None, true),
+            model("accurate-slow", 0.9, Some(1.4), false),
+            model("fast", 0.6, Some(0.1), false),
+        ];
+        assert_eq!(recommended_model(models.iter()).unwrap().id, "fast");
+
+        models[1].measured_rtf = Some(0.4);
+        assert_eq!(
+            recommended_model(models.iter()).unwrap().id,
+            "accurate-slow"
+        );
+
+        for m in &mut models {
+            m.measured_rtf = None;
+        }
+        assert_eq!(recommended_model(models.iter()).unwrap().id, "catalog");
+    }
+
+    #[test]
+    fn test_decode_speeds_persist_across_managers() {
+        let models_dir = create_test_dir("decode-speed");
+        let new_manager = || {
+            let manager = test_manager(models_dir.clone());
+            manager.available_models.lock().unwrap().insert(
+                "small".to_string(),
+                directory_model_info("small", "small", EngineType::Whisper),
+            );
+            manager
+        };
+
+        let manager = new_manager();
+        manager.record_decode_speed("small", 1.0, 5.0);
+        assert_eq!(manager.get_model_info("small").unwrap().measured_rtf, None);
+        manager.record_decode_speed("small", 10.0, 2.0);
+        manager.record_decode_speed("small", 10.0, 7.0);
+        let rtf = manager
+            .get_model_info("small")
+            .unwrap()
+            .measured_rtf
+            .unwrap();
+        assert!((rtf - 0.3).abs() < 1e-6);
+        manager.save_decode_speeds();
+        let path = models_dir.join(DECODE_SPEED_FILE);
+        let written = fs::read(&path).unwrap();
+
+        // A small drift is not worth rewriting the file for.
+        manager.record_decode_speed("small", 10.0, 3.5);
+        manager.save_decode_speeds();
+        assert_eq!(fs::read(&path).unwrap(), written);
+
+        let reloaded = new_manager();
+        reloaded.load_decode_speeds();
+        assert_eq!(
+            reloaded.get_model_info("small").unwrap().measured_rtf,
+            Some(rtf)
+        );
+        reloaded.save_decode_speeds();
+        assert_eq!(fs::read(&path).unwrap(), written);
+
+        let _ = fs::remove_dir_all(models_dir);
+    }
 }
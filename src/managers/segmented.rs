@@ -0,0 +1,145 @@
+//! Segmented transcription of long recordings.
+//!
+//! While a session is recording, a worker decodes the audio up to each VAD
+//! silence boundary once enough speech has accumulated. On stop only the audio
+//! after the last decoded boundary is left, so time-to-text after releasing the
+//! shortcut is bounded by the final segment instead of the whole dictation.
+
+use crate::audio_toolkit::SampleView;
+use crate::managers::audio::AudioRecordingManager;
+use crate::managers::transcription::{join_transcript, TranscriptionManager};
+use anyhow::Result;
+use log::{debug, warn};
+use std::sync::atomic::{AtomicBool, Ordering};
+use std::sync::{Arc, Mutex};
+use std::thread;
+use std::time::Duration;
+
+const SEGMENT_POLL_MS: u64 = 400;
+/// Shorter segments lose too much context for the decoder to stay accurate.
+const MIN_SEGMENT_SAMPLES: usize = 16000 * 8;
+/// Stay below Whisper's 30 s window so a segment is decoded in one pass.
+const MAX_SEGMENT_SAMPLES: usize = 16000 * 28;
+/// Tails shorter than this are padded the same way short recordings are.
+const MIN_TAIL_SAMPLES: usize = 16000;
+
+#[derive(Default)]
+struct Progress {
+    /// Offset into the recording up to which `texts` covers the audio.
+    decoded_samples: usize,
+    texts: Vec<String>,
+}
+
+pub struct SegmentedTranscription {
+    transcription_manager: Arc<TranscriptionManager>,
+    stop: Arc<AtomicBool>,
+    progress: Arc<Mutex<Progress>>,
+    handle: Option<thread::JoinHandle<()>>,
+}
+
+impl SegmentedTranscription {
+    pub fn spawn(
+        recording_manager: Arc<AudioRecordingManager>,
+        transcription_manager: Arc<TranscriptionManager>,
+        binding_id: String,
+    ) -> Self {
+        let stop = Arc::new(AtomicBool::new(false));
+        let progress = Arc::new(Mutex::new(Progress::default()));
+
+        let handle = {
+            let stop = stop.clone();
+            let progress = progress.clone();
+            let tm = transcription_manager.clone();
+            thread::spawn(move || {
+                while !stop.load(Ordering::SeqCst) {
+                    thread::sleep(Duration::from_millis(SEGMENT_POLL_MS));
+                    if stop.load(Ordering::SeqCst) {
+                        break;
+                    }
+
+                    let start = progress.lock().unwrap().decoded_samples;
+                    let Some((end, segment)) = recording_manager.recording_segment_since(
+                        &binding_id,
+                        start,
+                        MIN_SEGMENT_SAMPLES,
+                        MAX_SEGMENT_SAMPLES,
+                    ) else {
+                        continue;
+                    };
+
+                    match tm.transcribe_segment(segment) {
+                        Ok(text) => {
+                            debug!(
+                                "Decoded segment {}..{} for '{}' ahead of stop",
+                                start, end, binding_id
+                            );
+                            let mut progress = progress.lock().unwrap();
+                            progress.texts.push(text);
+                            progress.decoded_samples = end;
+                        }
+                        Err(e) => {
+                            // Leave the rest to the final decode on stop.
+                            warn!("Segment transcription failed for '{}': {}", binding_id, e);
+                            break;
+                        }
+                    }
+                }
+            })
+        };
+
+        Self {
+            transcription_manager,
+            stop,
+            progress,
+            handle: Some(handle),
+        }
+    }
+
+    /// Waits for any in-flight segment, then transcribes the rest of `samples`
+    /// (the full recording returned on stop) and stitches the text in order.
+    pub fn finish(mut self, samples: SampleView) -> Result<String> {
+        self.stop.store(true, Ordering::SeqCst);
+        if let Some(handle) = self.handle.take() {
+            if handle.join().is_err() {
+                warn!("Segment transcription worker panicked");
+            }
+        }
+
+        let progress = std::mem::take(&mut *self.progress.lock().unwrap());
+        if progress.decoded_samples == 0 || progress.decoded_samples > samples.len() {
+            return self.transcription_manager.transcribe(samples);
+        }
+
+        let mut text = progress.texts.iter().fold(String::new(), |acc, part| {
+            join_transcript(&acc, part.trim())
+        });
+
+        let tail = samples.slice_from(progress.decoded_samples);
+        if !tail.is_empty() {
+            let tail = if tail.len() < MIN_TAIL_SAMPLES {
+                let mut padded = tail.into_vec();
+                padded.resize(MIN_TAIL_SAMPLES * 5 / 4, 0.0);
+                padded.into()
+            } else {
+                tail
+            };
+            let tail_text = self.transcription_manager.transcribe(tail)?;
+            text = join_transcript(&text, tail_text.trim());
+        } else {
+            self.transcription_manager
+                .maybe_unload_immediately("segmented transcription");
+        }
+        debug!(
+            "Segmented transcription reused {} decoded samples in {} segments",
+            progress.decoded_samples,
+            progress.texts.len()
+        );
+        Ok(text)
+    }
+
+    /// Stops the worker without waiting for it; its results are discarded.
+    pub fn cancel(mut self) {
+        self.stop.store(true, Ordering::SeqCst);
+        self.handle.take();
+    }
+}
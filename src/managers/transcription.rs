@@ -1,12 +1,15 @@
-use crate::audio_toolkit::{apply_custom_words, filter_transcription_output};
+use crate::audio_toolkit::{constants, process_transcript, CustomVocabulary, SampleView};
 use crate::managers::model::{EngineType, ModelManager};
-use crate::settings::{ModelUnloadTimeout, Settings};
+use crate::settings::{settings_snapshot, ModelUnloadTimeout, SettingsSnapshot};
+use crate::utils::mmap::{Advice, MappedFiles};
 use anyhow::Result;
 use log::{debug, error, info, warn};
+use std::collections::{HashMap, HashSet};
+use std::path::Path;
 use std::sync::atomic::{AtomicBool, AtomicU64, Ordering};
 use std::sync::{Arc, Condvar, Mutex};
 use std::thread;
-use std::time::{Duration, SystemTime};
+use std::time::{Duration, Instant, SystemTime};
 use transcribe_rs::{
     engines::{
         moonshine::{ModelVariant, MoonshineEngine, MoonshineModelParams},
@@ -36,6 +39,15 @@ impl LoadedEngine {
 }
 
 const LOAD_RETRY_COOLDOWN_MS: u64 = 3000;
+/// Focus changes arrive in bursts; warm-up requests closer than this are ignored.
+const PRELOAD_COOLDOWN_MS: u64 = 2000;
+/// Once the undecided part of a live stream grows past this many samples its
+/// text is committed and later ticks stop re-decoding it.
+const LIVE_STREAM_COMMIT_SAMPLES: usize = 16000 * 6;
+/// Audio before the committed offset that is decoded again with each window so
+/// words cut at the commit boundary are recognised in full.
+const LIVE_STREAM_OVERLAP_SAMPLES: usize = 16000;
+const LIVE_STREAM_MAX_OVERLAP_TOKENS: usize = 12;
 
 #[derive(Clone, Copy, Debug, PartialEq, Eq)]
 enum ModelLoadFailureKind {
@@ -51,29 +63,268 @@ struct ModelLoadFailure {
     at_ms: u64,
 }
 
+/// Order in which queued decodes get the engine. Decodes already running are
+/// never interrupted; priority only decides who goes next.
+#[derive(Clone, Copy, Debug, PartialEq, Eq)]
+enum JobPriority {
+    /// Text the user is waiting to have committed.
+    Final,
+    /// Part of a recording still in progress, reused by its final decode.
+    Segment,
+    /// Throwaway preview text; may be dropped before it reaches the engine.
+    Live,
+}
+
+#[derive(Default)]
+struct EngineQueue {
+    busy: bool,
+    waiting_final: usize,
+    waiting_segment: usize,
+    /// Bumped whenever a final decode takes the engine. Live decodes queued
+    /// before that are stale by the time they would run.
+    final_epoch: u64,
+}
+
+/// Hands out turns on the single loaded engine by [`JobPriority`].
+#[derive(Default)]
+struct EngineScheduler {
+    queue: Mutex<EngineQueue>,
+    turn_condvar: Condvar,
+}
+
+/// Held for the duration of one decode; releases the engine on drop.
+struct EngineTurn<'a> {
+    scheduler: &'a EngineScheduler,
+}
+
+impl Drop for EngineTurn<'_> {
+    fn drop(&mut self) {
+        self.scheduler.queue.lock().unwrap().busy = false;
+        self.scheduler.turn_condvar.notify_all();
+    }
+}
+
+impl EngineScheduler {
+    /// Waits for the engine. Live jobs yield to any waiting final or segment
+    /// job and return `None` instead of running once a final decode was
+    /// admitted after they queued or `still_wanted` says they are superseded.
+    fn acquire(
+        &self,
+        priority: JobPriority,
+        still_wanted: &dyn Fn() -> bool,
+    ) -> Option<EngineTurn<'_>> {
+        let mut queue = self.queue.lock().unwrap();
+        match priority {
+            JobPriority::Final => {
+                queue.waiting_final += 1;
+                while queue.busy {
+                    queue = self.turn_condvar.wait(queue).unwrap();
+                }
+                queue.waiting_final -= 1;
+                queue.final_epoch += 1;
+            }
+            JobPriority::Segment => {
+                queue.waiting_segment += 1;
+                while queue.busy || queue.waiting_final > 0 {
+                    queue = self.turn_condvar.wait(queue).unwrap();
+                }
+                queue.waiting_segment -= 1;
+            }
+            JobPriority::Live => {
+                let queued_epoch = queue.final_epoch;
+                loop {
+                    if queue.final_epoch != queued_epoch || !still_wanted() {
+                        return None;
+                    }
+                    let yielding = queue.waiting_final > 0 || queue.waiting_segment > 0;
+                    if !queue.busy && !yielding {
+                        break;
+                    }
+                    queue = self.turn_condvar.wait(queue).unwrap();
+                }
+            }
+        }
+        queue.busy = true;
+        Some(EngineTurn { scheduler: self })
+    }
+}
+
 #[derive(Clone)]
 pub struct TranscriptionConfig {
     pub model_unload_timeout: ModelUnloadTimeout,
     pub selected_language: String,
     pub translate_to_english: bool,
-    pub custom_words: Vec<String>,
+    /// Compiled from the `custom-words` setting whenever the config is refreshed.
+    pub custom_vocabulary: Arc<CustomVocabulary>,
     pub word_correction_threshold: f64,
+    pub preload_on_focus: bool,
+    pub map_model_files: bool,
 }
 
 impl TranscriptionConfig {
-    pub fn from_settings(settings: &Settings) -> Self {
+    /// Settings keys the config is built from.
+    pub const KEYS: &'static [&'static str] = &[
+        "model-unload-timeout",
+        "selected-language",
+        "translate-to-english",
+        "custom-words",
+        "word-correction-threshold",
+        "model-preload-on-focus",
+        "model-map-files",
+    ];
+
+    pub fn from_snapshot(settings: &SettingsSnapshot) -> Self {
         Self {
-            model_unload_timeout: settings.model_unload_timeout(),
-            selected_language: settings.selected_language(),
-            translate_to_english: settings.translate_to_english(),
-            custom_words: settings.custom_words(),
-            word_correction_threshold: settings.word_correction_threshold(),
+            model_unload_timeout: settings.model_unload_timeout,
+            selected_language: settings.selected_language.clone(),
+            translate_to_english: settings.translate_to_english,
+            custom_vocabulary: Arc::new(CustomVocabulary::new(&settings.custom_words)),
+            word_correction_threshold: settings.word_correction_threshold,
+            preload_on_focus: settings.model_preload_on_focus,
+            map_model_files: settings.model_map_files,
         }
     }
 }
 
+/// Committed-prefix state for one live preedit session.
+///
+/// Audio before `committed_samples` has already been decoded into
+/// `committed_text`; each tick only decodes from `window_start()` onwards, so
+/// the cost of a preview update is bounded by the commit and overlap sizes
+/// rather than by the length of the dictation.
+#[derive(Default)]
+struct LiveStream {
+    committed_text: String,
+    committed_samples: usize,
+    /// Id of the newest window requested; older queued windows are dropped.
+    generation: u64,
+}
+
+impl LiveStream {
+    fn window_start(&self) -> usize {
+        self.committed_samples
+            .saturating_sub(LIVE_STREAM_OVERLAP_SAMPLES)
+    }
+
+    /// Folds the transcript of `[window_start, window_end)` into the stream and
+    /// returns the full preview text.
+    fn apply_window(
+        &mut self,
+        window_start: usize,
+        window_end: usize,
+        window_text: &str,
+    ) -> String {
+        let window_text = window_text.trim();
+        let tail = if window_start < self.committed_samples {
+            strip_committed_overlap(&self.committed_text, window_text)
+        } else {
+            window_text
+        };
+        let preview = join_transcript(&self.committed_text, tail);
+
+        if window_end.saturating_sub(self.committed_samples) >= LIVE_STREAM_COMMIT_SAMPLES {
+            // The last token may be a word cut mid-utterance; hold it back so the
+            // overlap of the next window decodes it again.
+            let tokens = transcript_tokens(tail);
+            let keep = match tokens.len() {
+                0 | 1 => tail.len(),
+                n => tokens[n - 1].0,
+            };
+            self.committed_text = join_transcript(&self.committed_text, tail[..keep].trim_end());
+            self.committed_samples = window_end;
+        }
+
+        preview
+    }
+}
+
+/// Drops the leading tokens of `window` that repeat the end of `committed`.
+fn strip_committed_overlap<'a>(committed: &str, window: &'a str) -> &'a str {
+    let committed_tokens = transcript_tokens(committed);
+    let window_tokens = transcript_tokens(window);
+    let max = committed_tokens
+        .len()
+        .min(window_tokens.len())
+        .min(LIVE_STREAM_MAX_OVERLAP_TOKENS);
+
+    for overlap in (1..=max).rev() {
+        let committed_tail = &committed_tokens[committed_tokens.len() - overlap..];
+        let matches = committed_tail
+            .iter()
+            .zip(&window_tokens[..overlap])
+            .all(|((_, a), (_, b))| normalize_token(a) == normalize_token(b));
+        if matches {
+            return match window_tokens.get(overlap) {
+                Some((start, _)) => &window[*start..],
+                None => "",
+            };
+        }
+    }
+    window
+}
+
+/// Splits a transcript into words, treating every CJK character as its own
+/// token since those scripts are not space separated.
+fn transcript_tokens(text: &str) -> Vec<(usize, &str)> {
+    let mut tokens = Vec::new();
+    let mut word_start: Option<usize> = None;
+    for (idx, ch) in text.char_indices() {
+        if ch.is_whitespace() || is_cjk(ch) {
+            if let Some(start) = word_start.take() {
+                tokens.push((start, &text[start..idx]));
+            }
+            if is_cjk(ch) {
+                tokens.push((idx, &text[idx..idx + ch.len_utf8()]));
+            }
+        } else if word_start.is_none() {
+            word_start = Some(idx);
+        }
+    }
+    if let Some(start) = word_start {
+        tokens.push((start, &text[start..]));
+    }
+    tokens
+}
+
+fn normalize_token(token: &str) -> String {
+    token
+        .chars()
+        .filter(|c| c.is_alphanumeric())
+        .flat_map(char::to_lowercase)
+        .collect()
+}
+
+pub(crate) fn join_transcript(head: &str, tail: &str) -> String {
+    if head.is_empty() {
+        return tail.to_string();
+    }
+    if tail.is_empty() {
+        return head.to_string();
+    }
+    let tight =
+        head.chars().next_back().is_some_and(is_cjk) || tail.chars().next().is_some_and(is_cjk);
+    if tight {
+        format!("{}{}", head, tail)
+    } else {
+        format!("{} {}", head, tail)
+    }
+}
+
+fn is_cjk(ch: char) -> bool {
+    matches!(
+        ch,
+        '\u{3040}'..='\u{30ff}'
+            | '\u{3400}'..='\u{4dbf}'
+            | '\u{4e00}'..='\u{9fff}'
+            | '\u{f900}'..='\u{faff}'
+            | '\u{3000}'..='\u{303f}'
+            | '\u{ff00}'..='\u{ffef}'
+    )
+}
+
 struct SharedState {
     engine: Mutex<Option<LoadedEngine>>,
+    scheduler: EngineScheduler,
     config: Mutex<TranscriptionConfig>,
     current_model_id: Mutex<Option<String>>,
     last_activity: AtomicU64,
@@ -81,6 +332,24 @@ struct SharedState {
     loading_condvar: Condvar,
     last_load_failure: Mutex<Option<ModelLoadFailure>>,
     load_epoch: AtomicU64,
+    /// Sessions between start and final transcription. The model is never
+    /// unloaded while any are held, whatever the unload timeout says.
+    session_holds: Mutex<HashSet<u64>>,
+    /// Read-only mappings of the loaded model's files, kept for as long as the
+    /// engine so their page-cache pages stay warm.
+    model_files: Mutex<Option<MappedFiles>>,
+}
+
+/// Snapshot returned by [`TranscriptionManager::get_model_load_status`].
+#[derive(Clone, Debug, Default)]
+pub struct ModelLoadStatus {
+    pub is_loading: bool,
+    pub is_loaded: bool,
+    pub model_id: Option<String>,
+    /// Total size of the mapped model files (0 when mapping is disabled).
+    pub mapped_bytes: u64,
+    /// Portion of `mapped_bytes` currently in the page cache.
+    pub resident_bytes: u64,
 }
 
 pub struct TranscriptionManager {
@@ -88,16 +357,18 @@ pub struct TranscriptionManager {
     model_manager: Arc<ModelManager>,
     shutdown_signal: Arc<AtomicBool>,
     watcher_handle: Mutex<Option<thread::JoinHandle<()>>>,
+    live_streams: Mutex<HashMap<u64, LiveStream>>,
+    last_preload_ms: AtomicU64,
 }
 
 impl TranscriptionManager {
     pub fn new(model_manager: Arc<ModelManager>) -> Result<Self> {
-        let settings = Settings::new();
-        let config = TranscriptionConfig::from_settings(&settings);
+        let config = TranscriptionConfig::from_snapshot(&settings_snapshot());
         let _unload_timeout = config.model_unload_timeout;
 
         let shared = Arc::new(SharedState {
             engine: Mutex::new(None),
+            scheduler: EngineScheduler::default(),
             config: Mutex::new(config),
             current_model_id: Mutex::new(None),
             last_activity: AtomicU64::new(
@@ -110,6 +381,8 @@ impl TranscriptionManager {
             loading_condvar: Condvar::new(),
             last_load_failure: Mutex::new(None),
             load_epoch: AtomicU64::new(0),
+            session_holds: Mutex::new(HashSet::new()),
+            model_files: Mutex::new(None),
         });
 
         let shutdown_signal = Arc::new(AtomicBool::new(false));
@@ -129,6 +402,10 @@ impl TranscriptionManager {
                     let timeout = config.model_unload_timeout;
                     drop(config);
 
+                    if !shared_clone.session_holds.lock().unwrap().is_empty() {
+                        continue;
+                    }
+
                     let timeout_seconds = timeout.to_seconds();
 
                     if let Some(limit_seconds) = timeout_seconds {
@@ -150,6 +427,7 @@ impl TranscriptionManager {
                                 *engine = None;
                                 drop(engine);
                                 *shared_clone.current_model_id.lock().unwrap() = None;
+                                *shared_clone.model_files.lock().unwrap() = None;
                             }
                         }
                     }
@@ -162,6 +440,8 @@ impl TranscriptionManager {
                 model_manager,
                 shutdown_signal,
                 watcher_handle: Mutex::new(Some(handle)),
+                live_streams: Mutex::new(HashMap::new()),
+                last_preload_ms: AtomicU64::new(0),
             };
 
             Ok(manager)
@@ -217,12 +497,20 @@ impl TranscriptionManager {
             let mut current_model = self.shared.current_model_id.lock().unwrap();
             *current_model = None;
         }
+        *self.shared.model_files.lock().unwrap() = None;
 
         debug!("Model unloaded");
         Ok(())
     }
 
     pub fn maybe_unload_immediately(&self, context: &str) {
+        if !self.shared.session_holds.lock().unwrap().is_empty() {
+            debug!(
+                "Keeping model loaded after {}: a recording session is active",
+                context
+            );
+            return;
+        }
         let config = self.shared.config.lock().unwrap();
         if config.model_unload_timeout == ModelUnloadTimeout::Immediately && self.is_model_loaded()
         {
@@ -232,6 +520,53 @@ impl TranscriptionManager {
         }
     }
 
+    /// Speculatively warms the selected model when a text field gains focus,
+    /// so the first recording does not wait on the load. The regular unload
+    /// timeout still applies from the moment the warm-up starts.
+    pub fn preload_on_focus(&self) {
+        let (timeout, enabled) = {
+            let config = self.shared.config.lock().unwrap();
+            (config.model_unload_timeout, config.preload_on_focus)
+        };
+        // With an immediate unload policy a warm model would never be kept.
+        if !enabled || timeout == ModelUnloadTimeout::Immediately {
+            return;
+        }
+
+        let now = Self::now_ms();
+        let last = self.last_preload_ms.load(Ordering::Relaxed);
+        if now.saturating_sub(last) < PRELOAD_COOLDOWN_MS {
+            return;
+        }
+        self.last_preload_ms.store(now, Ordering::Relaxed);
+
+        if self.is_model_loaded() || !self.has_model_selected() {
+            return;
+        }
+        debug!("Preloading model on focus");
+        self.update_activity();
+        self.initiate_model_load();
+    }
+
+    /// Keeps the model resident for `session_id` until `release_session` and
+    /// starts loading it, so the load overlaps with the user speaking.
+    pub fn hold_for_session(&self, session_id: u64) {
+        self.shared.session_holds.lock().unwrap().insert(session_id);
+        self.update_activity();
+        self.initiate_model_load();
+    }
+
+    pub fn release_session(&self, session_id: u64) {
+        let now_idle = {
+            let mut holds = self.shared.session_holds.lock().unwrap();
+            holds.remove(&session_id) && holds.is_empty()
+        };
+        if now_idle {
+            self.update_activity();
+            self.maybe_unload_immediately("session end");
+        }
+    }
+
     pub fn load_model(&self, model_id: &str) -> Result<()> {
         debug!("Loading model: {}", model_id);
 
@@ -249,6 +584,7 @@ impl TranscriptionManager {
             .get_model_path(model_id)
             .ok_or_else(|| anyhow::anyhow!("Model path not found"))?;
 
+        let model_files = Self::map_model_files(&self.shared, &model_path);
         let loaded_engine = match model_info.engine_type {
             EngineType::Whisper => {
                 let mut engine = WhisperEngine::new();
@@ -291,6 +627,7 @@ impl TranscriptionManager {
             let mut current_model = self.shared.current_model_id.lock().unwrap();
             *current_model = Some(model_id.to_string());
         }
+        *self.shared.model_files.lock().unwrap() = model_files;
 
         info!("Model {} loaded successfully", model_id);
         Ok(())
@@ -372,6 +709,7 @@ impl TranscriptionManager {
             let model_path = model_path.unwrap();
             let model_info = model_info.unwrap();
 
+            let model_files = Self::map_model_files(&shared, &model_path);
             let load_result: Result<LoadedEngine> = match model_info.engine_type {
                 EngineType::Whisper => {
                     let mut engine = WhisperEngine::new();
@@ -435,6 +773,7 @@ impl TranscriptionManager {
 
                     *shared.engine.lock().unwrap() = Some(loaded_engine);
                     *shared.current_model_id.lock().unwrap() = Some(selected_model.clone());
+                    *shared.model_files.lock().unwrap() = model_files;
                     Self::clear_load_failure(&shared, &selected_model);
                     info!("Model {} loaded successfully", selected_model);
                 }
@@ -453,13 +792,10 @@ impl TranscriptionManager {
         });
     }
 
-    fn transcribe_internal(
-        &self,
-        samples: Vec<f32>,
-        allow_immediate_unload: bool,
-    ) -> Result<String> {
-        self.update_activity();
-
+    /// Starts loading the selected model if it is not the loaded one and
+    /// blocks until loading settles. Decoding does this itself; calling it
+    /// first lets the caller time the wait separately from the decode.
+    pub fn wait_for_selected_model(&self) {
         for _ in 0..2 {
             let selected_model = self.model_manager.get_current_model();
             let current_model = self.shared.current_model_id.lock().unwrap().clone();
@@ -477,6 +813,18 @@ impl TranscriptionManager {
                 is_loading = self.shared.loading_condvar.wait(is_loading).unwrap();
             }
         }
+    }
+
+    /// Decodes `samples` once the scheduler grants `priority` a turn. Returns
+    /// `None` only for live jobs dropped before reaching the engine.
+    fn transcribe_internal(
+        &self,
+        samples: SampleView,
+        priority: JobPriority,
+        still_wanted: &dyn Fn() -> bool,
+    ) -> Result<Option<String>> {
+        self.update_activity();
+        self.wait_for_selected_model();
 
         let selected_model = self.model_manager.get_current_model();
         if selected_model.is_empty() {
@@ -495,9 +843,15 @@ impl TranscriptionManager {
             ));
         }
 
+        let Some(turn) = self.shared.scheduler.acquire(priority, still_wanted) else {
+            debug!("Dropped superseded live transcription before decoding");
+            return Ok(None);
+        };
+
         let mut engine = self.shared.engine.lock().unwrap();
         if engine.is_none() {
             drop(engine);
+            drop(turn);
             if let Some(message) = self.selected_model_failure_message() {
                 return Err(anyhow::anyhow!("No engine loaded: {}", message));
             }
@@ -505,16 +859,21 @@ impl TranscriptionManager {
         }
         let loaded_engine = engine.as_mut().unwrap();
 
-        let (language, translate, custom_words, threshold) = {
+        let (language, translate, custom_vocabulary, threshold) = {
             let config = self.shared.config.lock().unwrap();
             (
                 config.selected_language.clone(),
                 config.translate_to_english,
-                config.custom_words.clone(),
+                config.custom_vocabulary.clone(),
                 config.word_correction_threshold,
             )
         };
 
+        // The engines take ownership of a contiguous buffer; this is the only
+        // place the recorded chunks are materialized.
+        let samples = samples.into_vec();
+        let audio_secs = samples.len() as f32 / constants::WHISPER_SAMPLE_RATE as f32;
+        let decode_started = Instant::now();
         let result = match loaded_engine {
             LoadedEngine::Whisper(e) => {
                 let mut params = WhisperInferenceParams::default();
@@ -522,14 +881,14 @@ impl TranscriptionManager {
                     params.language = Some(language.clone());
                 }
                 params.translate = translate;
-                e.transcribe_samples(samples.clone(), Some(params))
+                e.transcribe_samples(samples, Some(params))
                     .map_err(|e| anyhow::anyhow!("Whisper transcription failed: {}", e))
             }
             LoadedEngine::Parakeet(e) => e
-                .transcribe_samples(samples.clone(), None)
+                .transcribe_samples(samples, None)
                 .map_err(|e| anyhow::anyhow!("Parakeet transcription failed: {}", e)),
             LoadedEngine::Moonshine(e) => e
-                .transcribe_samples(samples.clone(), None)
+                .transcribe_samples(samples, None)
                 .map_err(|e| anyhow::anyhow!("Moonshine transcription failed: {}", e)),
             LoadedEngine::SenseVoice(e) => e
                 .transcribe_samples(samples, None)
@@ -537,42 +896,160 @@ impl TranscriptionManager {
         };
 
         drop(engine);
+        drop(turn);
 
         let transcription_result = result?;
-        let mut text = transcription_result.text;
-
-        if !custom_words.is_empty() {
-            text = apply_custom_words(&text, &custom_words, threshold);
+        let decode_secs = decode_started.elapsed().as_secs_f32();
+        let text = process_transcript(
+            &transcription_result.text,
+            Some((&custom_vocabulary, threshold)),
+        );
+
+        // Only final decodes are measured, so short live and segment windows
+        // don't skew the average.
+        if priority == JobPriority::Final {
+            self.model_manager
+                .record_decode_speed(&selected_model, audio_secs, decode_secs);
+            self.model_manager.save_decode_speeds();
+            self.maybe_unload_immediately("transcription");
         }
 
-        text = filter_transcription_output(&text);
+        Ok(Some(text))
+    }
 
-        if allow_immediate_unload {
-            self.maybe_unload_immediately("transcription");
-        }
+    /// Final decode; jumps ahead of queued segment and live decodes.
+    pub fn transcribe(&self, samples: SampleView) -> Result<String> {
+        self.transcribe_internal(samples, JobPriority::Final, &|| true)
+            .map(Option::unwrap_or_default)
+    }
+
+    /// Preview decode; `None` when it was dropped in favour of a final decode.
+    pub fn transcribe_for_live(&self, samples: SampleView) -> Result<Option<String>> {
+        self.transcribe_internal(samples, JobPriority::Live, &|| true)
+    }
 
-        Ok(text)
+    /// Decodes one segment of a recording that is still in progress; the
+    /// model stays loaded for the rest of the session.
+    pub fn transcribe_segment(&self, samples: SampleView) -> Result<String> {
+        self.transcribe_internal(samples, JobPriority::Segment, &|| true)
+            .map(Option::unwrap_or_default)
     }
 
-    pub fn transcribe(&self, samples: Vec<f32>) -> Result<String> {
-        self.transcribe_internal(samples, true)
+    /// Starts (or restarts) incremental live transcription for a session.
+    pub fn begin_live_stream(&self, session_id: u64) {
+        self.live_streams
+            .lock()
+            .unwrap()
+            .insert(session_id, LiveStream::default());
+    }
+
+    pub fn end_live_stream(&self, session_id: u64) {
+        self.live_streams.lock().unwrap().remove(&session_id);
+    }
+
+    /// Absolute sample offset the next live window for `session_id` should
+    /// start at: the committed offset minus a short overlap.
+    pub fn live_stream_window_start(&self, session_id: u64) -> usize {
+        self.live_streams
+            .lock()
+            .unwrap()
+            .get(&session_id)
+            .map(LiveStream::window_start)
+            .unwrap_or(0)
     }
 
-    pub fn transcribe_for_live(&self, samples: Vec<f32>) -> Result<String> {
-        self.transcribe_internal(samples, false)
+    /// Decodes `samples`, which start at absolute offset `window_start` of the
+    /// session recording, and returns the stitched preview text. Returns
+    /// `None` when the window was superseded by a newer window, by the end of
+    /// the stream or by a final decode before it reached the engine.
+    pub fn transcribe_live_window(
+        &self,
+        session_id: u64,
+        window_start: usize,
+        samples: SampleView,
+    ) -> Result<Option<String>> {
+        let window_end = window_start + samples.len();
+        let generation = {
+            let mut streams = self.live_streams.lock().unwrap();
+            let stream = streams.entry(session_id).or_default();
+            stream.generation += 1;
+            stream.generation
+        };
+        let still_wanted = || {
+            self.live_streams
+                .lock()
+                .unwrap()
+                .get(&session_id)
+                .is_some_and(|stream| stream.generation == generation)
+        };
+        let Some(window_text) =
+            self.transcribe_internal(samples, JobPriority::Live, &still_wanted)?
+        else {
+            return Ok(None);
+        };
+        let mut streams = self.live_streams.lock().unwrap();
+        let Some(stream) = streams.get_mut(&session_id) else {
+            return Ok(None);
+        };
+        Ok(Some(stream.apply_window(
+            window_start,
+            window_end,
+            &window_text,
+        )))
     }
 
-    pub fn refresh_config_from_settings(&self, settings: &Settings) {
-        let updated = TranscriptionConfig::from_settings(settings);
+    pub fn apply_settings(&self, settings: &SettingsSnapshot) {
+        let updated = TranscriptionConfig::from_snapshot(settings);
         let mut config = self.shared.config.lock().unwrap();
         *config = updated;
     }
 
-    pub fn get_model_load_status(&self) -> (bool, bool, Option<String>) {
+    pub fn get_model_load_status(&self) -> ModelLoadStatus {
         let is_loading = *self.shared.is_loading.lock().unwrap();
         let is_loaded = self.is_model_loaded();
         let current_model = self.shared.current_model_id.lock().unwrap().clone();
-        (is_loading, is_loaded, current_model)
+        let (mapped_bytes, resident_bytes) = match self.shared.model_files.lock().unwrap().as_ref()
+        {
+            Some(files) => (files.mapped_bytes(), files.resident_bytes()),
+            None => (0, 0),
+        };
+        ModelLoadStatus {
+            is_loading,
+            is_loaded,
+            model_id: current_model,
+            mapped_bytes,
+            resident_bytes,
+        }
+    }
+
+    /// Maps the model files read-only and asks the kernel to read them ahead.
+    ///
+    /// The engines still read the files into their own buffers, but those
+    /// reads are then served from the shared page cache, which also outlives
+    /// daemon restarts and is shared with the UI process.
+    fn map_model_files(shared: &Arc<SharedState>, model_path: &Path) -> Option<MappedFiles> {
+        if !shared.config.lock().unwrap().map_model_files {
+            return None;
+        }
+        match MappedFiles::open(model_path) {
+            Ok(files) => {
+                files.advise(Advice::WillNeed);
+                debug!(
+                    "Mapped {} bytes of model files from {}",
+                    files.mapped_bytes(),
+                    model_path.display()
+                );
+                Some(files)
+            }
+            Err(e) => {
+                warn!(
+                    "Failed to map model files at {}: {}",
+                    model_path.display(),
+                    e
+                );
+                None
+            }
+        }
     }
 
     fn update_activity(&self) {
@@ -743,10 +1220,93 @@ mod tests {
         ));
     }
 
+    #[test]
+    fn scheduler_runs_final_jobs_before_waiting_live_jobs() {
+        let scheduler = Arc::new(EngineScheduler::default());
+        let first = scheduler.acquire(JobPriority::Segment, &|| true).unwrap();
+        let wait_until = |ready: &dyn Fn() -> bool| {
+            while !ready() {
+                thread::yield_now();
+            }
+        };
+
+        // `still_wanted` runs under the queue lock once the live job has
+        // queued, right before it waits.
+        let live_queued = Arc::new(AtomicBool::new(false));
+        let live = {
+            let scheduler = scheduler.clone();
+            let live_queued = live_queued.clone();
+            thread::spawn(move || {
+                scheduler
+                    .acquire(JobPriority::Live, &|| {
+                        live_queued.store(true, Ordering::SeqCst);
+                        true
+                    })
+                    .is_some()
+            })
+        };
+        wait_until(&|| live_queued.load(Ordering::SeqCst));
+
+        let fin = {
+            let scheduler = scheduler.clone();
+            thread::spawn(move || scheduler.acquire(JobPriority::Final, &|| true).is_some())
+        };
+        wait_until(&|| scheduler.queue.lock().unwrap().waiting_final == 1);
+
+        drop(first);
+        // The live job queued before the final decode ran, so it is dropped.
+        assert!(fin.join().unwrap());
+        assert!(!live.join().unwrap());
+        assert!(scheduler.acquire(JobPriority::Live, &|| true).is_some());
+        assert!(scheduler.acquire(JobPriority::Live, &|| false).is_none());
+    }
+
     #[test]
     fn stale_load_detection_uses_epoch_and_selection() {
         assert!(TranscriptionManager::is_stale_load("small", 2, "small", 3));
         assert!(TranscriptionManager::is_stale_load("small", 2, "medium", 2));
         assert!(!TranscriptionManager::is_stale_load("small", 2, "small", 2));
     }
+
+    #[test]
+    fn live_stream_commits_and_only_decodes_overlap_afterwards() {
+        let mut stream = LiveStream::default();
+        assert_eq!(stream.window_start(), 0);
+
+        let preview = stream.apply_window(0, 8000, "hello there");
+        assert_eq!(preview, "hello there");
+        assert_eq!(stream.window_start(), 0);
+
+        let end = LIVE_STREAM_COMMIT_SAMPLES;
+        let preview = stream.apply_window(0, end, "hello there how are");
+        assert_eq!(preview, "hello there how are");
+        assert_eq!(stream.committed_text, "hello there how");
+        assert_eq!(stream.window_start(), end - LIVE_STREAM_OVERLAP_SAMPLES);
+
+        let start = stream.window_start();
+        let preview = stream.apply_window(start, end + 8000, "How are you doing");
+        assert_eq!(preview, "hello there how are you doing");
+    }
+
+    #[test]
+    fn live_stream_appends_window_without_overlap_match() {
+        let mut stream = LiveStream {
+            committed_text: "first part".to_string(),
+            committed_samples: LIVE_STREAM_COMMIT_SAMPLES,
+        };
+        let start = stream.window_start();
+        let preview = stream.apply_window(start, start + 20000, "second part");
+        assert_eq!(preview, "first part second part");
+    }
+
+    #[test]
+    fn live_stream_stitches_cjk_without_spaces() {
+        let mut stream = LiveStream {
+            committed_text: "今天天气".to_string(),
+            committed_samples: LIVE_STREAM_COMMIT_SAMPLES,
+        };
+        let start = stream.window_start();
+        let preview = stream.apply_window(start, start + 20000, "天气很好");
+        assert_eq!(preview, "今天天气很好");
+    }
 }
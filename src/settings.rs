@@ -2,6 +2,7 @@ use gio::prelude::{SettingsExt, SettingsExtManual};
 use gio::Settings as GioSettings;
 use serde::{Deserialize, Serialize};
 use std::collections::HashMap;
+use std::sync::{Arc, Mutex, OnceLock, RwLock};
 
 const SETTINGS_SCHEMA: &str = "io.dikt.Transcription";
 
@@ -251,6 +252,34 @@ impl Settings {
             .ok();
     }
 
+    pub fn model_preload_on_focus(&self) -> bool {
+        self.gio_settings.boolean("model-preload-on-focus")
+    }
+
+    pub fn set_model_preload_on_focus(&self, value: bool) {
+        self.gio_settings
+            .set_boolean("model-preload-on-focus", value)
+            .ok();
+    }
+
+    pub fn model_map_files(&self) -> bool {
+        self.gio_settings.boolean("model-map-files")
+    }
+
+    pub fn set_model_map_files(&self, value: bool) {
+        self.gio_settings.set_boolean("model-map-files", value).ok();
+    }
+
+    pub fn segmented_transcription(&self) -> bool {
+        self.gio_settings.boolean("segmented-transcription")
+    }
+
+    pub fn set_segmented_transcription(&self, value: bool) {
+        self.gio_settings
+            .set_boolean("segmented-transcription", value)
+            .ok();
+    }
+
     // Custom Words
     pub fn custom_words(&self) -> Vec<String> {
         self.gio_settings
@@ -317,6 +346,36 @@ impl Settings {
             .ok();
     }
 
+    pub fn low_latency_resampler(&self) -> bool {
+        self.gio_settings.boolean("low-latency-resampler")
+    }
+
+    pub fn set_low_latency_resampler(&self, value: bool) {
+        self.gio_settings
+            .set_boolean("low-latency-resampler", value)
+            .ok();
+    }
+
+    pub fn spill_long_recordings(&self) -> bool {
+        self.gio_settings.boolean("spill-long-recordings")
+    }
+
+    pub fn set_spill_long_recordings(&self, value: bool) {
+        self.gio_settings
+            .set_boolean("spill-long-recordings", value)
+            .ok();
+    }
+
+    pub fn vad_frames_per_call(&self) -> u32 {
+        self.gio_settings.uint("vad-frames-per-call")
+    }
+
+    pub fn set_vad_frames_per_call(&self, value: u32) {
+        self.gio_settings
+            .set_uint("vad-frames-per-call", value)
+            .ok();
+    }
+
     pub fn experimental_enabled(&self) -> bool {
         self.gio_settings.boolean("experimental-enabled")
     }
@@ -413,6 +472,26 @@ impl Settings {
             .ok();
     }
 
+    pub fn post_process_streaming(&self) -> bool {
+        self.gio_settings.boolean("post-process-streaming")
+    }
+
+    pub fn set_post_process_streaming(&self, value: bool) {
+        self.gio_settings
+            .set_boolean("post-process-streaming", value)
+            .ok();
+    }
+
+    pub fn post_process_latency_budget_ms(&self) -> u32 {
+        self.gio_settings.uint("post-process-latency-budget-ms")
+    }
+
+    pub fn set_post_process_latency_budget_ms(&self, value: u32) {
+        self.gio_settings
+            .set_uint("post-process-latency-budget-ms", value)
+            .ok();
+    }
+
     pub fn connect_changed<F>(&self, key: Option<&str>, callback: F)
     where
         F: Fn(&str) + 'static,
@@ -428,6 +507,136 @@ impl Default for Settings {
     }
 }
 
+/// The values the daemon reads while recording, captured in one pass so the
+/// recording path does not open a `gio::Settings` or go to dconf per read.
+#[derive(Debug, Clone)]
+pub struct SettingsSnapshot {
+    pub audio_feedback: bool,
+    pub audio_feedback_volume: f32,
+    pub sound_theme: SoundTheme,
+    pub selected_output_device: Option<String>,
+    pub selected_model: String,
+    pub selected_language: String,
+    pub translate_to_english: bool,
+    pub model_unload_timeout: ModelUnloadTimeout,
+    pub model_preload_on_focus: bool,
+    pub model_map_files: bool,
+    pub segmented_transcription: bool,
+    pub custom_words: Vec<String>,
+    pub word_correction_threshold: f64,
+    pub vad_frames_per_call: u32,
+    pub experimental_enabled: bool,
+    pub post_process_enabled: bool,
+    pub post_process_provider_id: String,
+    pub post_process_api_keys: HashMap<String, String>,
+    pub post_process_models: HashMap<String, String>,
+    pub post_process_base_urls: HashMap<String, String>,
+    pub post_process_prompts: Vec<LLMPrompt>,
+    pub post_process_selected_prompt_id: Option<String>,
+    pub post_process_streaming: bool,
+    pub post_process_latency_budget_ms: u32,
+}
+
+impl SettingsSnapshot {
+    pub fn read(settings: &Settings) -> Self {
+        Self {
+            audio_feedback: settings.audio_feedback(),
+            audio_feedback_volume: settings.audio_feedback_volume(),
+            sound_theme: settings.sound_theme(),
+            selected_output_device: settings.selected_output_device(),
+            selected_model: settings.selected_model(),
+            selected_language: settings.selected_language(),
+            translate_to_english: settings.translate_to_english(),
+            model_unload_timeout: settings.model_unload_timeout(),
+            model_preload_on_focus: settings.model_preload_on_focus(),
+            model_map_files: settings.model_map_files(),
+            segmented_transcription: settings.segmented_transcription(),
+            custom_words: settings.custom_words(),
+            word_correction_threshold: settings.word_correction_threshold(),
+            vad_frames_per_call: settings.vad_frames_per_call(),
+            experimental_enabled: settings.experimental_enabled(),
+            post_process_enabled: settings.post_process_enabled(),
+            post_process_provider_id: settings.post_process_provider_id(),
+            post_process_api_keys: settings.post_process_api_keys(),
+            post_process_models: settings.post_process_models(),
+            post_process_base_urls: settings.post_process_base_urls(),
+            post_process_prompts: settings.post_process_prompts(),
+            post_process_selected_prompt_id: settings.post_process_selected_prompt_id(),
+            post_process_streaming: settings.post_process_streaming(),
+            post_process_latency_budget_ms: settings.post_process_latency_budget_ms(),
+        }
+    }
+}
+
+type SnapshotListener = Box<dyn Fn(&SettingsSnapshot) + Send + Sync>;
+
+struct SnapshotCache {
+    current: RwLock<Arc<SettingsSnapshot>>,
+    listeners: Mutex<Vec<(&'static [&'static str], SnapshotListener)>>,
+}
+
+static SNAPSHOT_CACHE: OnceLock<SnapshotCache> = OnceLock::new();
+
+impl SnapshotCache {
+    fn publish(&self, snapshot: SettingsSnapshot, changed_key: &str) {
+        let snapshot = Arc::new(snapshot);
+        *self.current.write().unwrap() = snapshot.clone();
+        for (keys, listener) in self.listeners.lock().unwrap().iter() {
+            if keys.contains(&changed_key) {
+                listener(&snapshot);
+            }
+        }
+    }
+}
+
+/// Serves `settings_snapshot()` from a cache that `settings`' change signal
+/// refreshes. Call once, before connecting other change handlers, so those
+/// already see the new values; `settings` must stay alive, as its signal is
+/// what keeps the cache current.
+pub fn watch_settings_snapshot(settings: &Settings) {
+    let initial = SettingsSnapshot::read(settings);
+    if SNAPSHOT_CACHE
+        .set(SnapshotCache {
+            current: RwLock::new(Arc::new(initial)),
+            listeners: Mutex::new(Vec::new()),
+        })
+        .is_err()
+    {
+        log::warn!("Settings snapshot is already being watched");
+        return;
+    }
+    let source = settings.clone();
+    settings.connect_changed(None, move |changed_key| {
+        if let Some(cache) = SNAPSHOT_CACHE.get() {
+            cache.publish(SettingsSnapshot::read(&source), changed_key);
+        }
+    });
+}
+
+/// Current settings. Outside a process that called
+/// `watch_settings_snapshot` this reads GSettings on every call.
+pub fn settings_snapshot() -> Arc<SettingsSnapshot> {
+    match SNAPSHOT_CACHE.get() {
+        Some(cache) => cache.current.read().unwrap().clone(),
+        None => Arc::new(SettingsSnapshot::read(&Settings::new())),
+    }
+}
+
+/// Calls `listener` with the refreshed snapshot whenever one of `keys`
+/// changes. Does nothing unless the snapshot is being watched.
+pub fn subscribe_settings<F>(keys: &'static [&'static str], listener: F)
+where
+    F: Fn(&SettingsSnapshot) + Send + Sync + 'static,
+{
+    if let Some(cache) = SNAPSHOT_CACHE.get() {
+        cache
+            .listeners
+            .lock()
+            .unwrap()
+            .push((keys, Box::new(listener)));
+    }
+}
+
 pub fn get_default_settings() -> Settings {
     Settings::new()
 }
@@ -1,27 +1,47 @@
 use ferrous_opencc::{config::BuiltinConfig, OpenCC};
+use std::sync::OnceLock;
+
+/// Parsed converters, built on first use (or by [`preload_chinese_converter`])
+/// and shared for the rest of the process. `None` records a failed build so it
+/// is not retried on every transcript.
+static TW2SP_CONVERTER: OnceLock<Option<OpenCC>> = OnceLock::new();
+static S2TWP_CONVERTER: OnceLock<Option<OpenCC>> = OnceLock::new();
 
-/// Converts Chinese text variants based on the selected language.
-///
 /// Assumes the transcription engine outputs Simplified Chinese (most Whisper/Parakeet
 /// models are trained on Simplified). For zh-Hans we apply Tw2sp as a normalization pass;
 /// for zh-Hant we convert Simplified → Traditional with phrase adjustments.
-pub fn convert_chinese_variant(text: &str, language: &str) -> String {
-    let is_simplified = language == "zh-Hans";
-    let is_traditional = language == "zh-Hant";
+fn converter_for_language(language: &str) -> Option<&'static OpenCC> {
+    let (cell, config) = match language {
+        "zh-Hans" => (&TW2SP_CONVERTER, BuiltinConfig::Tw2sp),
+        "zh-Hant" => (&S2TWP_CONVERTER, BuiltinConfig::S2twp),
+        _ => return None,
+    };
+    cell.get_or_init(|| match OpenCC::from_config(config) {
+        Ok(converter) => Some(converter),
+        Err(e) => {
+            log::error!("Failed to load OpenCC converter for {}: {}", language, e);
+            None
+        }
+    })
+    .as_ref()
+}
 
-    if !is_simplified && !is_traditional {
-        return text.to_string();
+/// Converts Chinese text variants based on the selected language.
+pub fn convert_chinese_variant(text: &str, language: &str) -> String {
+    match converter_for_language(language) {
+        Some(converter) => converter.convert(text),
+        None => text.to_string(),
     }
+}
 
-    let config = if is_simplified {
-        BuiltinConfig::Tw2sp
-    } else {
-        BuiltinConfig::S2twp
-    };
-
-    if let Ok(converter) = OpenCC::from_config(config) {
-        converter.convert(text)
-    } else {
-        text.to_string()
+/// Builds the converter for `language` ahead of the first transcript so the
+/// dictionaries are not parsed on the live preview path. No-op for other
+/// languages or once loaded.
+pub fn preload_chinese_converter(language: &str) {
+    if matches!(language, "zh-Hans" | "zh-Hant") {
+        let language = language.to_string();
+        std::thread::spawn(move || {
+            converter_for_language(&language);
+        });
     }
 }
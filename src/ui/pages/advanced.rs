@@ -79,6 +79,28 @@ impl AdvancedPage {
         timeout_row.add_suffix(&timeout_combo);
         model_group.add(&timeout_row);
 
+        let preload_row = ActionRow::builder()
+            .title("Preload On Focus")
+            .subtitle("Load the model when a text field is focused")
+            .build();
+
+        let preload_switch = Switch::builder()
+            .active(state.settings.model_preload_on_focus())
+            .build();
+        preload_switch.set_valign(Align::Center);
+        preload_switch.set_vexpand(false);
+        preload_switch.set_hexpand(false);
+        preload_switch.set_halign(Align::End);
+
+        let state_clone = state.clone();
+        preload_switch.connect_active_notify(move |switch| {
+            state_clone
+                .settings
+                .set_model_preload_on_focus(switch.is_active());
+        });
+        preload_row.add_suffix(&preload_switch);
+        model_group.add(&preload_row);
+
         main_box.append(&model_group);
 
         let debug_group = PreferencesGroup::builder().title("Debug").build();
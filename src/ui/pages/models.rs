@@ -30,16 +30,30 @@ struct ModelRow {
 }
 
 impl ModelRow {
-    fn new(model: &ModelInfo, is_active: bool, state: &Arc<AppState>) -> Self {
+    fn new(
+        model: &ModelInfo,
+        is_active: bool,
+        is_recommended: bool,
+        state: &Arc<AppState>,
+    ) -> Self {
         let row = ActionRow::builder()
             .title(&model.name)
             .subtitle(&model.description)
             .build();
 
-        if model.is_recommended {
+        if is_recommended {
             row.add_prefix(&Image::from_icon_name("starred-symbolic"));
         }
 
+        if let Some(rtf) = model.measured_rtf.filter(|rtf| *rtf > 0.0) {
+            let speed_label = Label::builder()
+                .label(format!("{:.1}× real time", 1.0 / rtf))
+                .tooltip_text("Decoding speed measured on this computer")
+                .css_classes(["dim-label", "caption"])
+                .build();
+            row.add_suffix(&speed_label);
+        }
+
         let size_label = Label::builder()
             .label(format!("{} MB", model.size_mb))
             .css_classes(["dim-label", "caption"])
@@ -346,11 +360,13 @@ impl ModelsPage {
         // Create persistent rows for all models
         let rows: Rc<RefCell<HashMap<String, ModelRow>>> = Rc::new(RefCell::new(HashMap::new()));
         let selected_model = state.model_manager.get_current_model();
+        let recommended = state.model_manager.recommended_model_id();
         {
             let mut rows_lock = rows.borrow_mut();
-            for model in sorted_models(state) {
+            for model in sorted_models(state, recommended.as_deref()) {
                 let is_active = model.id == selected_model;
-                let row = ModelRow::new(&model, is_active, state);
+                let is_recommended = recommended.as_deref() == Some(model.id.as_str());
+                let row = ModelRow::new(&model, is_active, is_recommended, state);
                 models_group.add(row.widget());
                 rows_lock.insert(model.id.clone(), row);
             }
@@ -417,11 +433,12 @@ impl ModelsPage {
     }
 }
 
-fn sorted_models(state: &Arc<AppState>) -> Vec<ModelInfo> {
+fn sorted_models(state: &Arc<AppState>, recommended: Option<&str>) -> Vec<ModelInfo> {
     let mut models = state.model_manager.get_available_models();
+    let is_recommended = |m: &ModelInfo| recommended == Some(m.id.as_str());
     models.sort_by(|a, b| {
-        b.is_recommended
-            .cmp(&a.is_recommended)
+        is_recommended(b)
+            .cmp(&is_recommended(a))
             .then_with(|| b.is_downloaded.cmp(&a.is_downloaded))
             .then_with(|| a.name.cmp(&b.name))
     });
@@ -0,0 +1,156 @@
+//! Long-lived worker pools for daemon jobs.
+//!
+//! A pool owns a fixed set of named threads fed from a bounded queue, so a
+//! burst of work neither spawns a thread per job nor grows without limit. A
+//! job that panics is logged and its worker carries on with the next one.
+
+use log::error;
+use std::cell::OnceCell;
+use std::fmt;
+use std::future::Future;
+use std::panic::{catch_unwind, AssertUnwindSafe};
+use std::sync::{mpsc, Arc, Mutex};
+use std::thread;
+
+type Job = Box<dyn FnOnce() + Send + 'static>;
+
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub enum SubmitError {
+    /// Every worker is busy and the queue is at capacity.
+    Full,
+    /// The workers are gone.
+    Closed,
+}
+
+impl fmt::Display for SubmitError {
+    fn fmt(&self, f: &mut fmt::Formatter<'_>) -> fmt::Result {
+        match self {
+            SubmitError::Full => write!(f, "job queue is full"),
+            SubmitError::Closed => write!(f, "worker pool has shut down"),
+        }
+    }
+}
+
+impl std::error::Error for SubmitError {}
+
+pub struct WorkerPool {
+    tx: mpsc::SyncSender<Job>,
+}
+
+impl WorkerPool {
+    /// Starts `workers` threads named `<name>-<n>` sharing a queue of up to
+    /// `queue_depth` jobs that have not started yet.
+    pub fn new(name: &str, workers: usize, queue_depth: usize) -> std::io::Result<Self> {
+        let (tx, rx) = mpsc::sync_channel::<Job>(queue_depth);
+        let rx = Arc::new(Mutex::new(rx));
+        for index in 0..workers.max(1) {
+            let rx = rx.clone();
+            let pool_name = name.to_string();
+            thread::Builder::new()
+                .name(format!("{}-{}", name, index))
+                .spawn(move || Self::run_worker(&pool_name, &rx))?;
+        }
+        Ok(Self { tx })
+    }
+
+    fn run_worker(pool_name: &str, rx: &Mutex<mpsc::Receiver<Job>>) {
+        loop {
+            // Hold the lock only while waiting, not while the job runs.
+            let job = match rx.lock() {
+                Ok(rx) => rx.recv(),
+                Err(_) => return,
+            };
+            let Ok(job) = job else {
+                return;
+            };
+            if catch_unwind(AssertUnwindSafe(job)).is_err() {
+                error!("Job panicked in worker pool '{}'", pool_name);
+            }
+        }
+    }
+
+    /// Queues `job` without blocking; fails when the queue is full, so
+    /// callers decide how to shed load instead of stalling.
+    pub fn submit<F>(&self, job: F) -> Result<(), SubmitError>
+    where
+        F: FnOnce() + Send + 'static,
+    {
+        self.tx.try_send(Box::new(job)).map_err(|e| match e {
+            mpsc::TrySendError::Full(_) => SubmitError::Full,
+            mpsc::TrySendError::Disconnected(_) => SubmitError::Closed,
+        })
+    }
+}
+
+thread_local! {
+    static THREAD_RUNTIME: OnceCell<tokio::runtime::Runtime> = const { OnceCell::new() };
+}
+
+/// Runs `future` to completion on a current-thread runtime that belongs to
+/// the calling thread and is built on its first use, so pool workers reuse
+/// one runtime across jobs. Must not be called from inside a runtime.
+pub fn block_on<F: Future>(future: F) -> std::io::Result<F::Output> {
+    THREAD_RUNTIME.with(|cell| {
+        if cell.get().is_none() {
+            let runtime = tokio::runtime::Builder::new_current_thread()
+                .enable_all()
+                .build()?;
+            let _ = cell.set(runtime);
+        }
+        Ok(cell.get().expect("runtime set above").block_on(future))
+    })
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use std::sync::Barrier;
+    use std::time::Duration;
+
+    #[test]
+    fn full_queue_rejects_instead_of_spawning() {
+        let pool = WorkerPool::new("test-pool", 1, 1).unwrap();
+        let started = Arc::new(Barrier::new(2));
+        let (release_tx, release_rx) = mpsc::channel::<()>();
+
+        let worker_started = started.clone();
+        pool.submit(move || {
+            worker_started.wait();
+            let _ = release_rx.recv();
+        })
+        .unwrap();
+        started.wait();
+
+        // The worker is busy, so one job fits in the queue and the next does not.
+        pool.submit(|| {}).unwrap();
+        assert_eq!(pool.submit(|| {}), Err(SubmitError::Full));
+        release_tx.send(()).unwrap();
+    }
+
+    #[test]
+    fn worker_survives_a_panicking_job() {
+        let pool = WorkerPool::new("test-panic", 1, 4).unwrap();
+        let (done_tx, done_rx) = mpsc::channel();
+        pool.submit(|| panic!("job failure")).unwrap();
+        pool.submit(move || {
+            done_tx
+                .send(thread::current().name().map(String::from))
+                .unwrap()
+        })
+        .unwrap();
+        let name = done_rx.recv_timeout(Duration::from_secs(5)).unwrap();
+        assert_eq!(name.as_deref(), Some("test-panic-0"));
+    }
+
+    #[test]
+    fn block_on_runs_timers_on_repeated_calls() {
+        for _ in 0..2 {
+            let value = block_on(async {
+                tokio::time::sleep(Duration::from_millis(1)).await;
+                7
+            })
+            .unwrap();
+            assert_eq!(value, 7);
+        }
+    }
+}
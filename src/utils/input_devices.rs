@@ -0,0 +1,453 @@
+//! Keyboard discovery and key delivery for the global shortcut listener.
+//!
+//! Keyboards under `/dev/input` share one epoll set with an inotify watch on
+//! the directory, so devices are added and dropped as they come and go
+//! instead of by rescanning. Each device gets an `EVIOCSMASK` filter that
+//! lets the kernel queue only the keys a shortcut can match; every other
+//! keystroke on the system leaves the daemon asleep.
+
+use std::collections::HashMap;
+use std::ffi::CString;
+use std::io::{Error, ErrorKind, Result};
+use std::os::fd::{AsRawFd, FromRawFd, OwnedFd, RawFd};
+use std::os::unix::ffi::OsStrExt;
+use std::path::{Path, PathBuf};
+
+use evdev::{Device, EventType};
+use log::{debug, info, warn};
+
+const INPUT_DIR: &str = "/dev/input";
+const INOTIFY_TOKEN: u64 = 0;
+const READY_BATCH: usize = 32;
+const READ_BATCH: usize = 64;
+
+// From linux/input-event-codes.h and linux/input.h.
+const EV_SYN: u16 = 0x00;
+const EV_KEY: u16 = 0x01;
+const SYN_DROPPED: u16 = 3;
+const KEY_CNT: usize = 0x300;
+/// Other event types a keyboard may report; their masks are left empty.
+const NON_KEY_EVENT_TYPES: [u32; 7] = [0x02, 0x03, 0x04, 0x05, 0x11, 0x12, 0x15];
+/// `_IOW('E', 0x93, struct input_mask)`
+const EVIOCSMASK: libc::Ioctl = 0x4010_4593_u32 as libc::Ioctl;
+
+#[derive(Clone, Copy, Debug, PartialEq, Eq)]
+pub enum KeyEvent {
+    Press(u16),
+    Release(u16),
+}
+
+struct Keyboard {
+    path: PathBuf,
+    /// Owns the fd; events are read from it directly rather than through
+    /// the crate's buffered stream.
+    device: Device,
+    /// Watched keys currently held on this device, released if it goes away.
+    held: Vec<u16>,
+}
+
+pub struct KeyboardWatcher {
+    epoll: OwnedFd,
+    /// `None` when inotify is unavailable; devices are then only picked up
+    /// by `rescan`.
+    inotify: Option<OwnedFd>,
+    keyboards: HashMap<u64, Keyboard>,
+    next_token: u64,
+    watched_keys: Vec<u16>,
+}
+
+impl AsRawFd for KeyboardWatcher {
+    /// The epoll fd, readable whenever a device or the directory watch is.
+    fn as_raw_fd(&self) -> RawFd {
+        self.epoll.as_raw_fd()
+    }
+}
+
+impl KeyboardWatcher {
+    /// Opens every keyboard currently present and starts watching for new
+    /// ones. Only `watched_keys` are reported.
+    pub fn open(watched_keys: &[u16]) -> Result<Self> {
+        // SAFETY: plain syscall; the returned fd is owned below.
+        let epoll = unsafe { libc::epoll_create1(libc::EPOLL_CLOEXEC) };
+        if epoll < 0 {
+            return Err(Error::last_os_error());
+        }
+        let mut watcher = Self {
+            // SAFETY: `epoll` is a fresh fd nothing else owns.
+            epoll: unsafe { OwnedFd::from_raw_fd(epoll) },
+            inotify: None,
+            keyboards: HashMap::new(),
+            next_token: INOTIFY_TOKEN + 1,
+            watched_keys: watched_keys.to_vec(),
+        };
+        match open_inotify() {
+            Ok(inotify) => {
+                watcher.register(inotify.as_raw_fd(), INOTIFY_TOKEN)?;
+                watcher.inotify = Some(inotify);
+            }
+            Err(e) => warn!(
+                "evdev: cannot watch {} for hotplug, new keyboards need a rebind: {}",
+                INPUT_DIR, e
+            ),
+        }
+        watcher.rescan()?;
+        Ok(watcher)
+    }
+
+    pub fn keyboard_count(&self) -> usize {
+        self.keyboards.len()
+    }
+
+    /// Changes the reported keys in place, re-filtering every open device.
+    pub fn set_watched_keys(&mut self, watched_keys: &[u16]) {
+        self.watched_keys = watched_keys.to_vec();
+        for keyboard in self.keyboards.values_mut() {
+            keyboard.held.retain(|code| watched_keys.contains(code));
+            apply_key_mask(&keyboard.device, &keyboard.path, watched_keys);
+        }
+    }
+
+    /// Adds keyboards that are present but not open yet, e.g. after the
+    /// user gained access to `/dev/input`. Returns how many were added.
+    pub fn rescan(&mut self) -> Result<usize> {
+        let entries = read_input_dir()?;
+        let before = self.keyboards.len();
+        for entry in entries.flatten() {
+            self.try_add(&entry.path());
+        }
+        Ok(self.keyboards.len() - before)
+    }
+
+    /// Handles whatever is ready without blocking, appending key events to
+    /// `events`. Returns false once nothing was ready, so a caller driving
+    /// the fd from an event loop knows to wait for readiness again.
+    pub fn drain(&mut self, events: &mut Vec<KeyEvent>) -> Result<bool> {
+        let mut ready = [libc::epoll_event { events: 0, u64: 0 }; READY_BATCH];
+        // SAFETY: `ready` holds READY_BATCH entries.
+        let count = unsafe {
+            libc::epoll_wait(
+                self.epoll.as_raw_fd(),
+                ready.as_mut_ptr(),
+                READY_BATCH as libc::c_int,
+                0,
+            )
+        };
+        if count < 0 {
+            let e = Error::last_os_error();
+            return if e.kind() == ErrorKind::Interrupted {
+                Ok(true)
+            } else {
+                Err(e)
+            };
+        }
+        for entry in &ready[..count as usize] {
+            let token = entry.u64;
+            if token == INOTIFY_TOKEN {
+                self.read_hotplug_events(events);
+            } else {
+                self.read_key_events(token, events);
+            }
+        }
+        Ok(count > 0)
+    }
+
+    fn register(&self, fd: RawFd, token: u64) -> Result<()> {
+        let mut event = libc::epoll_event {
+            events: libc::EPOLLIN as u32,
+            u64: token,
+        };
+        // SAFETY: both fds are open; `event` outlives the call.
+        if unsafe { libc::epoll_ctl(self.epoll.as_raw_fd(), libc::EPOLL_CTL_ADD, fd, &mut event) }
+            < 0
+        {
+            return Err(Error::last_os_error());
+        }
+        Ok(())
+    }
+
+    fn try_add(&mut self, path: &Path) {
+        if !is_event_node(path) || self.keyboards.values().any(|kb| kb.path == path) {
+            return;
+        }
+        let device = match Device::open(path) {
+            Ok(device) => device,
+            Err(e) => {
+                debug!("evdev: cannot open {:?}: {}", path, e);
+                return;
+            }
+        };
+        if !is_keyboard(&device) {
+            return;
+        }
+        let fd = device.as_raw_fd();
+        // SAFETY: `fd` belongs to `device`, which stays open while registered.
+        let flags = unsafe { libc::fcntl(fd, libc::F_GETFL) };
+        if flags < 0 || unsafe { libc::fcntl(fd, libc::F_SETFL, flags | libc::O_NONBLOCK) } < 0 {
+            warn!(
+                "evdev: cannot make {:?} non-blocking: {}",
+                path,
+                Error::last_os_error()
+            );
+            return;
+        }
+        apply_key_mask(&device, path, &self.watched_keys);
+        let token = self.next_token;
+        if let Err(e) = self.register(fd, token) {
+            warn!("evdev: cannot poll {:?}: {}", path, e);
+            return;
+        }
+        self.next_token += 1;
+        info!(
+            "evdev: found keyboard device {:?} ({})",
+            path,
+            device.name().unwrap_or("unknown")
+        );
+        self.keyboards.insert(
+            token,
+            Keyboard {
+                path: path.to_path_buf(),
+                device,
+                held: Vec::new(),
+            },
+        );
+    }
+
+    /// Closing the fd also drops it from the epoll set.
+    fn remove(&mut self, token: u64, events: &mut Vec<KeyEvent>) {
+        if let Some(keyboard) = self.keyboards.remove(&token) {
+            info!("evdev: keyboard device {:?} removed", keyboard.path);
+            events.extend(keyboard.held.into_iter().map(KeyEvent::Release));
+        }
+    }
+
+    fn read_key_events(&mut self, token: u64, events: &mut Vec<KeyEvent>) {
+        let Some(keyboard) = self.keyboards.get_mut(&token) else {
+            return;
+        };
+        // SAFETY: input_event is plain data.
+        let mut buffer: [libc::input_event; READ_BATCH] = unsafe { std::mem::zeroed() };
+        loop {
+            // SAFETY: the buffer is READ_BATCH events long.
+            let bytes = unsafe {
+                libc::read(
+                    keyboard.device.as_raw_fd(),
+                    buffer.as_mut_ptr().cast(),
+                    std::mem::size_of_val(&buffer),
+                )
+            };
+            if bytes < 0 {
+                let e = Error::last_os_error();
+                match e.kind() {
+                    ErrorKind::WouldBlock => return,
+                    ErrorKind::Interrupted => continue,
+                    _ => {
+                        // ENODEV once the device is unplugged.
+                        debug!("evdev: read from {:?} failed: {}", keyboard.path, e);
+                        self.remove(token, events);
+                        return;
+                    }
+                }
+            }
+            let count = bytes as usize / std::mem::size_of::<libc::input_event>();
+            if count == 0 {
+                return;
+            }
+            for event in &buffer[..count] {
+                if event.type_ == EV_SYN && event.code == SYN_DROPPED {
+                    // The kernel dropped events; forget held keys rather than
+                    // report a modifier that may have been released.
+                    events.extend(keyboard.held.drain(..).map(KeyEvent::Release));
+                    continue;
+                }
+                if event.type_ != EV_KEY || !self.watched_keys.contains(&event.code) {
+                    continue;
+                }
+                match event.value {
+                    1 => {
+                        if !keyboard.held.contains(&event.code) {
+                            keyboard.held.push(event.code);
+                        }
+                        events.push(KeyEvent::Press(event.code));
+                    }
+                    0 => {
+                        keyboard.held.retain(|code| *code != event.code);
+                        events.push(KeyEvent::Release(event.code));
+                    }
+                    // Autorepeat never toggles.
+                    _ => {}
+                }
+            }
+        }
+    }
+
+    fn read_hotplug_events(&mut self, events: &mut Vec<KeyEvent>) {
+        let Some(inotify) = self.inotify.as_ref().map(AsRawFd::as_raw_fd) else {
+            return;
+        };
+        // u64 storage keeps the inotify_event headers aligned.
+        let mut buffer = [0_u64; 512];
+        let header_len = std::mem::size_of::<libc::inotify_event>();
+        let mut rescan = false;
+        loop {
+            // SAFETY: the buffer is valid for its full byte length.
+            let bytes = unsafe {
+                libc::read(
+                    inotify,
+                    buffer.as_mut_ptr().cast(),
+                    std::mem::size_of_val(&buffer),
+                )
+            };
+            if bytes <= 0 {
+                break;
+            }
+            let bytes = bytes as usize;
+            let base = buffer.as_ptr().cast::<u8>();
+            let mut offset = 0;
+            while offset + header_len <= bytes {
+                // SAFETY: the kernel writes whole records within `bytes`.
+                let header: libc::inotify_event =
+                    unsafe { std::ptr::read_unaligned(base.add(offset).cast()) };
+                let name_len = header.len as usize;
+                // SAFETY: the name follows the header inside the same record.
+                let name =
+                    unsafe { std::slice::from_raw_parts(base.add(offset + header_len), name_len) };
+                offset += header_len + name_len;
+
+                if header.mask & libc::IN_Q_OVERFLOW != 0 {
+                    rescan = true;
+                    continue;
+                }
+                let name = name.split(|byte| *byte == 0).next().unwrap_or_default();
+                let path = Path::new(INPUT_DIR).join(std::ffi::OsStr::from_bytes(name));
+                if header.mask & libc::IN_DELETE != 0 {
+                    if let Some(token) = self
+                        .keyboards
+                        .iter()
+                        .find_map(|(token, kb)| (kb.path == path).then_some(*token))
+                    {
+                        self.remove(token, events);
+                    }
+                } else {
+                    // IN_ATTRIB covers udev granting access after creation.
+                    self.try_add(&path);
+                }
+            }
+        }
+        if rescan {
+            if let Err(e) = self.rescan() {
+                warn!("evdev: rescan after inotify overflow failed: {}", e);
+            }
+        }
+    }
+}
+
+fn open_inotify() -> Result<OwnedFd> {
+    // SAFETY: plain syscall; the returned fd is owned below.
+    let fd = unsafe { libc::inotify_init1(libc::IN_NONBLOCK | libc::IN_CLOEXEC) };
+    if fd < 0 {
+        return Err(Error::last_os_error());
+    }
+    // SAFETY: `fd` is a fresh fd nothing else owns.
+    let inotify = unsafe { OwnedFd::from_raw_fd(fd) };
+    let dir = CString::new(INPUT_DIR).expect("path has no NUL");
+    // SAFETY: both arguments are valid for the call.
+    let watch = unsafe {
+        libc::inotify_add_watch(
+            fd,
+            dir.as_ptr(),
+            libc::IN_CREATE | libc::IN_ATTRIB | libc::IN_DELETE,
+        )
+    };
+    if watch < 0 {
+        return Err(Error::last_os_error());
+    }
+    Ok(inotify)
+}
+
+/// Tells the kernel to queue only `keys` for this reader. Older kernels
+/// without `EVIOCSMASK` keep delivering everything, which `drain` filters.
+fn apply_key_mask(device: &Device, path: &Path, keys: &[u16]) {
+    let key_bits = key_mask_bits(keys);
+    let masks = std::iter::once((EV_KEY as u32, &key_bits[..]))
+        .chain(NON_KEY_EVENT_TYPES.iter().map(|kind| (*kind, &[][..])));
+    for (kind, bits) in masks {
+        let mask = libc::input_mask {
+            type_: kind,
+            codes_size: bits.len() as u32,
+            codes_ptr: bits.as_ptr() as u64,
+        };
+        // SAFETY: `mask` and the bitmap it points to outlive the call.
+        if unsafe { libc::ioctl(device.as_raw_fd(), EVIOCSMASK, &mask) } < 0 {
+            debug!(
+                "evdev: kernel event filter unavailable for {:?} (type {:#x}): {}",
+                path,
+                kind,
+                Error::last_os_error()
+            );
+            return;
+        }
+    }
+}
+
+/// Bitmap in the kernel's layout: bit `code % 8` of byte `code / 8`.
+fn key_mask_bits(keys: &[u16]) -> [u8; KEY_CNT / 8] {
+    let mut bits = [0_u8; KEY_CNT / 8];
+    for key in keys {
+        if let Some(byte) = bits.get_mut(*key as usize / 8) {
+            *byte |= 1 << (key % 8);
+        }
+    }
+    bits
+}
+
+fn read_input_dir() -> Result<std::fs::ReadDir> {
+    std::fs::read_dir(INPUT_DIR).map_err(|e| {
+        Error::new(
+            e.kind(),
+            format!(
+                "Cannot read {}: {}. You may need to add your user to the 'input' group.",
+                INPUT_DIR, e
+            ),
+        )
+    })
+}
+
+fn is_event_node(path: &Path) -> bool {
+    path.file_name()
+        .is_some_and(|name| name.as_bytes().starts_with(b"event"))
+}
+
+/// A real keyboard reports keys and has letter keys.
+fn is_keyboard(device: &Device) -> bool {
+    device.supported_events().contains(EventType::KEY)
+        && device.supported_keys().is_some_and(|keys| {
+            keys.contains(evdev::Key::KEY_A)
+                && keys.contains(evdev::Key::KEY_Z)
+                && keys.contains(evdev::Key::KEY_SPACE)
+        })
+}
+
+/// Lists the keyboards that can be opened right now.
+pub fn find_keyboard_devices() -> Result<Vec<PathBuf>> {
+    let entries = read_input_dir()?;
+    Ok(entries
+        .flatten()
+        .map(|entry| entry.path())
+        .filter(|path| is_event_node(path))
+        .filter(|path| Device::open(path).is_ok_and(|device| is_keyboard(&device)))
+        .collect())
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn key_mask_sets_only_requested_bits() {
+        // KEY_LEFTCTRL (29) and KEY_SPACE (57); out-of-range codes are ignored.
+        let bits = key_mask_bits(&[29, 57, KEY_CNT as u16]);
+        assert_eq!(bits[3], 1 << 5);
+        assert_eq!(bits[7], 1 << 1);
+        assert_eq!(bits.iter().map(|byte| byte.count_ones()).sum::<u32>(), 2);
+    }
+}
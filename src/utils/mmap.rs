@@ -0,0 +1,212 @@
+//! Read-only memory mappings of on-disk files.
+//!
+//! Model files are mapped with `MAP_SHARED` so their pages live in the kernel
+//! page cache, which is shared with other processes and survives daemon
+//! restarts. Keeping the mapping alive while a model is loaded makes those
+//! pages less likely to be evicted, and `mincore` lets us report how much of a
+//! model is actually resident.
+
+use std::fs::File;
+use std::io::{Error, ErrorKind, Result};
+use std::os::unix::io::AsRawFd;
+use std::path::{Path, PathBuf};
+
+#[derive(Clone, Copy, Debug, PartialEq, Eq)]
+pub enum Advice {
+    Normal,
+    Sequential,
+    Random,
+    WillNeed,
+}
+
+impl Advice {
+    fn as_raw(self) -> libc::c_int {
+        match self {
+            Advice::Normal => libc::MADV_NORMAL,
+            Advice::Sequential => libc::MADV_SEQUENTIAL,
+            Advice::Random => libc::MADV_RANDOM,
+            Advice::WillNeed => libc::MADV_WILLNEED,
+        }
+    }
+}
+
+pub struct MappedFile {
+    ptr: *mut libc::c_void,
+    len: usize,
+    path: PathBuf,
+}
+
+// SAFETY: the mapping is read-only and owned exclusively by this value.
+unsafe impl Send for MappedFile {}
+unsafe impl Sync for MappedFile {}
+
+impl MappedFile {
+    pub fn open_readonly(path: &Path) -> Result<Self> {
+        let file = File::open(path)?;
+        let len = file.metadata()?.len() as usize;
+        if len == 0 {
+            return Err(Error::new(
+                ErrorKind::InvalidInput,
+                format!("Cannot map empty file {}", path.display()),
+            ));
+        }
+
+        // SAFETY: mapping a regular file read-only; the fd may be closed after.
+        let ptr = unsafe {
+            libc::mmap(
+                std::ptr::null_mut(),
+                len,
+                libc::PROT_READ,
+                libc::MAP_SHARED,
+                file.as_raw_fd(),
+                0,
+            )
+        };
+        if ptr == libc::MAP_FAILED {
+            return Err(Error::last_os_error());
+        }
+
+        Ok(Self {
+            ptr,
+            len,
+            path: path.to_path_buf(),
+        })
+    }
+
+    pub fn len(&self) -> usize {
+        self.len
+    }
+
+    pub fn is_empty(&self) -> bool {
+        self.len == 0
+    }
+
+    pub fn path(&self) -> &Path {
+        &self.path
+    }
+
+    pub fn as_slice(&self) -> &[u8] {
+        // SAFETY: `ptr` is a live PROT_READ mapping of `len` bytes.
+        unsafe { std::slice::from_raw_parts(self.ptr as *const u8, self.len) }
+    }
+
+    pub fn advise(&self, advice: Advice) -> Result<()> {
+        // SAFETY: the range is exactly the mapping we own.
+        let rc = unsafe { libc::madvise(self.ptr, self.len, advice.as_raw()) };
+        if rc != 0 {
+            return Err(Error::last_os_error());
+        }
+        Ok(())
+    }
+
+    /// Bytes of the file currently held in the page cache.
+    pub fn resident_bytes(&self) -> Result<usize> {
+        let page = page_size();
+        let pages = self.len.div_ceil(page);
+        let mut residency = vec![0u8; pages];
+        // SAFETY: `residency` has one byte per page of the mapping.
+        let rc = unsafe { libc::mincore(self.ptr, self.len, residency.as_mut_ptr()) };
+        if rc != 0 {
+            return Err(Error::last_os_error());
+        }
+        let resident_pages = residency.iter().filter(|&&b| b & 1 != 0).count();
+        Ok((resident_pages * page).min(self.len))
+    }
+}
+
+impl Drop for MappedFile {
+    fn drop(&mut self) {
+        // SAFETY: unmapping the mapping created in `open_readonly`.
+        unsafe {
+            libc::munmap(self.ptr, self.len);
+        }
+    }
+}
+
+fn page_size() -> usize {
+    // SAFETY: sysconf has no preconditions.
+    let size = unsafe { libc::sysconf(libc::_SC_PAGESIZE) };
+    if size > 0 {
+        size as usize
+    } else {
+        4096
+    }
+}
+
+/// All regular files of a model (a single file or a model directory).
+#[derive(Default)]
+pub struct MappedFiles {
+    files: Vec<MappedFile>,
+}
+
+impl MappedFiles {
+    /// Maps every non-empty regular file under `path` read-only.
+    pub fn open(path: &Path) -> Result<Self> {
+        let mut files = Vec::new();
+        Self::collect(path, &mut files)?;
+        Ok(Self { files })
+    }
+
+    fn collect(path: &Path, files: &mut Vec<MappedFile>) -> Result<()> {
+        let metadata = std::fs::metadata(path)?;
+        if metadata.is_dir() {
+            for entry in std::fs::read_dir(path)? {
+                Self::collect(&entry?.path(), files)?;
+            }
+        } else if metadata.is_file() && metadata.len() > 0 {
+            files.push(MappedFile::open_readonly(path)?);
+        }
+        Ok(())
+    }
+
+    pub fn advise(&self, advice: Advice) {
+        for file in &self.files {
+            if let Err(e) = file.advise(advice) {
+                log::debug!(
+                    "madvise({:?}) failed for {}: {}",
+                    advice,
+                    file.path().display(),
+                    e
+                );
+            }
+        }
+    }
+
+    pub fn mapped_bytes(&self) -> u64 {
+        self.files.iter().map(|f| f.len() as u64).sum()
+    }
+
+    pub fn resident_bytes(&self) -> u64 {
+        self.files
+            .iter()
+            .filter_map(|f| f.resident_bytes().ok())
+            .map(|bytes| bytes as u64)
+            .sum()
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn mapped_files_report_sizes_and_contents() {
+        let dir = std::env::temp_dir().join(format!("dikt-mmap-test-{}", std::process::id()));
+        std::fs::create_dir_all(dir.join("nested")).unwrap();
+        std::fs::write(dir.join("a.bin"), vec![7u8; 10_000]).unwrap();
+        std::fs::write(dir.join("nested").join("b.bin"), b"hello").unwrap();
+        std::fs::write(dir.join("empty.bin"), b"").unwrap();
+
+        let mapped = MappedFiles::open(&dir).unwrap();
+        mapped.advise(Advice::WillNeed);
+        assert_eq!(mapped.files.len(), 2);
+        assert_eq!(mapped.mapped_bytes(), 10_005);
+
+        let single = MappedFile::open_readonly(&dir.join("nested").join("b.bin")).unwrap();
+        assert_eq!(single.as_slice(), b"hello");
+        // Just written and read back, so the page must be cached.
+        assert_eq!(single.resident_bytes().unwrap(), 5);
+
+        std::fs::remove_dir_all(&dir).unwrap();
+    }
+}
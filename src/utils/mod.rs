@@ -1,2 +1,5 @@
+pub mod executor;
+pub mod input_devices;
 pub mod launch;
 pub mod logging;
+pub mod mmap;